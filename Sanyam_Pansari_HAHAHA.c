@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 /*
 ================================================================================
           COMPREHENSIVE STUDENT MANAGEMENT AND ANALYTICS SYSTEM
@@ -19,6 +21,30 @@ Features:
   - Search and filter capabilities
   - Statistical analysis
   - Export and import functionality
+  - Batch command mode for bulk loads (--batch FILE, or - for stdin)
+  - Binary snapshots, memory-mapped at startup (--snapshot FILE)
+  - Write-ahead journal with group commit, replayed at startup (--journal FILE)
+  - Streaming CSV and JSON Lines export to a file or stdout
+  - Lock-free in-memory log ring with a background, rotating log file writer
+  - Multi-threaded TCP server mode with per-entity locking (--serve PORT)
+  - Lock-free seat reservation with per-course waitlists and drops
+  - Bulk enrollment and grade import grouped by course (bulk-enroll, bulk-grade)
+  - Parallel term reports of every student's GPA and every course's grades
+  - Credit-weighted GPA kept as a per-student cache; dean's list queries
+  - Per-course grade histograms for letter distribution and percentiles
+  - Benchmark mode (--bench) with synthetic data and latency percentiles
+  - Per-thread operation metrics with latency histograms and a Prometheus dump
+  - Buffered rendering of large listings with --page/--limit pagination
+  - Interned majors and course codes with a per-major GPA report
+  - Per-assessment grade records (Quiz/Assignment/Midterm/Final) with a weighted final grade
+  - Ranked views (top GPAs, fullest courses, students by name) by bounded heap selection
+  - Sharding by student ID range (--shard I/N) with a scatter-gather coordinator (--coordinate)
+  - Term-based cold archive of completed and dropped enrollments in compressed columnar segments
+  - Background snapshots and exports from a forked copy-on-write view, with progress (jobs)
+
+Build:
+  gcc -O2 -march=native -pthread -o sms Sanyam_Pansari_HAHAHA.c -lm
+  (-march=native enables the AVX2/NEON report kernels; SSE2 is the x86-64 default)
 
 ================================================================================
 */
@@ -26,27 +52,61 @@ Features:
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <time.h>
 #include <math.h>
+#include <float.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 /* ============================================================================
    CONSTANTS AND DEFINITIONS
    ============================================================================ */
 
-#define MAX_STUDENTS 500
-#define MAX_COURSES 100
-#define MAX_ENROLLMENTS 5000
 #define MAX_NAME_LENGTH 100
+#define NAME_KEY_LENGTH 32
 #define MAX_COURSE_CODE 20
 #define MAX_DESCRIPTION 500
-#define MAX_LOG_ENTRIES 10000
 #define FILE_BUFFER_SIZE 4096
-#define MAX_GRADES 20
 #define MIN_GPA 0.0f
 #define MAX_GPA 4.0f
 #define MIN_GRADE 0
 #define MAX_GRADE 100
+#define GRADE_HISTOGRAM_BUCKETS (MAX_GRADE - MIN_GRADE + 1)
+
+/* Assessment types; assessment_weights holds each type's share of the final grade */
+#define ASSESSMENT_QUIZ 0
+#define ASSESSMENT_ASSIGNMENT 1
+#define ASSESSMENT_MIDTERM 2
+#define ASSESSMENT_FINAL 3
+#define ASSESSMENT_TYPE_COUNT 4
+
+/* Record IDs are assigned densely from these bases in insertion order */
+#define FIRST_STUDENT_ID 1001
+#define FIRST_COURSE_ID 5001
+#define FIRST_ENROLLMENT_ID 7001
+#define FIRST_ASSESSMENT_ID 9001
 
 /* Grade boundaries */
 #define GRADE_A_MIN 90
@@ -61,69 +121,436 @@ Features:
 #define LOG_ERROR 3
 #define LOG_SUCCESS 4
 
+/* Logged operations, named by log_operation_names */
+#define LOG_OP_SYSTEM_INIT 0
+#define LOG_OP_SYSTEM_SHUTDOWN 1
+#define LOG_OP_MENU 2
+#define LOG_OP_ADD_STUDENT 3
+#define LOG_OP_DISPLAY_STUDENT 4
+#define LOG_OP_ADD_COURSE 5
+#define LOG_OP_DISPLAY_COURSE 6
+#define LOG_OP_ENROLLMENT 7
+#define LOG_OP_RECORD_GRADE 8
+#define LOG_OP_EXPORT_DATA 9
+#define LOG_OP_STREAM_EXPORT 10
+#define LOG_OP_SAVE_SNAPSHOT 11
+#define LOG_OP_LOAD_SNAPSHOT 12
+#define LOG_OP_JOURNAL 13
+#define LOG_OP_JOURNAL_REPLAY 14
+#define LOG_OP_BATCH 15
+#define LOG_OP_SERVER 16
+#define LOG_OP_DROP_ENROLLMENT 17
+#define LOG_OP_REPORT 18
+#define LOG_OP_METRICS 19
+#define LOG_OP_ARCHIVE 20
+#define LOG_OP_BACKGROUND 21
+#define LOG_OP_COUNT 22
+
+/* Log ring: the newest LOG_RING_SIZE entries stay in memory */
+#define LOG_RING_SIZE 16384
+#define LOG_DETAILS_SIZE 172
+#define DEFAULT_LOG_PATH "system.log"
+#define LOG_FLUSH_INTERVAL_MS 200
+#define LOG_ROTATE_BYTES (8 << 20)
+#define LOG_ROTATE_KEEP 3
+#define LOG_LEVEL_COUNT 5 /* levels are 1..4; slot 0 is unused */
+#define LOG_QUERY_DEFAULT_LIMIT 50
+#define LOG_QUERY_SLACK 64 /* positions a time search widens by; see log_query */
+
+/* Listings: buffered rendering and --page/--limit pagination */
+#define RENDER_BUFFER_SIZE (1 << 20)
+#define MAX_SEPARATOR_LENGTH 160
+#define LIST_DEFAULT_PAGE_SIZE 50
+
+/* Record storage: tables grow in fixed-size chunks carved from arena blocks */
+#define ARENA_BLOCK_SIZE (4 * 1024 * 1024)
+#define ARENA_ALIGNMENT 64
+#define TABLE_CHUNK_SHIFT 10
+#define TABLE_CHUNK_SIZE (1 << TABLE_CHUNK_SHIFT)
+#define TABLE_MAX_CHUNKS 65536
+
+/* Enrollment value columns that the aggregation kernels can reduce */
+#define COLUMN_GRADE 0
+#define COLUMN_CREDIT_POINTS 1
+
+/* Operation result codes returned by the record operations */
+#define RESULT_OK 0
+#define RESULT_OUT_OF_MEMORY 1
+#define RESULT_STUDENT_NOT_FOUND 2
+#define RESULT_COURSE_NOT_FOUND 3
+#define RESULT_COURSE_FULL 4
+#define RESULT_ALREADY_ENROLLED 5
+#define RESULT_ENROLLMENT_NOT_FOUND 6
+#define RESULT_INVALID_GRADE 7
+#define RESULT_WAITLISTED 8
+#define RESULT_NOT_SEATED 9
+#define RESULT_CANNOT_DROP 10
+#define RESULT_INVALID_ASSESSMENT 11
+#define RESULT_INVALID_TERM 12
+#define RESULT_ENROLLMENT_ARCHIVED 13
+#define RESULT_SNAPSHOT_RUNNING 14
+#define RESULT_TOO_MANY_JOBS 15
+#define RESULT_NO_ASSESSMENTS 16
+
+/* Batch mode */
+#define MAX_BATCH_FIELDS 8
+#define BATCH_READ_SIZE (1 << 20) /* longer lines are split, as fgets would */
+
+/* Binary snapshot format */
+#define SNAPSHOT_MAGIC "SMSSNAP"
+#define SNAPSHOT_VERSION 10
+#define SNAPSHOT_ALIGNMENT 4096
+#define DEFAULT_SNAPSHOT_PATH "system_snapshot.bin"
+#define SNAPSHOT_STUDENTS 0
+#define SNAPSHOT_STUDENT_PROFILES 1
+#define SNAPSHOT_COURSES 2
+#define SNAPSHOT_COURSE_DETAILS 3
+#define SNAPSHOT_ENROLLMENTS 4
+#define SNAPSHOT_ENROLLMENT_COLUMNS 5
+#define SNAPSHOT_STRINGS 6
+#define SNAPSHOT_ASSESSMENTS 7
+#define SNAPSHOT_ARCHIVE 8
+#define SNAPSHOT_SECTION_COUNT 9
+
+/* Write-ahead journal */
+#define JOURNAL_MAGIC "SMSJRNL"
+#define JOURNAL_VERSION 1
+#define DEFAULT_JOURNAL_PATH "system_journal.bin"
+#define JOURNAL_BUFFER_SIZE 65536
+#define DEFAULT_SYNC_INTERVAL_MS 50
+#define DEFAULT_SYNC_RECORDS 512
+#define JOURNAL_ADD_STUDENT 1
+#define JOURNAL_ADD_COURSE 2
+#define JOURNAL_ENROLL 3
+#define JOURNAL_GRADE 4
+#define JOURNAL_DROP 5
+#define JOURNAL_ASSESSMENT 6
+#define JOURNAL_ARCHIVE 7
+
+/* Streaming export */
+#define EXPORT_CSV 0
+#define EXPORT_JSONL 1
+#define EXPORT_STUDENTS 1
+#define EXPORT_COURSES 2
+#define EXPORT_ENROLLMENTS 4
+#define EXPORT_ALL (EXPORT_STUDENTS | EXPORT_COURSES | EXPORT_ENROLLMENTS)
+#define DEFAULT_EXPORT_BUFFER_SIZE (4 << 20)
+#define MIN_EXPORT_BUFFER_SIZE (64 << 10)
+#define EXPORT_FIELD_RESERVE 64 /* room for any number and separators */
+#define DEFAULT_EXPORT_PATH "system_export.txt"
+
+/* Background jobs: snapshots and exports written by a forked child */
+#define MAX_BACKGROUND_JOBS 8
+#define JOB_SNAPSHOT 0
+#define JOB_EXPORT 1
+#define JOB_TEXT_EXPORT 2
+#define JOB_IDLE 0
+#define JOB_RUNNING 1
+#define JOB_SUCCEEDED 2
+#define JOB_FAILED 3
+#define JOB_CLOSE_FD_LIMIT 65536 /* descriptors closed in the child */
+
+/* Name search: trigram index over case-folded names */
+#define TRIGRAM_CHAR_BITS 6
+#define TRIGRAM_COUNT (1 << (3 * TRIGRAM_CHAR_BITS))
+#define TRIGRAM_BOUNDARY 0 /* pads the start of a name so prefixes of any length are indexed */
+#define SEARCH_PREFIX 1
+#define SEARCH_IGNORE_CASE 2
+#define SEARCH_DEFAULT_LIMIT 50
+#define SEARCH_MAX_LIMIT 1000
+
+/* Concurrency: per-entity lock shards and the server worker pool */
+#define LOCK_SHARDS 64
+#define DEFAULT_SERVER_WORKERS 8
+#define MAX_SERVER_WORKERS 64
+#define SERVER_BACKLOG 128
+#define SESSION_QUEUE_SIZE 256
+#define SERVER_POLL_MS 200
+#define DEFAULT_BIND_ADDRESS "127.0.0.1"
+
+/* Sharding: shard i assigns student, enrollment and assessment IDs from
+   its base + i * SHARD_ID_SPAN, so an ID alone names its shard */
+#define MAX_SHARDS 16
+#define SHARD_ID_SPAN 100000000
+
+/* Cold archive: completed and dropped enrollments of ended terms, packed
+   into immutable segments. A term is a half year: spring runs January to
+   June and fall July to December, both in UTC; term numbers are year * 2 + half. */
+#define TERM_SPRING 0
+#define TERM_FALL 1
+#define ARCHIVE_BLOCK_ROWS 128 /* rows per entry of a segment's student skip table */
+#define ARCHIVE_GRADE_BITS 14  /* grades in hundredths of a point, 0 to 10000 */
+#define ARCHIVE_RAW_GRADE_BITS 32
+
+/* Term reports: enrollment rows are split across threads in table chunks */
+#define REPORT_MAX_THREADS 32
+#define REPORT_STUDENTS 1
+#define REPORT_COURSES 2
+#define REPORT_ALL (REPORT_STUDENTS | REPORT_COURSES)
+#define DEANS_LIST_MIN_GPA 3.5f
+#define DEANS_LIST_MIN_CREDITS 12
+#define TOP_K_DEFAULT 50
+
+/* Benchmark mode: calls per timed read operation */
+#define BENCH_SEARCH_QUERIES 10000
+#define BENCH_STATS_CALLS 10000
+#define BENCH_EXPORT_RUNS 3
+
+/* Registration storm: every virtual student makes STORM_OPS_PER_STUDENT
+   requests, enrollments into Zipf-distributed courses unless the roll picks
+   a grade or a class statistics read */
+#define STORM_MAX_THREADS 64
+#define STORM_OPS_PER_STUDENT 8
+#define STORM_GRADE_PERCENT 20
+#define STORM_STATS_PERCENT 10
+#define STORM_ZIPF_EXPONENT 1.1
+#define STORM_ENROLL 0
+#define STORM_GRADE 1
+#define STORM_STATS 2
+#define STORM_KINDS 3
+
+/* Instrumented operations; latency histograms keep 2^METRIC_SUB_BITS
+   buckets per power of two of nanoseconds, about 12% resolution */
+#define METRIC_ADD_STUDENT 0
+#define METRIC_ENROLL 1
+#define METRIC_GRADE 2
+#define METRIC_NAME_SEARCH 3
+#define METRIC_CLASS_STATS 4
+#define METRIC_DEANS_LIST 5
+#define METRIC_TERM_REPORT 6
+#define METRIC_EXPORT 7
+#define METRIC_COUNT 8
+#define METRIC_SUB_BITS 3
+#define METRIC_SUB_BUCKETS (1 << METRIC_SUB_BITS)
+#define METRIC_GROUPS 41 /* latencies up to 2^43 ns, about 2.4 hours */
+#define METRIC_BUCKETS (METRIC_SUB_BUCKETS * METRIC_GROUPS)
+#define METRIC_PROMETHEUS_MIN_SHIFT 10 /* Prometheus buckets from 2^10 ns ... */
+#define METRIC_PROMETHEUS_MAX_SHIFT 34 /* ... to 2^34 ns, about 17 s */
+
+/* Contention counters, kept per thread like the metrics: waits for an
+   entity lock held by another thread, and failed seat compare-and-swaps */
+#define CONTENTION_STUDENT_LOCK 0
+#define CONTENTION_COURSE_LOCK 1
+#define CONTENTION_SEAT_RETRY 2
+#define CONTENTION_COUNT 3
+
+/* Hash index sizing */
+#define ID_INDEX_INITIAL_CAPACITY 64
+
+/* String interning: majors, course codes and assessment types */
+#define INTERN_INITIAL_CAPACITY 64
+#define INTERN_BLOCK_SIZE (64 * 1024)
+#define INTERN_MAX_LENGTH 255 /* fits the one-byte length prefix */
+
 /* ============================================================================
    DATA STRUCTURES
    ============================================================================ */
 
 /**
- * Course structure to store course information
+ * Course structure holding the fields used by enrollment and listings
  */
 typedef struct {
     int course_id;
-    char course_code[MAX_COURSE_CODE];
-    char course_name[MAX_NAME_LENGTH];
-    char description[MAX_DESCRIPTION];
+    int code_id;    /* interned course code */
     int credits;
     int max_capacity;
-    int current_enrollment;
+    _Atomic int current_enrollment; /* seats taken; claimed with compare-and-swap */
     float difficulty_level;
-    time_t created_date;
+    int first_enrollment; /* head of this course's enrollment list, -1 if empty */
+    int last_enrollment;
+    _Atomic int waitlist_count;
+    int waitlist_head;      /* oldest waitlisted enrollment, -1 if none */
+    double grade_sum;       /* running aggregates over completed enrollments */
+    int graded_count;
+    float grade_min;
+    float grade_max;
+    int grade_bounds_stale; /* set when a regrade replaced the current min or max */
+    float archived_grade_min; /* bounds of the completed grades moved to the archive */
+    float archived_grade_max;
+    int archived_graded;
 } Course;
 
 /**
- * Student structure to store student information
+ * Course text fields, stored apart from Course and read only for display
+ */
+typedef struct {
+    char course_name[MAX_NAME_LENGTH];
+    char description[MAX_DESCRIPTION];
+    time_t created_date;
+} CourseDetails;
+
+/**
+ * Completed grades of one course counted in one-point buckets; bucket b
+ * holds grades in [b, b + 1), with MAX_GRADE in the last bucket
+ */
+typedef struct {
+    int buckets[GRADE_HISTOGRAM_BUCKETS];
+} GradeHistogram;
+
+/**
+ * Student structure holding the fields touched by scans and lookups
  */
 typedef struct {
     int student_id;
+    int is_active;
+    int major_id;   /* interned major */
+    char name_key[NAME_KEY_LENGTH]; /* leading bytes of the name, NUL-terminated */
+    int name_truncated;             /* set when the full name is longer than name_key */
+    int first_enrollment; /* head of this student's enrollment list, -1 if empty */
+    int last_enrollment;
+    double credit_points_total; /* running totals over completed enrollments */
+    int completed_courses;
+    int credits_completed;      /* cumulative GPA cache: credits and credit-weighted points */
+    double weighted_points_total;
+} Student;
+
+/**
+ * Student contact and profile fields, read only for display and export
+ */
+typedef struct {
     char name[MAX_NAME_LENGTH];
     char email[MAX_NAME_LENGTH];
     char phone[20];
     char address[MAX_DESCRIPTION];
     int admission_year;
-    char major[MAX_NAME_LENGTH];
     time_t registration_date;
-    int is_active;
-} Student;
+} StudentProfile;
+
+/**
+ * Enrollment structure to track student-course relationships. The fields
+ * scanned by reports live in EnrollmentColumns instead.
+ */
+typedef struct {
+    int enrollment_id;
+    char letter_grade;
+    time_t enrollment_date;
+    int next_student_enrollment; /* next enrollment of the same student, -1 at end */
+    int next_course_enrollment;  /* next enrollment in the same course, -1 at end */
+    int first_assessment;        /* this enrollment's GradeRecord list, -1 if empty */
+    int last_assessment;
+    float assessment_marks[ASSESSMENT_TYPE_COUNT];  /* marks obtained and possible, summed per type */
+    float assessment_totals[ASSESSMENT_TYPE_COUNT];
+} Enrollment;
+
+/**
+ * Columnar enrollment fields for one table chunk. Enrollment i is stored at
+ * slot table_slot(i) of block enrollment_columns[i >> TABLE_CHUNK_SHIFT].
+ */
+typedef struct {
+    int student_id[TABLE_CHUNK_SIZE];
+    int course_id[TABLE_CHUNK_SIZE];
+    int status[TABLE_CHUNK_SIZE]; /* 0: pending, 1: active, 2: completed, 3: dropped, 4: waitlisted */
+    float grade[TABLE_CHUNK_SIZE];
+    float credit_points[TABLE_CHUNK_SIZE];
+    int credits[TABLE_CHUNK_SIZE]; /* course credits, copied at enroll time */
+} EnrollmentColumns;
 
 /**
- * Enrollment structure to track student-course relationships
+ * Immutable archive segment holding the archived enrollments of one term,
+ * sorted by student and then enrollment ID. The header is followed in the
+ * same allocation by the student skip table, the student ID stream and the
+ * bit-packed columns; the column fields are byte offsets from the header.
+ * Student IDs are varint deltas from the previous row, restarting from the
+ * skip table every ARCHIVE_BLOCK_ROWS rows. The other columns store each
+ * value minus the segment minimum in the given number of bits.
+ */
+typedef struct {
+    uint32_t size;              /* bytes, header included; a multiple of 8 */
+    int32_t term;
+    int32_t row_count;
+    int32_t min_student_id;
+    int32_t max_student_id;
+    int32_t min_enrollment_id;
+    int32_t max_enrollment_id;
+    int32_t min_course_id;
+    int32_t min_credits;
+    int32_t reserved;
+    int64_t min_date;
+    uint8_t enrollment_id_bits;
+    uint8_t course_bits;
+    uint8_t credits_bits;
+    uint8_t grade_bits;         /* ARCHIVE_GRADE_BITS, or ARCHIVE_RAW_GRADE_BITS for float bit patterns */
+    uint8_t date_bits;
+    uint8_t padding[3];
+    uint32_t blocks;
+    uint32_t students;
+    uint32_t enrollment_ids;
+    uint32_t courses;
+    uint32_t credits;
+    uint32_t grades;
+    uint32_t dates;
+    uint32_t dropped;           /* one bit per row, set for dropped enrollments */
+} ArchiveSegment;
+
+/**
+ * Student skip table entry: the first student of a block of rows and where
+ * the deltas of the block's remaining rows start in the student stream
+ */
+typedef struct {
+    int32_t first_student_id;
+    uint32_t student_offset;
+} ArchiveBlock;
+
+/**
+ * One archived enrollment, decoded
  */
 typedef struct {
     int enrollment_id;
     int student_id;
     int course_id;
+    int credits;
+    int status; /* 2: completed, 3: dropped */
     float grade;
-    char letter_grade;
-    float credit_points;
     time_t enrollment_date;
-    int status; /* 0: pending, 1: active, 2: completed, 3: dropped */
-} Enrollment;
+} ArchivedEnrollment;
+
+/**
+ * Sequential reader over the rows of one archive segment
+ */
+typedef struct {
+    const ArchiveSegment *segment;
+    int row;                     /* next row to decode */
+    int student_id;              /* student of the last decoded row */
+    const uint8_t *student_bytes; /* next delta in the student stream */
+} ArchiveCursor;
+
+/**
+ * Enrollment chosen for archiving, ordered into segments by term and student
+ */
+typedef struct {
+    int term;
+    int student_id;
+    int enrollment_id;
+    int index;
+} ArchiveCandidate;
+
+/**
+ * Running sum, count, minimum and maximum produced by the column kernels
+ */
+typedef struct {
+    double sum;
+    int count;
+    float min;
+    float max;
+} ColumnAggregate;
 
 /**
- * Grade record for tracking individual assessments
+ * Grade record for one assessment. The records of an enrollment are linked
+ * in arrival order.
  */
 typedef struct {
     int assessment_id;
     int enrollment_id;
-    char assessment_type[50]; /* Quiz, Midterm, Final, Assignment */
+    int assessment_type_id; /* interned: Quiz, Midterm, Final, Assignment */
     float marks_obtained;
     float total_marks;
     float percentage;
     time_t assessment_date;
+    int next_assessment; /* next record of the same enrollment, -1 at end */
 } GradeRecord;
 
 /**
- * System statistics and analytics
+ * System statistics and analytics, maintained incrementally by mutations
  */
 typedef struct {
     int total_students;
@@ -134,928 +561,9178 @@ typedef struct {
     float lowest_gpa;
     int courses_offered;
     float average_enrollment_rate;
+    double total_credit_points;  /* sum of credit points over completed enrollments */
+    int completed_enrollments;
+    double enrollment_rate_sum;  /* sum of current/max capacity over courses offered */
 } SystemStats;
 
 /**
- * Log entry for system operations
+ * Log entry for system operations. Sized to three cache lines; details
+ * longer than LOG_DETAILS_SIZE - 1 bytes are truncated.
  */
 typedef struct {
-    int log_id;
-    int log_level;
-    time_t timestamp;
-    char operation[MAX_NAME_LENGTH];
-    char details[MAX_DESCRIPTION];
+    _Atomic uint64_t sequence; /* log ID once written, 0 while being written */
+    uint64_t timestamp_ns;     /* CLOCK_MONOTONIC */
+    uint8_t log_level;
+    uint8_t operation;         /* LOG_OP_* */
+    uint16_t reserved;
+    char details[LOG_DETAILS_SIZE];
 } LogEntry;
 
-/* ============================================================================
-   GLOBAL VARIABLES
-   ============================================================================ */
-
-Student students[MAX_STUDENTS];
-Course courses[MAX_COURSES];
-Enrollment enrollments[MAX_ENROLLMENTS];
-GradeRecord grade_records[MAX_GRADES];
-LogEntry system_log[MAX_LOG_ENTRIES];
-
-int student_count = 0;
-int course_count = 0;
-int enrollment_count = 0;
-int grade_record_count = 0;
-int log_entry_count = 0;
+/**
+ * One page of a listing; pages count from 1 and a limit of 0 lists every row
+ */
+typedef struct {
+    int page;
+    int limit;
+} ListPage;
 
-/* ============================================================================
-   UTILITY FUNCTIONS
-   ============================================================================ */
+#define LIST_ALL_ROWS ((ListPage){ 1, 0 })
 
 /**
- * Log system operations
+ * Log query filters; zero fields match everything
  */
-void log_operation(int level, const char *operation, const char *details) {
-    if (log_entry_count >= MAX_LOG_ENTRIES) {
-        printf("Warning: Log buffer full\n");
-        return;
-    }
-    
-    system_log[log_entry_count].log_id = log_entry_count + 1;
-    system_log[log_entry_count].log_level = level;
-    system_log[log_entry_count].timestamp = time(NULL);
-    strcpy(system_log[log_entry_count].operation, operation);
-    strcpy(system_log[log_entry_count].details, details);
-    
-    log_entry_count++;
-}
+typedef struct {
+    int level;       /* LOG_* level, 0 for any */
+    int operation;   /* LOG_OP_*, -1 for any */
+    time_t since;    /* wall-clock bounds, 0 for open */
+    time_t until;
+    int limit;       /* newest matches returned */
+} LogQuery;
 
 /**
- * Print separator line for formatting
+ * Background writer that drains the log ring into a rotating file
  */
-void print_separator(char character, int length) {
-    for (int i = 0; i < length; i++) {
-        printf("%c", character);
-    }
-    printf("\n");
-}
+typedef struct {
+    const char *path;
+    FILE *file;
+    long file_bytes;
+    uint64_t next_sequence; /* first log ID not yet written to the file */
+    time_t timestamp_second; /* wall-clock second held in timestamp */
+    char timestamp[32];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int running;
+    int stopping;
+} LogFlusher;
 
 /**
- * Clear input buffer
+ * Block of arena memory; records are carved from blocks and never freed
  */
-void clear_input_buffer(void) {
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF);
-}
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+} ArenaBlock;
 
 /**
- * Validate email format
+ * Bump allocator backing all record tables
  */
-int is_valid_email(const char *email) {
-    int has_at = 0, has_dot = 0;
-    
-    for (int i = 0; email[i] != '\0'; i++) {
-        if (email[i] == '@') has_at++;
-        if (email[i] == '.') has_dot++;
-    }
-    
-    return (has_at == 1 && has_dot >= 1);
-}
+typedef struct {
+    ArenaBlock *head;
+    size_t bytes_reserved;
+    pthread_mutex_t lock; /* tables grow under different locks but share the arena */
+} Arena;
 
 /**
- * Validate phone number
+ * Growable record table made of fixed-size chunks. Chunks are allocated on
+ * demand and never move, so record addresses stay stable as the table grows.
  */
-int is_valid_phone(const char *phone) {
-    if (strlen(phone) < 10) return 0;
-    
-    for (int i = 0; i < strlen(phone); i++) {
-        if (!isdigit(phone[i]) && phone[i] != '-' && phone[i] != ' ') {
-            return 0;
-        }
-    }
-    return 1;
-}
+typedef struct {
+    char *chunks[TABLE_MAX_CHUNKS];
+    size_t record_size;
+} ChunkedTable;
 
 /**
- * Convert numeric grade to letter grade
+ * Student indices whose names contain one trigram, in ascending order
  */
-char get_letter_grade(float marks) {
-    if (marks >= GRADE_A_MIN) return 'A';
-    if (marks >= GRADE_B_MIN) return 'B';
-    if (marks >= GRADE_C_MIN) return 'C';
-    if (marks >= GRADE_D_MIN) return 'D';
-    return 'F';
-}
+typedef struct {
+    int *students;
+    int count;
+    int capacity;
+} TrigramList;
 
 /**
- * Calculate GPA from letter grade
+ * Ranked name search hit; lower rank sorts first
  */
-float get_gpa_from_grade(char grade) {
-    switch (grade) {
-        case 'A': return 4.0f;
-        case 'B': return 3.0f;
-        case 'C': return 2.0f;
-        case 'D': return 1.0f;
-        case 'F': return 0.0f;
-        default: return 0.0f;
-    }
-}
+typedef struct {
+    int student_index;
+    int rank;
+} NameMatch;
 
 /**
- * Get current date and time as string
+ * Open-addressing hash index mapping a record ID to its array position
  */
-void get_current_datetime_string(char *buffer, int size) {
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", tm_info);
-}
+typedef struct {
+    int *keys;      /* 0 marks an empty slot; record IDs are always positive */
+    int *positions;
+    int capacity;   /* power of two, or 0 before the first insert */
+    int count;
+} IdIndex;
 
-/* ============================================================================
-   STUDENT MANAGEMENT FUNCTIONS
-   ============================================================================ */
+/**
+ * Interned strings. Each distinct value gets a small integer ID in first-use
+ * order; the text lives in a pool of length-prefixed, NUL-terminated strings
+ * carved from fixed blocks, so it never moves once interned and IDs can be
+ * compared instead of strings.
+ */
+typedef struct {
+    ChunkedTable entries; /* text of each ID, pointing into the pool */
+    int *slots;           /* open addressing over the text; ID + 1, 0 when empty */
+    int capacity;         /* power of two, or 0 before the first insert */
+    int count;
+    char *block;          /* pool block being filled */
+    size_t block_used;
+    size_t pool_bytes;    /* bytes of every pooled string, including prefixes */
+    pthread_rwlock_t lock;
+} InternTable;
 
 /**
- * Add a new student to the system
+ * Location of one section inside a snapshot file
  */
-int add_student(void) {
-    if (student_count >= MAX_STUDENTS) {
-        printf("Error: Maximum student limit reached!\n");
-        log_operation(LOG_ERROR, "Add Student", "Maximum student limit exceeded");
-        return 0;
-    }
-    
-    printf("\n");
-    print_separator('=', 60);
-    printf("                    ADD NEW STUDENT\n");
-    print_separator('=', 60);
-    
-    students[student_count].student_id = student_count + 1001;
-    
-    printf("Enter student name: ");
-    fgets(students[student_count].name, MAX_NAME_LENGTH, stdin);
-    students[student_count].name[strcspn(students[student_count].name, "\n")] = 0;
-    
-    printf("Enter email address: ");
-    fgets(students[student_count].email, MAX_NAME_LENGTH, stdin);
-    students[student_count].email[strcspn(students[student_count].email, "\n")] = 0;
-    
-    if (!is_valid_email(students[student_count].email)) {
-        printf("Warning: Email format may be invalid\n");
-        log_operation(LOG_WARNING, "Add Student", "Invalid email format");
-    }
-    
-    printf("Enter phone number: ");
-    fgets(students[student_count].phone, 20, stdin);
-    students[student_count].phone[strcspn(students[student_count].phone, "\n")] = 0;
-    
-    if (!is_valid_phone(students[student_count].phone)) {
-        printf("Warning: Phone number format may be invalid\n");
-        log_operation(LOG_WARNING, "Add Student", "Invalid phone format");
-    }
-    
-    printf("Enter address: ");
-    fgets(students[student_count].address, MAX_DESCRIPTION, stdin);
-    students[student_count].address[strcspn(students[student_count].address, "\n")] = 0;
-    
-    printf("Enter admission year: ");
-    scanf("%d", &students[student_count].admission_year);
-    clear_input_buffer();
-    
-    printf("Enter major: ");
-    fgets(students[student_count].major, MAX_NAME_LENGTH, stdin);
-    students[student_count].major[strcspn(students[student_count].major, "\n")] = 0;
-    
-    students[student_count].registration_date = time(NULL);
-    students[student_count].is_active = 1;
-    
-    printf("\n✓ Student added successfully with ID: %d\n", students[student_count].student_id);
-    
-    char log_details[200];
-    sprintf(log_details, "Added student: %s (ID: %d)", students[student_count].name, 
-            students[student_count].student_id);
-    log_operation(LOG_SUCCESS, "Add Student", log_details);
-    
-    student_count++;
-    return 1;
-}
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t record_size; /* sizeof the stored record, checked on load */
+    uint32_t reserved;
+} SnapshotSection;
 
 /**
- * Display all students
+ * Snapshot file header. Table sections hold whole chunks so they can be
+ * mapped straight into the chunk directories. The log is not included; it
+ * is persisted by the log file writer.
  */
-void display_all_students(void) {
-    if (student_count == 0) {
-        printf("No students in the system.\n");
-        return;
-    }
-    
-    printf("\n");
-    print_separator('=', 100);
-    printf("%-6s %-25s %-30s %-15s %-10s\n", "ID", "Name", "Email", "Phone", "Major");
-    print_separator('=', 100);
-    
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].is_active) {
-            printf("%-6d %-25s %-30s %-15s %-10s\n",
-                   students[i].student_id,
-                   students[i].name,
-                   students[i].email,
-                   students[i].phone,
-                   students[i].major);
-        }
-    }
-    
-    print_separator('=', 100);
-    printf("Total Active Students: %d\n\n", student_count);
-}
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t student_count;
+    int32_t course_count;
+    int32_t enrollment_count;
+    int32_t string_count;
+    int32_t assessment_count;
+    int32_t shard_index;       /* deployment slot the IDs were assigned for */
+    int32_t shard_count;
+    int32_t next_enrollment_id; /* enrollment IDs are not dense once rows are archived */
+    int64_t saved_at;
+    uint64_t journal_sequence; /* last journal record included in this snapshot */
+    SystemStats stats;
+    SnapshotSection sections[SNAPSHOT_SECTION_COUNT];
+} SnapshotHeader;
 
 /**
- * Display student details
+ * Journal file header, written once when the file is created
  */
-void display_student_details(int student_id) {
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].student_id == student_id && students[i].is_active) {
-            printf("\n");
-            print_separator('=', 60);
-            printf("                    STUDENT DETAILS\n");
-            print_separator('=', 60);
-            printf("Student ID:      %d\n", students[i].student_id);
-            printf("Name:            %s\n", students[i].name);
-            printf("Email:           %s\n", students[i].email);
-            printf("Phone:           %s\n", students[i].phone);
-            printf("Address:         %s\n", students[i].address);
-            printf("Admission Year:  %d\n", students[i].admission_year);
-            printf("Major:           %s\n", students[i].major);
-            printf("Status:          %s\n", students[i].is_active ? "Active" : "Inactive");
-            
-            char datetime[50];
-            get_current_datetime_string(datetime, sizeof(datetime));
-            printf("Registration:    %s\n", datetime);
-            print_separator('=', 60);
-            printf("\n");
-            return;
-        }
-    }
-    
-    printf("Student not found.\n");
-    log_operation(LOG_WARNING, "Display Student", "Student ID not found");
-}
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+} JournalFileHeader;
 
 /**
- * Search student by name
+ * Frame preceding each journal record payload
  */
-void search_student_by_name(void) {
-    char search_name[MAX_NAME_LENGTH];
-    
-    printf("Enter student name to search: ");
-    fgets(search_name, MAX_NAME_LENGTH, stdin);
-    search_name[strcspn(search_name, "\n")] = 0;
-    
-    printf("\n");
-    print_separator('=', 100);
-    printf("%-6s %-25s %-30s %-15s %-10s\n", "ID", "Name", "Email", "Phone", "Major");
-    print_separator('=', 100);
-    
-    int found = 0;
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].is_active && strstr(students[i].name, search_name)) {
-            printf("%-6d %-25s %-30s %-15s %-10s\n",
-                   students[i].student_id,
-                   students[i].name,
-                   students[i].email,
-                   students[i].phone,
-                   students[i].major);
-            found++;
-        }
-    }
-    
-    print_separator('=', 100);
-    
+typedef struct {
+    uint32_t type;
+    uint32_t size;     /* payload bytes following this frame */
+    uint64_t sequence; /* increases by one per record */
+    uint32_t checksum; /* over sequence and payload, detects torn writes */
+    uint32_t reserved;
+} JournalRecordHeader;
+
+typedef struct {
+    int32_t student_id;
+    int32_t reserved;
+    StudentProfile profile;
+    char major[MAX_NAME_LENGTH];
+} JournalStudentRecord;
+
+typedef struct {
+    int32_t course_id;
+    char course_code[MAX_COURSE_CODE];
+    int32_t credits;
+    int32_t max_capacity;
+    float difficulty_level;
+    CourseDetails details;
+} JournalCourseRecord;
+
+typedef struct {
+    int32_t enrollment_id;
+    int32_t student_id;
+    int32_t course_id;
+    int32_t status;  /* 0 when seated, 4 when waitlisted */
+    int64_t enrollment_date;
+} JournalEnrollmentRecord;
+
+typedef struct {
+    int32_t enrollment_id;
+    float grade;
+} JournalGradeRecord;
+
+typedef struct {
+    int32_t enrollment_id;
+    int32_t reserved;
+} JournalDropRecord;
+
+typedef struct {
+    int32_t through_term;
+    int32_t archived; /* enrollments moved, checked on replay */
+} JournalArchiveRecord;
+
+typedef struct {
+    int32_t assessment_id;
+    int32_t enrollment_id;
+    int32_t assessment_type; /* ASSESSMENT_QUIZ .. ASSESSMENT_FINAL */
+    float marks_obtained;
+    float total_marks;
+    int32_t reserved;
+    int64_t assessment_date;
+} JournalAssessmentRecord;
+
+/**
+ * Open journal and its group commit state
+ */
+typedef struct {
+    int fd;                    /* -1 while no journal is open */
+    pthread_mutex_t lock;
+    char buffer[JOURNAL_BUFFER_SIZE];
+    size_t buffered;
+    int pending_records;       /* appended since the last fsync */
+    double last_sync;
+    uint64_t sequence;         /* last sequence appended or replayed */
+    int sync_interval_ms;
+    int sync_records;
+} Journal;
+
+/**
+ * Output buffer for streaming export. Rows are formatted straight into the
+ * buffer, which is handed to write(2) only when full.
+ */
+typedef struct {
+    int fd;
+    char *buffer;
+    size_t size;
+    size_t used;
+    uint64_t bytes_written;
+    int failed;
+} ExportWriter;
+
+/**
+ * Progress message a job's child process writes to its progress pipe
+ */
+typedef struct {
+    uint64_t bytes_written;
+    uint64_t bytes_total;      /* 0 while unknown */
+} JobProgress;
+
+/**
+ * Snapshot or export written in the background. The child process works
+ * from the copy-on-write view it was forked with; the monitor thread
+ * reads its progress and reaps it.
+ */
+typedef struct {
+    int id;
+    int kind;                  /* JOB_SNAPSHOT, JOB_EXPORT or JOB_TEXT_EXPORT */
+    int format;                /* JOB_EXPORT only */
+    int tables;
+    char path[FILE_BUFFER_SIZE];
+    char export_date[32];      /* JOB_TEXT_EXPORT only; formatted before the fork */
+    pid_t pid;
+    int progress_fd;           /* read end of the progress pipe */
+    int state;                 /* JOB_IDLE .. JOB_FAILED, under background_lock */
+    _Atomic uint64_t bytes_written;
+    _Atomic uint64_t bytes_total;
+    off_t journal_covered;     /* journal bytes a snapshot includes */
+    uint64_t started_ns;
+    uint64_t finished_ns;
+} BackgroundJob;
+
+/**
+ * Accepted client connections waiting for a server worker
+ */
+typedef struct {
+    int fds[SESSION_QUEUE_SIZE];
+    int head;
+    int count;
+    int closing;
+    int active_fds[MAX_SERVER_WORKERS]; /* connection each worker is serving, or -1 */
+    long long sessions;
+    long long commands;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+} SessionQueue;
+
+/**
+ * Command runner used by batch files and server sessions; a shard
+ * coordinator swaps in coordinate_command
+ */
+typedef int (*CommandHandler)(char **fields, int field_count, int line_number);
+
+/**
+ * Network address of one shard instance
+ */
+typedef struct {
+    char host[64];
+    char port[8];
+} ShardAddress;
+
+/**
+ * One coordinator thread's connection to a shard; NULL streams until the
+ * first command routed there
+ */
+typedef struct {
+    FILE *input;
+    FILE *output;
+} ShardLink;
+
+/**
+ * Shard coordinator: routes each command to the shard owning its record and
+ * merges partial aggregates for reports over all shards
+ */
+typedef struct {
+    ShardAddress shards[MAX_SHARDS];
+    int shard_count;                  /* 0 unless running as a coordinator */
+    _Atomic unsigned int next_shard;  /* round robin for new students */
+    pthread_mutex_t catalog_lock;     /* keeps catalog broadcasts in one order on every shard */
+    int catalog_diverged;             /* an add-course reached only some shards; under catalog_lock */
+} Coordinator;
+
+/**
+ * Per-student totals over completed enrollments, as built by a term report
+ */
+typedef struct {
+    double credit_points;
+    int completed;
+    int credits;
+    double weighted_points;
+} StudentTotals;
+
+/**
+ * Dean's list entry taken from a student's cumulative GPA cache
+ */
+typedef struct {
+    int student_index;
+    int credits;
+    float gpa;
+} HonorRollEntry;
+
+/**
+ * Grade aggregates of one course, as read from its running totals or
+ * merged from the shards
+ */
+typedef struct {
+    int current_enrollment;
+    int graded;
+    double grade_sum;
+    float grade_min;
+    float grade_max;
+    GradeHistogram histogram;
+} ClassSummary;
+
+/**
+ * Seats of one course summed over the shards
+ */
+typedef struct {
+    int taken;
+    int held;
+} SeatTotals;
+
+/**
+ * Candidate row of a ranked view: its table position and ranking value
+ */
+typedef struct {
+    int index;
+    double score;
+} RankedEntry;
+
+/**
+ * Ranked view order: > 0 when a ranks ahead of b. Ties are broken on the
+ * table position, so distinct entries never compare equal.
+ */
+typedef int (*RankCompare)(const RankedEntry *a, const RankedEntry *b);
+
+/**
+ * Bounded top-K selection. The heap keeps its weakest entry at the root, so
+ * a candidate is rejected in O(1) or kept in O(log K).
+ */
+typedef struct {
+    RankedEntry *heap;
+    int count;
+    int limit;
+    RankCompare compare;
+} TopK;
+
+/**
+ * Per-major totals, indexed by the interned major ID
+ */
+typedef struct {
+    int major_id;
+    int students;
+    int credits;
+    double weighted_points;
+} MajorTotals;
+
+/**
+ * Per-course grade totals over completed enrollments
+ */
+typedef struct {
+    double grade_sum;
+    int graded;
+    float grade_min;
+    float grade_max;
+} CourseTotals;
+
+/**
+ * One report thread's share of the work: a range of enrollment rows scanned
+ * into private accumulators, then a slice of the merge
+ */
+typedef struct {
+    int first_row;
+    int end_row;
+    StudentTotals *students;     /* student_count entries */
+    CourseTotals *courses;       /* course_count entries */
+    int merge_first_student, merge_end_student;
+    int merge_first_course, merge_end_course;
+    struct TermReport *report;
+    pthread_t thread;
+} ReportPartition;
+
+/**
+ * Totals for every student and course, recomputed from the enrollment rows
+ */
+typedef struct TermReport {
+    int student_count;
+    int course_count;
+    int enrollment_count;
+    int archived_count;
+    int threads;
+    ReportPartition partitions[REPORT_MAX_THREADS];
+    StudentTotals *students;     /* merged results, owned by partition 0 */
+    CourseTotals *courses;
+    double seconds;
+} TermReport;
+
+/**
+ * Block reader for batch and bulk request files. Lines are tokenized in
+ * place in the buffer, so a command costs no copies or allocations.
+ */
+typedef struct {
+    int fd;
+    char *buffer;    /* BATCH_READ_SIZE bytes plus room for a terminator */
+    size_t start;    /* first unread byte */
+    size_t end;      /* end of the bytes read so far */
+    int at_eof;
+    int read_error;  /* errno of a failed read, which also ends the input */
+    int line_number;
+} BatchReader;
+
+/**
+ * One request of a bulk enrollment; the result fields are filled in
+ */
+typedef struct {
+    int student_id;
+    int course_id;
+    int enrollment_id; /* assigned unless the request failed */
+    int result;        /* RESULT_OK, RESULT_WAITLISTED or the failure */
+} EnrollmentRequest;
+
+/**
+ * One request of a bulk grade import
+ */
+typedef struct {
+    int enrollment_id;
+    float grade;
+    int result;
+} GradeRequest;
+
+/**
+ * Bulk request resolved against the indexes; sorting these groups the
+ * requests by course while keeping input order within a course
+ */
+typedef struct {
+    int course_index;
+    int student_index;
+    int enrollment_index; /* grade imports only */
+    int position;         /* request position in the input */
+} BulkOrder;
+
+/**
+ * Counters of one operation. Each thread owns its own copy and is the only
+ * writer, so updates are plain relaxed stores; readers sum all copies.
+ */
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t errors;
+    _Atomic uint64_t total_ns;
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[METRIC_BUCKETS];
+} MetricCounters;
+
+/**
+ * One thread's counters, kept on a list for readers; never freed so a
+ * reader can still walk the list after the thread exits
+ */
+typedef struct MetricShard {
+    MetricCounters counters[METRIC_COUNT];
+    _Atomic uint64_t contention[CONTENTION_COUNT];
+    struct MetricShard *next;
+} MetricShard;
+
+/**
+ * Counters of one operation summed over all threads
+ */
+typedef struct {
+    uint64_t count;
+    uint64_t errors;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[METRIC_BUCKETS];
+} MetricTotals;
+
+/**
+ * Per-call latencies of one benchmarked operation
+ */
+typedef struct {
+    const char *name;
+    int operations;
+    int recorded;
+    int failed;
+    uint64_t started_ns;
+    uint64_t *latencies_ns; /* operations entries */
+} BenchTimer;
+
+/**
+ * One registration storm thread and the virtual students it plays
+ */
+typedef struct {
+    pthread_t thread;
+    pthread_barrier_t *start;
+    FILE *sink;              /* report output of the statistics reads */
+    const double *zipf_cdf;  /* cumulative course popularity by rank */
+    int courses;
+    int first_student;       /* offset of this thread's students */
+    int students;
+    int operations;
+    uint64_t random;
+    BenchTimer timers[STORM_KINDS];
+    int seated;
+    int waitlisted;
+    int duplicates;
+    int other_failures;
+    int *seated_ids;         /* enrollments this thread may grade */
+} StormWorker;
+
+/* ============================================================================
+   GLOBAL VARIABLES
+   ============================================================================ */
+
+Arena record_arena = { .lock = PTHREAD_MUTEX_INITIALIZER };
+ChunkedTable student_table = { .record_size = sizeof(Student) };
+ChunkedTable student_profile_table = { .record_size = sizeof(StudentProfile) };
+ChunkedTable course_table = { .record_size = sizeof(Course) };
+ChunkedTable course_details_table = { .record_size = sizeof(CourseDetails) };
+ChunkedTable course_histogram_table = { .record_size = sizeof(GradeHistogram) };
+ChunkedTable enrollment_table = { .record_size = sizeof(Enrollment) };
+InternTable interned = { .entries = { .record_size = sizeof(const char *) },
+                         .lock = PTHREAD_RWLOCK_INITIALIZER };
+EnrollmentColumns *enrollment_columns[TABLE_MAX_CHUNKS];
+ChunkedTable grade_record_table = { .record_size = sizeof(GradeRecord) };
+const char *assessment_type_names[ASSESSMENT_TYPE_COUNT] = { "Quiz", "Assignment", "Midterm", "Final" };
+const float assessment_weights[ASSESSMENT_TYPE_COUNT] = { 0.15f, 0.25f, 0.25f, 0.35f };
+SystemStats system_stats;
+LogEntry system_log[LOG_RING_SIZE] __attribute__((aligned(64)));
+_Atomic uint64_t log_head = 0; /* log IDs handed out so far, counting earlier sessions */
+uint64_t log_session_first = 1; /* first log ID of this session */
+/* Per-level rings of log IDs, so level queries skip other entries */
+_Atomic uint64_t log_level_index[LOG_LEVEL_COUNT][LOG_RING_SIZE];
+_Atomic uint64_t log_level_head[LOG_LEVEL_COUNT];
+time_t log_wall_base;
+uint64_t log_monotonic_base;
+LogFlusher log_flusher = { .path = DEFAULT_LOG_PATH, .next_sequence = 1,
+                           .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER };
+const char *log_operation_names[LOG_OP_COUNT] = {
+    "System Init",
+    "System Shutdown",
+    "Menu",
+    "Add Student",
+    "Display Student",
+    "Add Course",
+    "Display Course",
+    "Enrollment",
+    "Record Grade",
+    "Export Data",
+    "Stream Export",
+    "Save Snapshot",
+    "Load Snapshot",
+    "Journal",
+    "Journal Replay",
+    "Batch",
+    "Server",
+    "Drop Enrollment",
+    "Term Report",
+    "Metrics",
+    "Archive",
+    "Background Job"
+};
+
+int student_count = 0;
+int course_count = 0;
+int enrollment_count = 0;
+int assessment_count = 0;
+int grade_record_count = 0;
+
+IdIndex student_id_index;
+IdIndex course_id_index;
+IdIndex enrollment_id_index;
+TrigramList name_trigrams[TRIGRAM_COUNT];
+
+/* Archive segments in creation order. The list only changes under
+   lock_all_records, so holding any record lock keeps it stable. */
+const ArchiveSegment **archive_segments = NULL;
+int archive_segment_count = 0;
+int archive_segment_capacity = 0;
+int archived_enrollment_count = 0;
+
+/*
+ * Lock order: a table lock held shared for a lookup is released before any
+ * entity lock is taken. Entity locks go student shard, then course shard,
+ * then the enrollment table (exclusive for appends), then the assessment
+ * table, then stats_lock or the journal lock. The table locks guard the ID indexes, record counts and the
+ * name index; records themselves never move, so rows below a count read
+ * under the table lock can be used without holding it. The one exception
+ * is archiving, which compacts the enrollment rows under lock_all_records;
+ * an enrollment position found before its entity locks were taken is
+ * looked up again once they are held.
+ */
+pthread_rwlock_t student_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_rwlock_t course_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_rwlock_t enrollment_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_rwlock_t assessment_table_lock = PTHREAD_RWLOCK_INITIALIZER;
+pthread_rwlock_t student_locks[LOCK_SHARDS];
+pthread_rwlock_t course_locks[LOCK_SHARDS];
+pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+_Thread_local FILE *session_stream = NULL; /* client connection of a server worker */
+_Thread_local MetricShard *metric_shard = NULL;
+_Thread_local FILE *render_stream = NULL; /* buffered stream of the listing being rendered */
+_Thread_local char *render_buffer = NULL;
+_Thread_local int render_depth = 0;
+/* '=' and '-' separators of every length: the tail of a full line */
+char separator_lines[2][MAX_SEPARATOR_LENGTH + 1];
+MetricShard *metric_shards = NULL; /* every thread's counters, newest first */
+pthread_mutex_t metric_shards_lock = PTHREAD_MUTEX_INITIALIZER;
+const char *metric_names[METRIC_COUNT] = {
+    "add_student",
+    "enroll",
+    "grade",
+    "name_search",
+    "class_stats",
+    "deans_list",
+    "term_report",
+    "export"
+};
+const char *contention_names[CONTENTION_COUNT] = {
+    "student_lock_waits",
+    "course_lock_waits",
+    "seat_cas_retries"
+};
+SessionQueue session_queue = { .lock = PTHREAD_MUTEX_INITIALIZER, .ready = PTHREAD_COND_INITIALIZER };
+volatile sig_atomic_t server_stopping = 0;
+const char *server_bind_address = DEFAULT_BIND_ADDRESS;
+CommandHandler command_handler = NULL; /* set by main before any command runs */
+Coordinator coordinator = { .catalog_lock = PTHREAD_MUTEX_INITIALIZER };
+_Thread_local ShardLink shard_links[MAX_SHARDS];
+
+/* Place of this instance in a sharded deployment, and the ID bases that follow from it */
+int shard_index = 0;
+int shard_count = 1;
+int student_id_base = FIRST_STUDENT_ID;
+int enrollment_id_base = FIRST_ENROLLMENT_ID;
+int next_enrollment_id = FIRST_ENROLLMENT_ID; /* guarded by the enrollment table lock */
+int assessment_id_base = FIRST_ASSESSMENT_ID;
+
+const char *snapshot_path = DEFAULT_SNAPSHOT_PATH;
+void *snapshot_mapping = NULL; /* private mapping backing loaded chunks; kept for the process lifetime */
+size_t snapshot_mapping_size = 0;
+
+const char *journal_path = DEFAULT_JOURNAL_PATH;
+Journal journal = { .fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER, .sync_interval_ms = DEFAULT_SYNC_INTERVAL_MS,
+                    .sync_records = DEFAULT_SYNC_RECORDS };
+
+size_t export_buffer_size = DEFAULT_EXPORT_BUFFER_SIZE;
+
+BackgroundJob background_jobs[MAX_BACKGROUND_JOBS];
+int background_job_count = 0; /* jobs started; job IDs are 1-based */
+pthread_mutex_t background_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t background_done = PTHREAD_COND_INITIALIZER;
+int background_progress_fd = -1; /* set only in a job's child process */
+
+/* ============================================================================
+   UTILITY FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Monotonic clock in nanoseconds
+ */
+uint64_t monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * Claim the next ring slot; the oldest entry is overwritten once the ring
+ * is full. The caller fills in the entry and publishes it with log_publish.
+ */
+LogEntry *log_claim(int level, int operation, uint64_t *sequence) {
+    *sequence = atomic_fetch_add_explicit(&log_head, 1, memory_order_relaxed) + 1;
+    LogEntry *entry = &system_log[(*sequence - 1) & (LOG_RING_SIZE - 1)];
+    
+    /* Nudge the flusher each half ring so bursts are not overwritten unflushed */
+    if ((*sequence & (LOG_RING_SIZE / 2 - 1)) == 0 && log_flusher.running) {
+        pthread_cond_signal(&log_flusher.wake);
+    }
+    
+    /* Readers that see 0 here, or a changed sequence after copying, retry or skip */
+    atomic_store_explicit(&entry->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    entry->timestamp_ns = monotonic_ns();
+    entry->log_level = (uint8_t)level;
+    entry->operation = (uint8_t)operation;
+    return entry;
+}
+
+void log_publish(LogEntry *entry, uint64_t sequence) {
+    atomic_store_explicit(&entry->sequence, sequence, memory_order_release);
+    
+    if (entry->log_level > 0 && entry->log_level < LOG_LEVEL_COUNT) {
+        uint64_t position = atomic_fetch_add_explicit(&log_level_head[entry->log_level], 1,
+                                                      memory_order_relaxed);
+        atomic_store_explicit(&log_level_index[entry->log_level][position & (LOG_RING_SIZE - 1)],
+                              sequence, memory_order_release);
+    }
+}
+
+/**
+ * Log an operation with fixed details text
+ */
+void log_operation(int level, int operation, const char *details) {
+    uint64_t sequence;
+    LogEntry *entry = log_claim(level, operation, &sequence);
+    size_t length = strnlen(details, LOG_DETAILS_SIZE - 1);
+    memcpy(entry->details, details, length);
+    entry->details[length] = '\0';
+    log_publish(entry, sequence);
+}
+
+/**
+ * Log an operation, formatting the details straight into the ring slot
+ */
+void log_operationf(int level, int operation, const char *format, ...) {
+    uint64_t sequence;
+    LogEntry *entry = log_claim(level, operation, &sequence);
+    va_list args;
+    va_start(args, format);
+    vsnprintf(entry->details, LOG_DETAILS_SIZE, format, args);
+    va_end(args);
+    log_publish(entry, sequence);
+}
+
+/**
+ * Copy log entry sequence out of the ring
+ * Returns 1 if it is still held, 0 if it was overwritten or is mid-write
+ */
+int log_read(uint64_t sequence, LogEntry *out) {
+    if (sequence == 0) return 0; /* an index slot not yet written */
+    const LogEntry *entry = &system_log[(sequence - 1) & (LOG_RING_SIZE - 1)];
+    if (atomic_load_explicit(&entry->sequence, memory_order_acquire) != sequence) return 0;
+    
+    out->timestamp_ns = entry->timestamp_ns;
+    out->log_level = entry->log_level;
+    out->operation = entry->operation;
+    memcpy(out->details, entry->details, LOG_DETAILS_SIZE);
+    out->details[LOG_DETAILS_SIZE - 1] = '\0';
+    
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&entry->sequence, memory_order_relaxed) != sequence) return 0;
+    atomic_store_explicit(&out->sequence, sequence, memory_order_relaxed);
+    return 1;
+}
+
+/**
+ * Total number of entries logged, counting earlier sessions in the log file
+ */
+uint64_t log_entries_written(void) {
+    return atomic_load_explicit(&log_head, memory_order_acquire);
+}
+
+/**
+ * Oldest log ID still held in the ring
+ */
+uint64_t log_oldest_sequence(void) {
+    uint64_t head = log_entries_written();
+    uint64_t oldest = head > LOG_RING_SIZE ? head - LOG_RING_SIZE + 1 : 1;
+    return oldest > log_session_first ? oldest : log_session_first;
+}
+
+/**
+ * Continue log IDs after last, the newest ID of an earlier session.
+ * Called before anything is logged.
+ */
+void log_continue_from(uint64_t last) {
+    atomic_store_explicit(&log_head, last, memory_order_release);
+    log_session_first = last + 1;
+    log_flusher.next_sequence = last + 1;
+}
+
+/**
+ * Pair the monotonic clock with wall-clock time; called once at startup
+ */
+void log_clock_init(void) {
+    log_wall_base = time(NULL);
+    log_monotonic_base = monotonic_ns();
+}
+
+/**
+ * Convert a monotonic log timestamp to wall-clock time
+ */
+time_t log_wall_time(uint64_t timestamp_ns) {
+    return log_wall_base + ((int64_t)(timestamp_ns - log_monotonic_base) / 1000000000);
+}
+
+/**
+ * Printable name of a log level
+ */
+const char *log_level_name(int level) {
+    switch (level) {
+        case LOG_INFO: return "INFO";
+        case LOG_WARNING: return "WARNING";
+        case LOG_ERROR: return "ERROR";
+        case LOG_SUCCESS: return "SUCCESS";
+        default: return "UNKNOWN";
+    }
+}
+
+/**
+ * Stream for report output: the listing being rendered, else the client
+ * connection inside a server session, else stdout
+ */
+FILE *session_output(void) {
+    if (render_stream) return render_stream;
+    return session_stream ? session_stream : stdout;
+}
+
+/**
+ * Stream for command errors: the client connection inside a server
+ * session, stderr otherwise
+ */
+FILE *session_errors(void) {
+    return session_stream ? session_stream : stderr;
+}
+
+/**
+ * Copy a field into a fixed-size record buffer, truncating like fgets would
+ */
+void copy_field(char *destination, size_t size, const char *source) {
+    size_t length = strlen(source);
+    if (length >= size) length = size - 1;
+    memcpy(destination, source, length);
+    destination[length] = '\0';
+}
+
+/**
+ * Build the precomputed separator lines; called once at startup
+ */
+void render_init(void) {
+    memset(separator_lines[0], '=', MAX_SEPARATOR_LENGTH);
+    memset(separator_lines[1], '-', MAX_SEPARATOR_LENGTH);
+    separator_lines[0][MAX_SEPARATOR_LENGTH] = '\n';
+    separator_lines[1][MAX_SEPARATOR_LENGTH] = '\n';
+}
+
+/**
+ * Start rendering a listing and return its stream. Output bound for stdout
+ * goes through a fully buffered duplicate with a RENDER_BUFFER_SIZE buffer,
+ * so a large listing leaves in a few big writes instead of one per line;
+ * server sessions are already buffered. Calls nest, and session_output()
+ * returns the stream until the outermost render_end.
+ */
+FILE *render_begin(void) {
+    if (render_depth++ > 0) return render_stream;
+    if (session_stream) {
+        render_stream = session_stream;
+        return render_stream;
+    }
+    
+    fflush(stdout);
+    int fd = dup(STDOUT_FILENO);
+    FILE *buffered = fd != -1 ? fdopen(fd, "w") : NULL;
+    render_buffer = buffered ? malloc(RENDER_BUFFER_SIZE) : NULL;
+    if (!render_buffer) {
+        if (buffered) fclose(buffered); else if (fd != -1) close(fd);
+        render_stream = stdout;
+        return render_stream;
+    }
+    setvbuf(buffered, render_buffer, _IOFBF, RENDER_BUFFER_SIZE);
+    render_stream = buffered;
+    return render_stream;
+}
+
+/**
+ * Finish a listing, writing out whatever is still buffered
+ */
+void render_end(void) {
+    if (--render_depth > 0) return;
+    
+    FILE *out = render_stream;
+    render_stream = NULL;
+    if (out == session_stream || out == stdout) return;
+    fclose(out);
+    free(render_buffer);
+    render_buffer = NULL;
+}
+
+/**
+ * Write a separator line to a stream. The usual characters and lengths
+ * are a single write of a precomputed line.
+ */
+void write_separator(FILE *out, char character, int length) {
+    int line = character == '=' ? 0 : character == '-' ? 1 : -1;
+    if (line != -1 && length >= 0 && length <= MAX_SEPARATOR_LENGTH) {
+        fwrite(separator_lines[line] + MAX_SEPARATOR_LENGTH - length, 1, length + 1, out);
+        return;
+    }
+    for (int i = 0; i < length; i++) {
+        fputc(character, out);
+    }
+    fputc('\n', out);
+}
+
+/**
+ * Position of the first row of a page
+ */
+long long page_first_row(const ListPage *page) {
+    return page->limit > 0 ? (long long)(page->page - 1) * page->limit : 0;
+}
+
+/**
+ * Whether row comes after the page, so a listing can stop
+ */
+int page_done(const ListPage *page, long long row) {
+    return page->limit > 0 && row >= page_first_row(page) + page->limit;
+}
+
+/**
+ * Print where a page sits in a listing of total rows; nothing when the
+ * listing is not paged
+ */
+void write_page_footer(FILE *out, const ListPage *page, int total) {
+    if (page->limit == 0) return;
+    
+    int pages = total > 0 ? (int)(((long long)total + page->limit - 1) / page->limit) : 1;
+    long long first = page_first_row(page);
+    if (first >= total) {
+        fprintf(out, "Page %d of %d: no rows (%d in total)\n", page->page, pages, total);
+    } else {
+        long long last = first + page->limit < total ? first + page->limit : total;
+        fprintf(out, "Page %d of %d (rows %lld-%lld of %d)\n", page->page, pages, first + 1, last, total);
+    }
+}
+
+/**
+ * Print separator line for formatting
+ */
+void print_separator(char character, int length) {
+    write_separator(session_output(), character, length);
+}
+
+/**
+ * Clear input buffer
+ */
+void clear_input_buffer(void) {
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF);
+}
+
+/**
+ * Validate email format
+ */
+int is_valid_email(const char *email) {
+    int has_at = 0, has_dot = 0;
+    
+    for (int i = 0; email[i] != '\0'; i++) {
+        if (email[i] == '@') has_at++;
+        if (email[i] == '.') has_dot++;
+    }
+    
+    return (has_at == 1 && has_dot >= 1);
+}
+
+/**
+ * Validate phone number
+ */
+int is_valid_phone(const char *phone) {
+    size_t length = 0;
+    
+    for (; phone[length] != '\0'; length++) {
+        char c = phone[length];
+        if (!isdigit((unsigned char)c) && c != '-' && c != ' ') {
+            return 0;
+        }
+    }
+    return length >= 10;
+}
+
+/**
+ * Copy an email address into a record field like copy_field, checking it
+ * as is_valid_email does in the same pass. Returns 1 if the copy is valid.
+ */
+int copy_email_field(char *destination, size_t size, const char *source) {
+    int has_at = 0, has_dot = 0;
+    size_t length = 0;
+    
+    for (; source[length] != '\0' && length + 1 < size; length++) {
+        char c = source[length];
+        has_at += c == '@';
+        has_dot += c == '.';
+        destination[length] = c;
+    }
+    destination[length] = '\0';
+    return has_at == 1 && has_dot >= 1;
+}
+
+/**
+ * Copy a phone number into a record field, checking it as is_valid_phone
+ * does in the same pass. Returns 1 if the copy is valid.
+ */
+int copy_phone_field(char *destination, size_t size, const char *source) {
+    int valid = 1;
+    size_t length = 0;
+    
+    for (; source[length] != '\0' && length + 1 < size; length++) {
+        char c = source[length];
+        if (!isdigit((unsigned char)c) && c != '-' && c != ' ') valid = 0;
+        destination[length] = c;
+    }
+    destination[length] = '\0';
+    return valid && length >= 10;
+}
+
+/**
+ * Convert numeric grade to letter grade
+ */
+char get_letter_grade(float marks) {
+    if (marks >= GRADE_A_MIN) return 'A';
+    if (marks >= GRADE_B_MIN) return 'B';
+    if (marks >= GRADE_C_MIN) return 'C';
+    if (marks >= GRADE_D_MIN) return 'D';
+    return 'F';
+}
+
+/**
+ * Calculate GPA from letter grade
+ */
+float get_gpa_from_grade(char grade) {
+    switch (grade) {
+        case 'A': return 4.0f;
+        case 'B': return 3.0f;
+        case 'C': return 2.0f;
+        case 'D': return 1.0f;
+        case 'F': return 0.0f;
+        default: return 0.0f;
+    }
+}
+
+/**
+ * Seconds on the monotonic clock, for timing bulk operations
+ */
+double monotonic_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Get current date and time as string
+ */
+void get_current_datetime_string(char *buffer, int size) {
+    time_t now = time(NULL);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+    strftime(buffer, size, "%Y-%m-%d %H:%M:%S", &tm_info);
+}
+
+/**
+ * Get the current date as asctime formats it, including the newline
+ */
+void get_export_date_string(char *buffer, int size) {
+    time_t now = time(NULL);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+    strftime(buffer, size, "%a %b %e %H:%M:%S %Y\n", &tm_info);
+}
+
+/* ============================================================================
+   INSTRUMENTATION
+   ============================================================================ */
+
+/**
+ * Report how far a background job has got; does nothing outside a job's
+ * child process. bytes_total is 0 when the size is not known in advance.
+ */
+void job_progress(uint64_t bytes_written, uint64_t bytes_total) {
+    if (background_progress_fd == -1) return;
+    JobProgress progress = { bytes_written, bytes_total };
+    if (write(background_progress_fd, &progress, sizeof(progress)) != (ssize_t)sizeof(progress)) {
+        background_progress_fd = -1;
+    }
+}
+
+/**
+ * Histogram bucket of a latency: exact below 2^(METRIC_SUB_BITS + 1) ns,
+ * then METRIC_SUB_BUCKETS linear steps per power of two
+ */
+int metric_bucket(uint64_t ns) {
+    if (ns < 2 * METRIC_SUB_BUCKETS) return (int)ns;
+    int magnitude = 63 - __builtin_clzll(ns);
+    int sub = (int)(ns >> (magnitude - METRIC_SUB_BITS)) & (METRIC_SUB_BUCKETS - 1);
+    int bucket = (magnitude - METRIC_SUB_BITS + 1) * METRIC_SUB_BUCKETS + sub;
+    return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+/**
+ * Smallest latency that falls past bucket, in nanoseconds
+ */
+uint64_t metric_bucket_limit(int bucket) {
+    if (bucket < METRIC_SUB_BUCKETS) return bucket + 1;
+    int shift = bucket / METRIC_SUB_BUCKETS - 1;
+    uint64_t lower = (uint64_t)(METRIC_SUB_BUCKETS + bucket % METRIC_SUB_BUCKETS) << shift;
+    return lower + ((uint64_t)1 << shift);
+}
+
+/**
+ * Add to a counter of the calling thread's shard; only the owner writes it
+ */
+void metric_add(_Atomic uint64_t *counter, uint64_t amount) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/**
+ * The calling thread's counters, registered on first use. Returns NULL if
+ * they could not be allocated.
+ */
+MetricShard *metric_thread_shard(void) {
+    if (!metric_shard) {
+        MetricShard *shard = calloc(1, sizeof(MetricShard));
+        if (!shard) return NULL;
+        pthread_mutex_lock(&metric_shards_lock);
+        shard->next = metric_shards;
+        metric_shards = shard;
+        pthread_mutex_unlock(&metric_shards_lock);
+        metric_shard = shard;
+    }
+    return metric_shard;
+}
+
+/**
+ * Record one call of an operation that began at started_ns
+ */
+void metric_record(int metric, uint64_t started_ns, int ok) {
+    uint64_t elapsed = monotonic_ns() - started_ns;
+    if (!metric_thread_shard()) return;
+    
+    MetricCounters *counters = &metric_shard->counters[metric];
+    metric_add(&counters->count, 1);
+    if (!ok) metric_add(&counters->errors, 1);
+    metric_add(&counters->total_ns, elapsed);
+    metric_add(&counters->buckets[metric_bucket(elapsed)], 1);
+    if (elapsed > atomic_load_explicit(&counters->max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&counters->max_ns, elapsed, memory_order_relaxed);
+    }
+}
+
+/**
+ * Record a record operation by its result code and pass the code through.
+ * A waitlisted enrollment counts as a success.
+ */
+int metric_result(int metric, uint64_t started_ns, int result) {
+    metric_record(metric, started_ns, result == RESULT_OK || result == RESULT_WAITLISTED);
+    return result;
+}
+
+/**
+ * Count one CONTENTION_* event on the calling thread
+ */
+void contention_record(int counter) {
+    MetricShard *shard = metric_thread_shard();
+    if (shard) metric_add(&shard->contention[counter], 1);
+}
+
+/**
+ * Sum every thread's contention counters
+ */
+void contention_collect(uint64_t totals[CONTENTION_COUNT]) {
+    memset(totals, 0, sizeof(uint64_t) * CONTENTION_COUNT);
+    
+    pthread_mutex_lock(&metric_shards_lock);
+    for (const MetricShard *shard = metric_shards; shard; shard = shard->next) {
+        for (int counter = 0; counter < CONTENTION_COUNT; counter++) {
+            totals[counter] += atomic_load_explicit(&shard->contention[counter], memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&metric_shards_lock);
+}
+
+/**
+ * Sum every thread's counters
+ */
+void metric_collect(MetricTotals totals[METRIC_COUNT]) {
+    memset(totals, 0, sizeof(MetricTotals) * METRIC_COUNT);
+    
+    pthread_mutex_lock(&metric_shards_lock);
+    for (const MetricShard *shard = metric_shards; shard; shard = shard->next) {
+        for (int metric = 0; metric < METRIC_COUNT; metric++) {
+            const MetricCounters *counters = &shard->counters[metric];
+            MetricTotals *into = &totals[metric];
+            into->count += atomic_load_explicit(&counters->count, memory_order_relaxed);
+            into->errors += atomic_load_explicit(&counters->errors, memory_order_relaxed);
+            into->total_ns += atomic_load_explicit(&counters->total_ns, memory_order_relaxed);
+            uint64_t max_ns = atomic_load_explicit(&counters->max_ns, memory_order_relaxed);
+            if (max_ns > into->max_ns) into->max_ns = max_ns;
+            for (int bucket = 0; bucket < METRIC_BUCKETS; bucket++) {
+                into->buckets[bucket] += atomic_load_explicit(&counters->buckets[bucket],
+                                                              memory_order_relaxed);
+            }
+        }
+    }
+    pthread_mutex_unlock(&metric_shards_lock);
+}
+
+/**
+ * Latency at a percentile, as the upper limit of the bucket holding it and
+ * never more than the largest latency seen
+ */
+uint64_t metric_percentile_ns(const MetricTotals *totals, double percent) {
+    uint64_t histogram_count = 0;
+    for (int bucket = 0; bucket < METRIC_BUCKETS; bucket++) histogram_count += totals->buckets[bucket];
+    if (histogram_count == 0) return 0;
+    
+    uint64_t rank = (uint64_t)ceil(histogram_count * percent / 100.0);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < METRIC_BUCKETS; bucket++) {
+        seen += totals->buckets[bucket];
+        if (seen >= rank) {
+            uint64_t limit = metric_bucket_limit(bucket);
+            return limit < totals->max_ns ? limit : totals->max_ns;
+        }
+    }
+    return totals->max_ns;
+}
+
+/**
+ * Print call counts and latency percentiles of every operation
+ */
+void print_metrics(void) {
+    FILE *out = session_output();
+    MetricTotals *totals = malloc(sizeof(MetricTotals) * METRIC_COUNT);
+    if (!totals) {
+        fprintf(out, "Error: Out of memory!\n");
+        return;
+    }
+    metric_collect(totals);
+    
+    fprintf(out, "\n");
+    print_separator('=', 90);
+    fprintf(out, "                         OPERATION METRICS\n");
+    print_separator('=', 90);
+    fprintf(out, "%-14s %10s %8s %10s %10s %10s %10s %10s\n", "Operation", "Calls", "Errors",
+            "Mean us", "p50 us", "p90 us", "p99 us", "Max us");
+    print_separator('-', 90);
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        const MetricTotals *metric_totals = &totals[metric];
+        fprintf(out, "%-14s %10llu %8llu ", metric_names[metric],
+                (unsigned long long)metric_totals->count, (unsigned long long)metric_totals->errors);
+        if (metric_totals->count == 0) {
+            fprintf(out, "%10s %10s %10s %10s %10s\n", "-", "-", "-", "-", "-");
+            continue;
+        }
+        fprintf(out, "%10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                metric_totals->total_ns / 1000.0 / metric_totals->count,
+                metric_percentile_ns(metric_totals, 50) / 1000.0,
+                metric_percentile_ns(metric_totals, 90) / 1000.0,
+                metric_percentile_ns(metric_totals, 99) / 1000.0,
+                metric_totals->max_ns / 1000.0);
+    }
+    print_separator('-', 90);
+    
+    uint64_t contention[CONTENTION_COUNT];
+    contention_collect(contention);
+    fprintf(out, "Contention:");
+    for (int counter = 0; counter < CONTENTION_COUNT; counter++) {
+        fprintf(out, "  %s %llu", contention_names[counter], (unsigned long long)contention[counter]);
+    }
+    fprintf(out, "\n");
+    print_separator('=', 90);
+    fprintf(out, "\n");
+    free(totals);
+}
+
+/**
+ * Write the metrics in the Prometheus text exposition format. Histogram
+ * buckets are the powers of two of nanoseconds, which line up exactly
+ * with the internal buckets.
+ */
+void write_prometheus_metrics(FILE *out) {
+    MetricTotals *totals = malloc(sizeof(MetricTotals) * METRIC_COUNT);
+    if (!totals) return;
+    metric_collect(totals);
+    
+    fprintf(out, "# HELP sms_operation_duration_seconds Latency of record operations and reports.\n");
+    fprintf(out, "# TYPE sms_operation_duration_seconds histogram\n");
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        const MetricTotals *metric_totals = &totals[metric];
+        uint64_t below = 0;
+        int bucket = 0;
+        for (int shift = METRIC_PROMETHEUS_MIN_SHIFT; shift <= METRIC_PROMETHEUS_MAX_SHIFT; shift++) {
+            uint64_t bound = (uint64_t)1 << shift;
+            for (; bucket < METRIC_BUCKETS && metric_bucket_limit(bucket) <= bound; bucket++) {
+                below += metric_totals->buckets[bucket];
+            }
+            fprintf(out, "sms_operation_duration_seconds_bucket{operation=\"%s\",le=\"%.12g\"} %llu\n",
+                    metric_names[metric], bound / 1e9, (unsigned long long)below);
+        }
+        fprintf(out, "sms_operation_duration_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu\n",
+                metric_names[metric], (unsigned long long)metric_totals->count);
+        fprintf(out, "sms_operation_duration_seconds_sum{operation=\"%s\"} %.9f\n",
+                metric_names[metric], metric_totals->total_ns / 1e9);
+        fprintf(out, "sms_operation_duration_seconds_count{operation=\"%s\"} %llu\n",
+                metric_names[metric], (unsigned long long)metric_totals->count);
+    }
+    
+    fprintf(out, "# HELP sms_operation_errors_total Calls that failed or were rejected.\n");
+    fprintf(out, "# TYPE sms_operation_errors_total counter\n");
+    for (int metric = 0; metric < METRIC_COUNT; metric++) {
+        fprintf(out, "sms_operation_errors_total{operation=\"%s\"} %llu\n", metric_names[metric],
+                (unsigned long long)totals[metric].errors);
+    }
+    
+    uint64_t contention[CONTENTION_COUNT];
+    contention_collect(contention);
+    fprintf(out, "# HELP sms_contention_total Waits for contended entity locks and seat claim retries.\n");
+    fprintf(out, "# TYPE sms_contention_total counter\n");
+    for (int counter = 0; counter < CONTENTION_COUNT; counter++) {
+        fprintf(out, "sms_contention_total{kind=\"%s\"} %llu\n", contention_names[counter],
+                (unsigned long long)contention[counter]);
+    }
+    
+    pthread_mutex_lock(&stats_lock);
+    SystemStats stats = system_stats;
+    pthread_mutex_unlock(&stats_lock);
+    fprintf(out, "# HELP sms_records Records in each table.\n");
+    fprintf(out, "# TYPE sms_records gauge\n");
+    fprintf(out, "sms_records{table=\"students\"} %d\n", stats.total_students);
+    fprintf(out, "sms_records{table=\"courses\"} %d\n", stats.total_courses);
+    fprintf(out, "sms_records{table=\"enrollments\"} %d\n", stats.total_enrollments);
+    free(totals);
+}
+
+/**
+ * Write the Prometheus dump to path, or to the session output when path
+ * is "-". Returns 0 on failure.
+ */
+int dump_prometheus_metrics(const char *path) {
+    int to_output = strcmp(path, "-") == 0;
+    FILE *out = to_output ? session_output() : fopen(path, "w");
+    if (!out) {
+        log_operation(LOG_ERROR, LOG_OP_METRICS, "Failed to open metrics file");
+        return 0;
+    }
+    
+    write_prometheus_metrics(out);
+    int ok = to_output ? fflush(out) == 0 : fclose(out) == 0;
+    if (!ok) log_operation(LOG_ERROR, LOG_OP_METRICS, "Failed to write metrics file");
+    return ok;
+}
+
+/**
+ * Show the metrics table and optionally write the Prometheus dump
+ */
+void metrics_interactive(void) {
+    char path[FILE_BUFFER_SIZE];
+    
+    print_metrics();
+    printf("Write Prometheus metrics to file (Enter to skip): ");
+    if (!fgets(path, sizeof(path), stdin)) return;
+    path[strcspn(path, "\n")] = 0;
+    if (path[0] == '\0') return;
+    
+    if (dump_prometheus_metrics(path)) {
+        printf("✓ Metrics written to %s\n", path);
+    } else {
+        printf("Error: Could not write metrics to '%s'!\n", path);
+    }
+}
+
+/* ============================================================================
+   STORAGE FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Allocate zeroed, aligned memory from the arena
+ */
+void *arena_alloc(Arena *arena, size_t size) {
+    size_t header = (sizeof(ArenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    
+    pthread_mutex_lock(&arena->lock);
+    ArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = header + size > ARENA_BLOCK_SIZE ? header + size : ARENA_BLOCK_SIZE;
+        /* calloc'd blocks are lazily backed by the OS, so untouched space costs no RSS */
+        block = calloc(1, block_size);
+        if (!block) {
+            pthread_mutex_unlock(&arena->lock);
+            return NULL;
+        }
+        block->next = arena->head;
+        block->size = block_size;
+        block->used = header;
+        arena->head = block;
+        arena->bytes_reserved += block_size;
+    }
+    
+    void *memory = (char *)block + block->used;
+    block->used += size;
+    pthread_mutex_unlock(&arena->lock);
+    return memory;
+}
+
+/**
+ * Return the record at a position that is already allocated
+ */
+void *table_at(const ChunkedTable *table, int index) {
+    return table->chunks[index >> TABLE_CHUNK_SHIFT] +
+           (size_t)(index & (TABLE_CHUNK_SIZE - 1)) * table->record_size;
+}
+
+/**
+ * Make sure a record slot exists, allocating its chunk if needed.
+ * Returns the zeroed slot, or NULL when storage could not be allocated.
+ */
+void *table_reserve(ChunkedTable *table, int index) {
+    int chunk = index >> TABLE_CHUNK_SHIFT;
+    if (index < 0 || chunk >= TABLE_MAX_CHUNKS) return NULL;
+    
+    if (!table->chunks[chunk]) {
+        table->chunks[chunk] = arena_alloc(&record_arena, table->record_size * TABLE_CHUNK_SIZE);
+        if (!table->chunks[chunk]) return NULL;
+    }
+    return table_at(table, index);
+}
+
+Student *student_at(int index) {
+    return table_at(&student_table, index);
+}
+
+StudentProfile *student_profile_at(int index) {
+    return table_at(&student_profile_table, index);
+}
+
+Course *course_at(int index) {
+    return table_at(&course_table, index);
+}
+
+CourseDetails *course_details_at(int index) {
+    return table_at(&course_details_table, index);
+}
+
+GradeHistogram *course_histogram_at(int index) {
+    return table_at(&course_histogram_table, index);
+}
+
+/**
+ * Histogram of a course by ID. Course IDs are dense, so this needs no
+ * index lookup; the caller holds the course lock.
+ */
+GradeHistogram *course_histogram(const Course *course) {
+    return course_histogram_at(course->course_id - FIRST_COURSE_ID);
+}
+
+Enrollment *enrollment_at(int index) {
+    return table_at(&enrollment_table, index);
+}
+
+GradeRecord *grade_record_at(int index) {
+    return table_at(&grade_record_table, index);
+}
+
+/**
+ * Position of a record inside its table chunk and column block
+ */
+int table_slot(int index) {
+    return index & (TABLE_CHUNK_SIZE - 1);
+}
+
+EnrollmentColumns *enrollment_columns_at(int index) {
+    return enrollment_columns[index >> TABLE_CHUNK_SHIFT];
+}
+
+/**
+ * Make sure the column block for an enrollment exists.
+ * Returns the block, or NULL when storage could not be allocated.
+ */
+EnrollmentColumns *enrollment_columns_reserve(int index) {
+    int chunk = index >> TABLE_CHUNK_SHIFT;
+    if (index < 0 || chunk >= TABLE_MAX_CHUNKS) return NULL;
+    
+    if (!enrollment_columns[chunk]) {
+        enrollment_columns[chunk] = arena_alloc(&record_arena, sizeof(EnrollmentColumns));
+    }
+    return enrollment_columns[chunk];
+}
+
+/**
+ * Read a record count under its table lock. Rows below the returned count
+ * are fully written and stay where they are.
+ */
+int committed_count(pthread_rwlock_t *table_lock, const int *count) {
+    pthread_rwlock_rdlock(table_lock);
+    int value = *count;
+    pthread_rwlock_unlock(table_lock);
+    return value;
+}
+
+/* ============================================================================
+   COLUMN AGGREGATION KERNELS
+   ============================================================================ */
+
+void column_aggregate_init(ColumnAggregate *aggregate) {
+    aggregate->sum = 0.0;
+    aggregate->count = 0;
+    aggregate->min = FLT_MAX;
+    aggregate->max = -FLT_MAX;
+}
+
+/**
+ * Reduce values[i] over the rows where status[i] is completed and, when keys
+ * is not NULL, keys[i] equals key. Results are folded into the aggregate.
+ */
+void aggregate_completed(const int *status, const int *keys, int key,
+                         const float *values, int n, ColumnAggregate *aggregate) {
+    float sum = 0.0f;
+    int count = 0;
+    float min = aggregate->min;
+    float max = aggregate->max;
+    int i = 0;
+    
+#if defined(__AVX2__)
+    const __m256i completed = _mm256_set1_epi32(2);
+    const __m256i key_vector = _mm256_set1_epi32(key);
+    __m256 sum_vector = _mm256_setzero_ps();
+    __m256 min_vector = _mm256_set1_ps(min);
+    __m256 max_vector = _mm256_set1_ps(max);
+    __m256i count_vector = _mm256_setzero_si256();
+    
+    for (; i + 8 <= n; i += 8) {
+        __m256i mask = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(status + i)), completed);
+        if (keys) {
+            mask = _mm256_and_si256(mask, _mm256_cmpeq_epi32(
+                       _mm256_loadu_si256((const __m256i *)(keys + i)), key_vector));
+        }
+        __m256 selected = _mm256_castsi256_ps(mask);
+        __m256 value = _mm256_loadu_ps(values + i);
+        sum_vector = _mm256_add_ps(sum_vector, _mm256_and_ps(selected, value));
+        min_vector = _mm256_min_ps(min_vector, _mm256_blendv_ps(min_vector, value, selected));
+        max_vector = _mm256_max_ps(max_vector, _mm256_blendv_ps(max_vector, value, selected));
+        count_vector = _mm256_sub_epi32(count_vector, mask); /* selected lanes are -1 */
+    }
+    
+    float sum_lanes[8], min_lanes[8], max_lanes[8];
+    int count_lanes[8];
+    _mm256_storeu_ps(sum_lanes, sum_vector);
+    _mm256_storeu_ps(min_lanes, min_vector);
+    _mm256_storeu_ps(max_lanes, max_vector);
+    _mm256_storeu_si256((__m256i *)count_lanes, count_vector);
+    for (int lane = 0; lane < 8; lane++) {
+        sum += sum_lanes[lane];
+        count += count_lanes[lane];
+        if (min_lanes[lane] < min) min = min_lanes[lane];
+        if (max_lanes[lane] > max) max = max_lanes[lane];
+    }
+#elif defined(__SSE2__)
+    const __m128i completed = _mm_set1_epi32(2);
+    const __m128i key_vector = _mm_set1_epi32(key);
+    __m128 sum_vector = _mm_setzero_ps();
+    __m128 min_vector = _mm_set1_ps(min);
+    __m128 max_vector = _mm_set1_ps(max);
+    __m128i count_vector = _mm_setzero_si128();
+    
+    for (; i + 4 <= n; i += 4) {
+        __m128i mask = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(status + i)), completed);
+        if (keys) {
+            mask = _mm_and_si128(mask, _mm_cmpeq_epi32(
+                       _mm_loadu_si128((const __m128i *)(keys + i)), key_vector));
+        }
+        __m128 selected = _mm_castsi128_ps(mask);
+        __m128 value = _mm_loadu_ps(values + i);
+        /* SSE2 has no blend: take value where selected, the running bound elsewhere */
+        __m128 low = _mm_or_ps(_mm_and_ps(selected, value), _mm_andnot_ps(selected, min_vector));
+        __m128 high = _mm_or_ps(_mm_and_ps(selected, value), _mm_andnot_ps(selected, max_vector));
+        sum_vector = _mm_add_ps(sum_vector, _mm_and_ps(selected, value));
+        min_vector = _mm_min_ps(min_vector, low);
+        max_vector = _mm_max_ps(max_vector, high);
+        count_vector = _mm_sub_epi32(count_vector, mask);
+    }
+    
+    float sum_lanes[4], min_lanes[4], max_lanes[4];
+    int count_lanes[4];
+    _mm_storeu_ps(sum_lanes, sum_vector);
+    _mm_storeu_ps(min_lanes, min_vector);
+    _mm_storeu_ps(max_lanes, max_vector);
+    _mm_storeu_si128((__m128i *)count_lanes, count_vector);
+    for (int lane = 0; lane < 4; lane++) {
+        sum += sum_lanes[lane];
+        count += count_lanes[lane];
+        if (min_lanes[lane] < min) min = min_lanes[lane];
+        if (max_lanes[lane] > max) max = max_lanes[lane];
+    }
+#elif defined(__ARM_NEON)
+    const int32x4_t completed = vdupq_n_s32(2);
+    const int32x4_t key_vector = vdupq_n_s32(key);
+    float32x4_t sum_vector = vdupq_n_f32(0.0f);
+    float32x4_t min_vector = vdupq_n_f32(min);
+    float32x4_t max_vector = vdupq_n_f32(max);
+    int32x4_t count_vector = vdupq_n_s32(0);
+    
+    for (; i + 4 <= n; i += 4) {
+        uint32x4_t mask = vceqq_s32(vld1q_s32(status + i), completed);
+        if (keys) mask = vandq_u32(mask, vceqq_s32(vld1q_s32(keys + i), key_vector));
+        float32x4_t value = vld1q_f32(values + i);
+        sum_vector = vaddq_f32(sum_vector, vbslq_f32(mask, value, vdupq_n_f32(0.0f)));
+        min_vector = vminq_f32(min_vector, vbslq_f32(mask, value, min_vector));
+        max_vector = vmaxq_f32(max_vector, vbslq_f32(mask, value, max_vector));
+        count_vector = vsubq_s32(count_vector, vreinterpretq_s32_u32(mask));
+    }
+    
+    float sum_lanes[4], min_lanes[4], max_lanes[4];
+    int count_lanes[4];
+    vst1q_f32(sum_lanes, sum_vector);
+    vst1q_f32(min_lanes, min_vector);
+    vst1q_f32(max_lanes, max_vector);
+    vst1q_s32(count_lanes, count_vector);
+    for (int lane = 0; lane < 4; lane++) {
+        sum += sum_lanes[lane];
+        count += count_lanes[lane];
+        if (min_lanes[lane] < min) min = min_lanes[lane];
+        if (max_lanes[lane] > max) max = max_lanes[lane];
+    }
+#endif
+    
+    /* Scalar tail, and the whole range on targets without SIMD */
+    for (; i < n; i++) {
+        if (status[i] == 2 && (!keys || keys[i] == key)) {
+            sum += values[i];
+            count++;
+            if (values[i] < min) min = values[i];
+            if (values[i] > max) max = values[i];
+        }
+    }
+    
+    aggregate->sum += sum;
+    aggregate->count += count;
+    aggregate->min = min;
+    aggregate->max = max;
+}
+
+/**
+ * Aggregate a value column over completed enrollments, block by block.
+ * A course_id of 0 aggregates across all courses.
+ */
+void aggregate_completed_enrollments(int course_id, int value_column, ColumnAggregate *aggregate) {
+    column_aggregate_init(aggregate);
+    int count = committed_count(&enrollment_table_lock, &enrollment_count);
+    
+    for (int start = 0; start < count; start += TABLE_CHUNK_SIZE) {
+        EnrollmentColumns *columns = enrollment_columns_at(start);
+        int n = count - start < TABLE_CHUNK_SIZE ? count - start : TABLE_CHUNK_SIZE;
+        const float *values = value_column == COLUMN_GRADE ? columns->grade : columns->credit_points;
+        
+        /* Per-block partial sums are folded into a double to keep precision */
+        aggregate_completed(columns->status, course_id ? columns->course_id : NULL, course_id,
+                            values, n, aggregate);
+    }
+}
+
+/* ============================================================================
+   INDEX FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Hash a record ID into a slot of an index with the given capacity
+ */
+unsigned int hash_id(int id, int capacity) {
+    unsigned int h = (unsigned int)id * 2654435769u;
+    h ^= h >> 16;
+    return h & (unsigned int)(capacity - 1);
+}
+
+/**
+ * Double the slot table of an index and re-insert every entry
+ */
+int id_index_grow(IdIndex *index) {
+    int new_capacity = index->capacity ? index->capacity * 2 : ID_INDEX_INITIAL_CAPACITY;
+    int *new_keys = calloc(new_capacity, sizeof(int));
+    int *new_positions = malloc(new_capacity * sizeof(int));
+    
+    if (!new_keys || !new_positions) {
+        free(new_keys);
+        free(new_positions);
+        return 0;
+    }
+    
+    for (int i = 0; i < index->capacity; i++) {
+        if (index->keys[i] != 0) {
+            unsigned int slot = hash_id(index->keys[i], new_capacity);
+            while (new_keys[slot] != 0) {
+                slot = (slot + 1) & (new_capacity - 1);
+            }
+            new_keys[slot] = index->keys[i];
+            new_positions[slot] = index->positions[i];
+        }
+    }
+    
+    free(index->keys);
+    free(index->positions);
+    index->keys = new_keys;
+    index->positions = new_positions;
+    index->capacity = new_capacity;
+    return 1;
+}
+
+/**
+ * Grow an index up front so that it can hold count entries without rehashing
+ */
+int id_index_reserve(IdIndex *index, int count) {
+    while (index->capacity < count * 2) {
+        if (!id_index_grow(index)) return 0;
+    }
+    return 1;
+}
+
+/**
+ * Insert or update the position stored for an ID
+ */
+int id_index_insert(IdIndex *index, int id, int position) {
+    /* Keep the load factor at or below 1/2 so probe chains stay short */
+    if ((index->count + 1) * 2 > index->capacity && !id_index_grow(index)) {
+        return 0;
+    }
+    
+    unsigned int slot = hash_id(id, index->capacity);
+    while (index->keys[slot] != 0 && index->keys[slot] != id) {
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    
+    if (index->keys[slot] == 0) {
+        index->keys[slot] = id;
+        index->count++;
+    }
+    index->positions[slot] = position;
+    return 1;
+}
+
+/**
+ * Remove every entry, keeping the slot table
+ */
+void id_index_clear(IdIndex *index) {
+    if (index->capacity > 0) memset(index->keys, 0, (size_t)index->capacity * sizeof(int));
+    index->count = 0;
+}
+
+/**
+ * Look up the position stored for an ID, or -1 if it is not indexed
+ */
+int id_index_find(const IdIndex *index, int id) {
+    if (index->capacity == 0 || id <= 0) return -1;
+    
+    unsigned int slot = hash_id(id, index->capacity);
+    while (index->keys[slot] != 0) {
+        if (index->keys[slot] == id) return index->positions[slot];
+        slot = (slot + 1) & (index->capacity - 1);
+    }
+    return -1;
+}
+
+/**
+ * FNV-1a hash of a string's bytes
+ */
+uint32_t hash_text(const char *text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Text of an interned ID; "" for -1, which marks no value
+ */
+const char *interned_text(int id) {
+    if (id < 0) return "";
+    return *(const char **)table_at(&interned.entries, id);
+}
+
+/**
+ * Slot holding text, or the empty slot where it would go. The caller
+ * holds the intern lock.
+ */
+unsigned int intern_slot(const char *text, size_t length) {
+    unsigned int slot = hash_text(text, length) & (unsigned int)(interned.capacity - 1);
+    while (interned.slots[slot] != 0) {
+        const char *stored = interned_text(interned.slots[slot] - 1);
+        if ((unsigned char)stored[-1] == length && memcmp(stored, text, length) == 0) break;
+        slot = (slot + 1) & (interned.capacity - 1);
+    }
+    return slot;
+}
+
+/**
+ * Double the slot table and re-insert every ID
+ */
+int intern_grow(void) {
+    int old_capacity = interned.capacity;
+    int *old_slots = interned.slots;
+    int new_capacity = old_capacity ? old_capacity * 2 : INTERN_INITIAL_CAPACITY;
+    int *new_slots = calloc(new_capacity, sizeof(int));
+    if (!new_slots) return 0;
+    
+    interned.slots = new_slots;
+    interned.capacity = new_capacity;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old_slots[i] == 0) continue;
+        const char *text = interned_text(old_slots[i] - 1);
+        new_slots[intern_slot(text, (unsigned char)text[-1])] = old_slots[i];
+    }
+    free(old_slots);
+    return 1;
+}
+
+/**
+ * Give an existing pooled string the next ID. The caller holds the intern
+ * lock exclusively.
+ */
+int intern_add(const char *text) {
+    size_t length = (unsigned char)text[-1];
+    if ((interned.count + 1) * 2 > interned.capacity && !intern_grow()) return -1;
+    
+    const char **entry = table_reserve(&interned.entries, interned.count);
+    if (!entry) return -1;
+    *entry = text;
+    interned.slots[intern_slot(text, length)] = interned.count + 1;
+    interned.pool_bytes += length + 2;
+    return interned.count++;
+}
+
+/**
+ * Look up the ID of a string without interning it.
+ * Returns -1 if the string has never been interned.
+ */
+int intern_find(const char *text) {
+    size_t length = strlen(text);
+    if (length > INTERN_MAX_LENGTH) return -1;
+    
+    pthread_rwlock_rdlock(&interned.lock);
+    int id = -1;
+    if (interned.capacity > 0) {
+        int stored = interned.slots[intern_slot(text, length)];
+        id = stored - 1;
+    }
+    pthread_rwlock_unlock(&interned.lock);
+    return id;
+}
+
+/**
+ * Return the ID of a string, adding it to the pool on first use. Text
+ * longer than INTERN_MAX_LENGTH is truncated.
+ * Returns -1 when the pool could not grow.
+ */
+int intern_string(const char *text) {
+    size_t length = strlen(text);
+    if (length > INTERN_MAX_LENGTH) length = INTERN_MAX_LENGTH;
+    
+    pthread_rwlock_wrlock(&interned.lock);
+    if (interned.capacity > 0) {
+        int stored = interned.slots[intern_slot(text, length)];
+        if (stored != 0) {
+            pthread_rwlock_unlock(&interned.lock);
+            return stored - 1;
+        }
+    }
+    
+    if (!interned.block || interned.block_used + length + 2 > INTERN_BLOCK_SIZE) {
+        interned.block = arena_alloc(&record_arena, INTERN_BLOCK_SIZE);
+        interned.block_used = 0;
+        if (!interned.block) {
+            pthread_rwlock_unlock(&interned.lock);
+            return -1;
+        }
+    }
+    char *pooled = interned.block + interned.block_used;
+    pooled[0] = (char)length;
+    memcpy(pooled + 1, text, length);
+    pooled[length + 1] = '\0';
+    
+    int id = intern_add(pooled + 1);
+    if (id != -1) interned.block_used += length + 2;
+    pthread_rwlock_unlock(&interned.lock);
+    return id;
+}
+
+/**
+ * Find the array position of a student, or -1 if not found
+ */
+int find_student(int student_id) {
+    return id_index_find(&student_id_index, student_id);
+}
+
+/**
+ * Find the array position of a course, or -1 if not found
+ */
+int find_course(int course_id) {
+    return id_index_find(&course_id_index, course_id);
+}
+
+/**
+ * Find the array position of an enrollment, or -1 if not found
+ */
+int find_enrollment(int enrollment_id) {
+    return id_index_find(&enrollment_id_index, enrollment_id);
+}
+
+/**
+ * Copy the leading part of a student's name into the hot record
+ */
+void set_student_name_key(Student *student, const char *name) {
+    size_t length = strlen(name);
+    student->name_truncated = length >= NAME_KEY_LENGTH;
+    if (student->name_truncated) length = NAME_KEY_LENGTH - 1;
+    memcpy(student->name_key, name, length);
+    student->name_key[length] = '\0';
+}
+
+/**
+ * Check whether a student's name contains a string, reading the profile
+ * only when the name does not fit in the hot name key
+ */
+int student_name_contains(int index, const char *text) {
+    Student *student = student_at(index);
+    if (strstr(student->name_key, text)) return 1;
+    return student->name_truncated && strstr(student_profile_at(index)->name, text);
+}
+
+/**
+ * Fold a character into the 6-bit trigram alphabet. Case is folded and
+ * rarer characters share codes, so trigram hits are always re-checked.
+ */
+unsigned int trigram_code(unsigned char c) {
+    if (isalpha(c)) return 1 + (tolower(c) - 'a');  /* 1..26 */
+    if (isdigit(c)) return 27 + (c - '0');           /* 27..36 */
+    if (c == ' ') return 37;
+    return 38 + c % 26;                              /* 38..63 */
+}
+
+unsigned int trigram_key(unsigned int a, unsigned int b, unsigned int c) {
+    return (a << (2 * TRIGRAM_CHAR_BITS)) | (b << TRIGRAM_CHAR_BITS) | c;
+}
+
+/**
+ * Add a student to the posting lists of every trigram in its name,
+ * including the two boundary trigrams that anchor the name's start
+ */
+int name_index_add(int index, const char *name) {
+    unsigned int previous2 = TRIGRAM_BOUNDARY, previous1 = TRIGRAM_BOUNDARY;
+    
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        unsigned int code = trigram_code(*p);
+        TrigramList *list = &name_trigrams[trigram_key(previous2, previous1, code)];
+        previous2 = previous1;
+        previous1 = code;
+        
+        /* Lists are appended in index order, so repeats are adjacent */
+        if (list->count > 0 && list->students[list->count - 1] == index) continue;
+        if (list->count == list->capacity) {
+            int capacity = list->capacity ? list->capacity * 2 : 4;
+            int *students = realloc(list->students, capacity * sizeof(int));
+            if (!students) return 0;
+            list->students = students;
+            list->capacity = capacity;
+        }
+        list->students[list->count++] = index;
+    }
+    return 1;
+}
+
+/**
+ * Find text in name, optionally ignoring case
+ * Returns the offset of the first match, or -1
+ */
+int name_match_offset(const char *name, const char *text, size_t text_length, int ignore_case) {
+    if (!ignore_case) {
+        const char *match = strstr(name, text);
+        return match ? (int)(match - name) : -1;
+    }
+    for (const char *start = name; *start; start++) {
+        size_t i = 0;
+        while (i < text_length && start[i] &&
+               tolower((unsigned char)start[i]) == tolower((unsigned char)text[i])) {
+            i++;
+        }
+        if (i == text_length) return (int)(start - name);
+    }
+    return text_length == 0 ? 0 : -1;
+}
+
+/**
+ * Rank a match: name prefixes first, then word starts, then the rest,
+ * with shorter names ahead within each group
+ */
+int name_match_rank(const char *name, int offset) {
+    int group = offset == 0 ? 0 : (name[offset - 1] == ' ' ? 1 : 2);
+    return group * (MAX_NAME_LENGTH + 1) + (int)strlen(name);
+}
+
+/**
+ * Check one candidate and, if it matches, keep it among the best limit
+ * matches seen so far (kept sorted by rank)
+ */
+void name_search_consider(int index, const char *text, size_t text_length, int flags,
+                          NameMatch *best, int limit, int *kept, int *total) {
+    Student *student = student_at(index);
+    if (!student->is_active) return;
+    
+    const char *name = student->name_truncated ? student_profile_at(index)->name : student->name_key;
+    int offset = name_match_offset(name, text, text_length, flags & SEARCH_IGNORE_CASE);
+    if (offset == -1 || ((flags & SEARCH_PREFIX) && offset != 0)) return;
+    
+    (*total)++;
+    int rank = name_match_rank(name, offset);
+    if (*kept == limit && rank >= best[limit - 1].rank) return;
+    
+    int position = *kept < limit ? (*kept)++ : limit - 1;
+    while (position > 0 && best[position - 1].rank > rank) {
+        best[position] = best[position - 1];
+        position--;
+    }
+    best[position].student_index = index;
+    best[position].rank = rank;
+}
+
+/**
+ * Search student names by substring or prefix. Candidates come from the
+ * shortest posting list among the query's trigrams and are verified
+ * against the stored name. Queries too short to form a trigram fall back
+ * to a scan of the hot name keys.
+ * Returns the number of ranked matches stored in best (at most limit);
+ * total receives the number of matches overall.
+ */
+int search_students(const char *text, int flags, NameMatch *best, int limit, int *total) {
+    size_t text_length = strlen(text);
+    int kept = 0;
+    *total = 0;
+    
+    /* Prefix queries are anchored with boundary codes, substring queries are not */
+    unsigned int codes[MAX_NAME_LENGTH + 2];
+    int code_count = 0;
+    if (flags & SEARCH_PREFIX) {
+        codes[code_count++] = TRIGRAM_BOUNDARY;
+        codes[code_count++] = TRIGRAM_BOUNDARY;
+    }
+    for (size_t i = 0; i < text_length && code_count < MAX_NAME_LENGTH + 2; i++) {
+        codes[code_count++] = trigram_code((unsigned char)text[i]);
+    }
+    
+    if (text_length == 0 || code_count < 3) {
+        for (int i = 0; i < student_count; i++) {
+            name_search_consider(i, text, text_length, flags, best, limit, &kept, total);
+        }
+        return kept;
+    }
+    
+    const TrigramList *shortest = NULL;
+    for (int i = 0; i + 2 < code_count; i++) {
+        const TrigramList *list = &name_trigrams[trigram_key(codes[i], codes[i + 1], codes[i + 2])];
+        if (!shortest || list->count < shortest->count) shortest = list;
+    }
+    for (int i = 0; i < shortest->count; i++) {
+        name_search_consider(shortest->students[i], text, text_length, flags, best, limit, &kept, total);
+    }
+    return kept;
+}
+
+/**
+ * Append an enrollment to the per-student and per-course enrollment lists
+ */
+void link_enrollment(int enrollment_index, int student_index, int course_index) {
+    Student *student = student_at(student_index);
+    Course *course = course_at(course_index);
+    
+    if (student->last_enrollment == -1) {
+        student->first_enrollment = enrollment_index;
+    } else {
+        enrollment_at(student->last_enrollment)->next_student_enrollment = enrollment_index;
+    }
+    student->last_enrollment = enrollment_index;
+    
+    if (course->last_enrollment == -1) {
+        course->first_enrollment = enrollment_index;
+    } else {
+        enrollment_at(course->last_enrollment)->next_course_enrollment = enrollment_index;
+    }
+    course->last_enrollment = enrollment_index;
+}
+
+/* ============================================================================
+   LOCKING FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Initialise the entity lock shards; called once at startup
+ */
+void locks_init(void) {
+    for (int i = 0; i < LOCK_SHARDS; i++) {
+        pthread_rwlock_init(&student_locks[i], NULL);
+        pthread_rwlock_init(&course_locks[i], NULL);
+    }
+}
+
+pthread_rwlock_t *student_lock(int student_id) {
+    return &student_locks[(unsigned int)student_id % LOCK_SHARDS];
+}
+
+pthread_rwlock_t *course_lock(int course_id) {
+    return &course_locks[(unsigned int)course_id % LOCK_SHARDS];
+}
+
+/**
+ * Take an entity lock, counting a CONTENTION_* wait when another thread
+ * holds it
+ */
+void lock_write(pthread_rwlock_t *lock, int contention) {
+    if (pthread_rwlock_trywrlock(lock) == 0) return;
+    contention_record(contention);
+    pthread_rwlock_wrlock(lock);
+}
+
+void lock_read(pthread_rwlock_t *lock, int contention) {
+    if (pthread_rwlock_tryrdlock(lock) == 0) return;
+    contention_record(contention);
+    pthread_rwlock_rdlock(lock);
+}
+
+/**
+ * Look up a record position by ID under the table's shared lock
+ */
+int lookup_student(int student_id) {
+    pthread_rwlock_rdlock(&student_table_lock);
+    int index = find_student(student_id);
+    pthread_rwlock_unlock(&student_table_lock);
+    return index;
+}
+
+int lookup_course(int course_id) {
+    pthread_rwlock_rdlock(&course_table_lock);
+    int index = find_course(course_id);
+    pthread_rwlock_unlock(&course_table_lock);
+    return index;
+}
+
+int lookup_enrollment(int enrollment_id) {
+    pthread_rwlock_rdlock(&enrollment_table_lock);
+    int index = find_enrollment(enrollment_id);
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    return index;
+}
+
+/**
+ * Look up a live enrollment and take its student and course locks
+ * exclusively, storing both records. Archiving may move or remove the row
+ * before the locks are taken, so its position is looked up again under
+ * them. Returns the position, or -1 with no locks held.
+ */
+int lock_enrollment(int enrollment_id, Student **student, Course **course) {
+    int student_id = 0, course_id = 0;
+    pthread_rwlock_rdlock(&enrollment_table_lock);
+    int index = find_enrollment(enrollment_id);
+    if (index != -1) {
+        student_id = enrollment_columns_at(index)->student_id[table_slot(index)];
+        course_id = enrollment_columns_at(index)->course_id[table_slot(index)];
+    }
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    if (index == -1) return -1;
+    
+    *student = student_at(lookup_student(student_id));
+    *course = course_at(lookup_course(course_id));
+    lock_write(student_lock(student_id), CONTENTION_STUDENT_LOCK);
+    lock_write(course_lock(course_id), CONTENTION_COURSE_LOCK);
+    index = lookup_enrollment(enrollment_id);
+    if (index == -1) {
+        pthread_rwlock_unlock(course_lock(course_id));
+        pthread_rwlock_unlock(student_lock(student_id));
+    }
+    return index;
+}
+
+/**
+ * Stop every writer, for operations that read all tables at once such as
+ * snapshots and exports
+ */
+void lock_all_records(void) {
+    for (int i = 0; i < LOCK_SHARDS; i++) pthread_rwlock_wrlock(&student_locks[i]);
+    for (int i = 0; i < LOCK_SHARDS; i++) pthread_rwlock_wrlock(&course_locks[i]);
+    pthread_rwlock_wrlock(&student_table_lock);
+    pthread_rwlock_wrlock(&course_table_lock);
+    pthread_rwlock_wrlock(&enrollment_table_lock);
+    pthread_rwlock_wrlock(&assessment_table_lock);
+}
+
+/**
+ * Stop every writer but let readers continue, for whole-table reports
+ */
+void lock_all_records_shared(void) {
+    for (int i = 0; i < LOCK_SHARDS; i++) pthread_rwlock_rdlock(&student_locks[i]);
+    for (int i = 0; i < LOCK_SHARDS; i++) pthread_rwlock_rdlock(&course_locks[i]);
+    pthread_rwlock_rdlock(&student_table_lock);
+    pthread_rwlock_rdlock(&course_table_lock);
+    pthread_rwlock_rdlock(&enrollment_table_lock);
+    pthread_rwlock_rdlock(&assessment_table_lock);
+}
+
+void unlock_all_records(void) {
+    pthread_rwlock_unlock(&assessment_table_lock);
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    pthread_rwlock_unlock(&course_table_lock);
+    pthread_rwlock_unlock(&student_table_lock);
+    for (int i = LOCK_SHARDS - 1; i >= 0; i--) pthread_rwlock_unlock(&course_locks[i]);
+    for (int i = LOCK_SHARDS - 1; i >= 0; i--) pthread_rwlock_unlock(&student_locks[i]);
+}
+
+/* ============================================================================
+   COLD ARCHIVE
+   ============================================================================ */
+
+/**
+ * Term of a timestamp in UTC, so replaying an archive puts every enrollment
+ * in the same term whatever time zone the process runs in
+ */
+int term_of(time_t when) {
+    struct tm tm_info;
+    gmtime_r(&when, &tm_info);
+    return (tm_info.tm_year + 1900) * 2 + (tm_info.tm_mon >= 6 ? TERM_FALL : TERM_SPRING);
+}
+
+/**
+ * Term number of a year and "spring" or "fall", ignoring case.
+ * Returns -1 if the half is not recognised.
+ */
+int term_number(int year, const char *half) {
+    if (year < 1900 || year > 9999) return -1;
+    if (strcasecmp(half, "spring") == 0) return year * 2 + TERM_SPRING;
+    if (strcasecmp(half, "fall") == 0) return year * 2 + TERM_FALL;
+    return -1;
+}
+
+void format_term(int term, char *text, size_t size) {
+    snprintf(text, size, "%s %d", term % 2 == TERM_FALL ? "Fall" : "Spring", term / 2);
+}
+
+/**
+ * Number of bits needed for values from 0 to range
+ */
+int bit_width(uint32_t range) {
+    int bits = 0;
+    while (bits < 32 && (range >> bits) != 0) bits++;
+    return bits;
+}
+
+/**
+ * Bytes for count values of width bits, with slack so that any value can be
+ * read or written as one unaligned 64-bit word
+ */
+size_t packed_size(int count, int width) {
+    return ((size_t)count * width + 7) / 8 + sizeof(uint64_t);
+}
+
+/**
+ * Store value as element index of a bit-packed array; the array starts zeroed
+ */
+void bits_put(uint8_t *data, int index, int width, uint32_t value) {
+    if (width == 0) return;
+    uint64_t position = (uint64_t)index * width;
+    uint64_t word;
+    memcpy(&word, data + (position >> 3), sizeof(word));
+    word |= (uint64_t)value << (position & 7);
+    memcpy(data + (position >> 3), &word, sizeof(word));
+}
+
+uint32_t bits_get(const uint8_t *data, int index, int width) {
+    if (width == 0) return 0;
+    uint64_t position = (uint64_t)index * width;
+    uint64_t word;
+    memcpy(&word, data + (position >> 3), sizeof(word));
+    return (uint32_t)((word >> (position & 7)) & ((1ull << width) - 1));
+}
+
+/**
+ * LEB128 varints: seven bits per byte, low bits first, high bit set on all
+ * but the last byte
+ */
+int varint_size(uint32_t value) {
+    int bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        bytes++;
+    }
+    return bytes;
+}
+
+uint8_t *varint_put(uint8_t *out, uint32_t value) {
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+uint32_t varint_get(const uint8_t **in) {
+    const uint8_t *bytes = *in;
+    uint32_t value = 0;
+    int shift = 0;
+    while (*bytes & 0x80) {
+        value |= (uint32_t)(*bytes++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)*bytes++ << shift;
+    *in = bytes;
+    return value;
+}
+
+/**
+ * A grade in hundredths of a point, or -1 if that would not give back
+ * exactly the same float
+ */
+int grade_hundredths(float grade) {
+    if (!(grade >= MIN_GRADE && grade <= MAX_GRADE)) return -1;
+    long hundredths = lrintf(grade * 100.0f);
+    return (float)hundredths / 100.0f == grade ? (int)hundredths : -1;
+}
+
+int archive_block_count(const ArchiveSegment *segment) {
+    return (segment->row_count + ARCHIVE_BLOCK_ROWS - 1) / ARCHIVE_BLOCK_ROWS;
+}
+
+/**
+ * Pack enrollment rows into a new segment for one term. The candidates are
+ * sorted by student and then enrollment ID, and the caller holds every
+ * record lock. Returns NULL when out of memory.
+ */
+ArchiveSegment *archive_build_segment(int term, const ArchiveCandidate *rows, int count) {
+    ArchiveSegment layout;
+    memset(&layout, 0, sizeof(layout));
+    layout.term = term;
+    layout.row_count = count;
+    layout.min_student_id = rows[0].student_id;
+    layout.max_student_id = rows[count - 1].student_id;
+    layout.min_enrollment_id = layout.max_enrollment_id = rows[0].enrollment_id;
+    layout.min_course_id = enrollment_columns_at(rows[0].index)->course_id[table_slot(rows[0].index)];
+    layout.min_credits = enrollment_columns_at(rows[0].index)->credits[table_slot(rows[0].index)];
+    layout.min_date = enrollment_at(rows[0].index)->enrollment_date;
+    int max_course_id = layout.min_course_id, max_credits = layout.min_credits;
+    int64_t max_date = layout.min_date;
+    int quantised = 1;
+    size_t student_bytes = 0;
+    
+    for (int r = 0; r < count; r++) {
+        const EnrollmentColumns *columns = enrollment_columns_at(rows[r].index);
+        int slot = table_slot(rows[r].index);
+        int64_t date = enrollment_at(rows[r].index)->enrollment_date;
+        if (rows[r].enrollment_id < layout.min_enrollment_id) layout.min_enrollment_id = rows[r].enrollment_id;
+        if (rows[r].enrollment_id > layout.max_enrollment_id) layout.max_enrollment_id = rows[r].enrollment_id;
+        if (columns->course_id[slot] < layout.min_course_id) layout.min_course_id = columns->course_id[slot];
+        if (columns->course_id[slot] > max_course_id) max_course_id = columns->course_id[slot];
+        if (columns->credits[slot] < layout.min_credits) layout.min_credits = columns->credits[slot];
+        if (columns->credits[slot] > max_credits) max_credits = columns->credits[slot];
+        if (date < layout.min_date) layout.min_date = date;
+        if (date > max_date) max_date = date;
+        if (grade_hundredths(columns->grade[slot]) == -1) quantised = 0;
+        if (r % ARCHIVE_BLOCK_ROWS != 0) {
+            student_bytes += varint_size((uint32_t)(rows[r].student_id - rows[r - 1].student_id));
+        }
+    }
+    
+    layout.enrollment_id_bits = bit_width((uint32_t)(layout.max_enrollment_id - layout.min_enrollment_id));
+    layout.course_bits = bit_width((uint32_t)(max_course_id - layout.min_course_id));
+    layout.credits_bits = bit_width((uint32_t)(max_credits - layout.min_credits));
+    layout.grade_bits = quantised ? ARCHIVE_GRADE_BITS : ARCHIVE_RAW_GRADE_BITS;
+    layout.date_bits = bit_width((uint32_t)(max_date - layout.min_date)); /* one term spans well under 2^32 s */
+    
+    size_t offset = sizeof(ArchiveSegment);
+    layout.blocks = (uint32_t)offset;
+    offset += (size_t)archive_block_count(&layout) * sizeof(ArchiveBlock);
+    layout.students = (uint32_t)offset;
+    offset += student_bytes;
+    layout.enrollment_ids = (uint32_t)offset;
+    offset += packed_size(count, layout.enrollment_id_bits);
+    layout.courses = (uint32_t)offset;
+    offset += packed_size(count, layout.course_bits);
+    layout.credits = (uint32_t)offset;
+    offset += packed_size(count, layout.credits_bits);
+    layout.grades = (uint32_t)offset;
+    offset += packed_size(count, layout.grade_bits);
+    layout.dates = (uint32_t)offset;
+    offset += packed_size(count, layout.date_bits);
+    layout.dropped = (uint32_t)offset;
+    offset += packed_size(count, 1);
+    offset = (offset + 7) & ~(size_t)7;
+    if (offset > UINT32_MAX) return NULL;
+    layout.size = (uint32_t)offset;
+    
+    uint8_t *data = calloc(1, offset);
+    if (!data) return NULL;
+    memcpy(data, &layout, sizeof(layout));
+    ArchiveBlock *blocks = (ArchiveBlock *)(data + layout.blocks);
+    uint8_t *student_out = data + layout.students;
+    
+    for (int r = 0; r < count; r++) {
+        const EnrollmentColumns *columns = enrollment_columns_at(rows[r].index);
+        int slot = table_slot(rows[r].index);
+        if (r % ARCHIVE_BLOCK_ROWS == 0) {
+            blocks[r / ARCHIVE_BLOCK_ROWS].first_student_id = rows[r].student_id;
+            blocks[r / ARCHIVE_BLOCK_ROWS].student_offset = (uint32_t)(student_out - (data + layout.students));
+        } else {
+            student_out = varint_put(student_out, (uint32_t)(rows[r].student_id - rows[r - 1].student_id));
+        }
+        bits_put(data + layout.enrollment_ids, r, layout.enrollment_id_bits,
+                 (uint32_t)(rows[r].enrollment_id - layout.min_enrollment_id));
+        bits_put(data + layout.courses, r, layout.course_bits,
+                 (uint32_t)(columns->course_id[slot] - layout.min_course_id));
+        bits_put(data + layout.credits, r, layout.credits_bits,
+                 (uint32_t)(columns->credits[slot] - layout.min_credits));
+        uint32_t grade;
+        if (quantised) grade = (uint32_t)grade_hundredths(columns->grade[slot]);
+        else memcpy(&grade, &columns->grade[slot], sizeof(grade));
+        bits_put(data + layout.grades, r, layout.grade_bits, grade);
+        bits_put(data + layout.dates, r, layout.date_bits,
+                 (uint32_t)(enrollment_at(rows[r].index)->enrollment_date - layout.min_date));
+        bits_put(data + layout.dropped, r, 1, columns->status[slot] == 3);
+    }
+    return (ArchiveSegment *)data;
+}
+
+/**
+ * Check that a segment read from a snapshot has the layout archive_build_segment
+ * gives and that its student stream decodes within bounds, so cursors can
+ * trust it. available is the number of bytes left in the section.
+ */
+int archive_segment_valid(const ArchiveSegment *segment, uint64_t available) {
+    if (available < sizeof(ArchiveSegment) || segment->size < sizeof(ArchiveSegment) ||
+        segment->size > available || segment->size % 8 != 0 || segment->row_count <= 0 ||
+        segment->enrollment_id_bits > 32 || segment->course_bits > 32 || segment->credits_bits > 32 ||
+        segment->date_bits > 32 ||
+        (segment->grade_bits != ARCHIVE_GRADE_BITS && segment->grade_bits != ARCHIVE_RAW_GRADE_BITS)) {
+        return 0;
+    }
+    
+    int count = segment->row_count;
+    uint64_t students = (uint64_t)sizeof(ArchiveSegment) + (uint64_t)archive_block_count(segment) * sizeof(ArchiveBlock);
+    uint64_t courses = (uint64_t)segment->enrollment_ids + packed_size(count, segment->enrollment_id_bits);
+    uint64_t credits = courses + packed_size(count, segment->course_bits);
+    uint64_t grades = credits + packed_size(count, segment->credits_bits);
+    uint64_t dates = grades + packed_size(count, segment->grade_bits);
+    uint64_t dropped = dates + packed_size(count, segment->date_bits);
+    uint64_t end = (dropped + packed_size(count, 1) + 7) & ~(uint64_t)7;
+    if (segment->blocks != sizeof(ArchiveSegment) || segment->students != students ||
+        segment->enrollment_ids < students || segment->courses != courses || segment->credits != credits ||
+        segment->grades != grades || segment->dates != dates || segment->dropped != dropped ||
+        segment->size != end) {
+        return 0;
+    }
+    
+    /* Each block's deltas must end inside the stream, in at most five bytes each */
+    const uint8_t *stream = (const uint8_t *)segment + segment->students;
+    uint64_t stream_size = segment->enrollment_ids - segment->students;
+    const ArchiveBlock *blocks = (const ArchiveBlock *)((const uint8_t *)segment + segment->blocks);
+    for (int b = 0; b < archive_block_count(segment); b++) {
+        uint64_t position = blocks[b].student_offset;
+        int rows = count - b * ARCHIVE_BLOCK_ROWS < ARCHIVE_BLOCK_ROWS ? count - b * ARCHIVE_BLOCK_ROWS
+                                                                       : ARCHIVE_BLOCK_ROWS;
+        for (int r = 1; r < rows; r++) {
+            int length = 0;
+            do {
+                if (position >= stream_size || ++length > 5) return 0;
+            } while (stream[position++] & 0x80);
+        }
+    }
+    return 1;
+}
+
+/**
+ * Start a cursor at the first row of a skip table block
+ */
+void archive_cursor_init(ArchiveCursor *cursor, const ArchiveSegment *segment, int block) {
+    cursor->segment = segment;
+    cursor->row = block * ARCHIVE_BLOCK_ROWS;
+    cursor->student_id = 0;
+    cursor->student_bytes = NULL;
+}
+
+/**
+ * Decode the cursor's next row. Returns 0 after the last row.
+ */
+int archive_cursor_next(ArchiveCursor *cursor, ArchivedEnrollment *row) {
+    const ArchiveSegment *segment = cursor->segment;
+    const uint8_t *base = (const uint8_t *)segment;
+    int r = cursor->row;
+    if (r >= segment->row_count) return 0;
+    
+    if (r % ARCHIVE_BLOCK_ROWS == 0) {
+        const ArchiveBlock *block = (const ArchiveBlock *)(base + segment->blocks) + r / ARCHIVE_BLOCK_ROWS;
+        cursor->student_id = block->first_student_id;
+        cursor->student_bytes = base + segment->students + block->student_offset;
+    } else {
+        cursor->student_id += (int)varint_get(&cursor->student_bytes);
+    }
+    row->student_id = cursor->student_id;
+    row->enrollment_id = segment->min_enrollment_id +
+        (int)bits_get(base + segment->enrollment_ids, r, segment->enrollment_id_bits);
+    row->course_id = segment->min_course_id + (int)bits_get(base + segment->courses, r, segment->course_bits);
+    row->credits = segment->min_credits + (int)bits_get(base + segment->credits, r, segment->credits_bits);
+    uint32_t grade = bits_get(base + segment->grades, r, segment->grade_bits);
+    if (segment->grade_bits == ARCHIVE_GRADE_BITS) row->grade = (float)grade / 100.0f;
+    else memcpy(&row->grade, &grade, sizeof(row->grade));
+    row->enrollment_date = (time_t)(segment->min_date + bits_get(base + segment->dates, r, segment->date_bits));
+    row->status = bits_get(base + segment->dropped, r, 1) ? 3 : 2;
+    cursor->row++;
+    return 1;
+}
+
+/**
+ * Start a cursor at the first block that can hold rows of a student. A
+ * student's rows are adjacent, so readers stop at the first larger ID.
+ */
+void archive_seek_student(ArchiveCursor *cursor, const ArchiveSegment *segment, int student_id) {
+    const ArchiveBlock *blocks = (const ArchiveBlock *)((const uint8_t *)segment + segment->blocks);
+    int low = 0, high = archive_block_count(segment);
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (blocks[middle].first_student_id < student_id) low = middle + 1;
+        else high = middle;
+    }
+    /* The student's rows may begin at the end of the block before */
+    archive_cursor_init(cursor, segment, low > 0 ? low - 1 : 0);
+}
+
+int compare_archived_enrollment(const void *a, const void *b) {
+    const ArchivedEnrollment *left = a, *right = b;
+    return (left->enrollment_id > right->enrollment_id) - (left->enrollment_id < right->enrollment_id);
+}
+
+/**
+ * Collect a student's archived enrollments into a new array in enrollment
+ * ID order. The caller holds a record lock and frees *rows.
+ * Returns the number of rows, or -1 when out of memory.
+ */
+int archive_student_rows(int student_id, ArchivedEnrollment **rows) {
+    int count = 0, capacity = 0;
+    *rows = NULL;
+    
+    for (int s = 0; s < archive_segment_count; s++) {
+        const ArchiveSegment *segment = archive_segments[s];
+        if (student_id < segment->min_student_id || student_id > segment->max_student_id) continue;
+        
+        ArchiveCursor cursor;
+        ArchivedEnrollment row;
+        archive_seek_student(&cursor, segment, student_id);
+        while (archive_cursor_next(&cursor, &row) && row.student_id <= student_id) {
+            if (row.student_id != student_id) continue;
+            if (count == capacity) {
+                int grown = capacity ? capacity * 2 : 16;
+                ArchivedEnrollment *resized = realloc(*rows, (size_t)grown * sizeof(ArchivedEnrollment));
+                if (!resized) {
+                    free(*rows);
+                    *rows = NULL;
+                    return -1;
+                }
+                *rows = resized;
+                capacity = grown;
+            }
+            (*rows)[count++] = row;
+        }
+    }
+    if (count > 1) qsort(*rows, count, sizeof(ArchivedEnrollment), compare_archived_enrollment);
+    return count;
+}
+
+/**
+ * Whether a student completed a course in an archived term. The caller
+ * holds a record lock.
+ */
+int archive_has_completed(int student_id, int course_id) {
+    for (int s = 0; s < archive_segment_count; s++) {
+        const ArchiveSegment *segment = archive_segments[s];
+        if (student_id < segment->min_student_id || student_id > segment->max_student_id) continue;
+        
+        ArchiveCursor cursor;
+        ArchivedEnrollment row;
+        archive_seek_student(&cursor, segment, student_id);
+        while (archive_cursor_next(&cursor, &row) && row.student_id <= student_id) {
+            if (row.student_id == student_id && row.course_id == course_id && row.status == 2) return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Find an archived enrollment by ID, scanning only the ID column of the
+ * segments whose range covers it. The caller holds a record lock.
+ * Returns 1 and fills row when found.
+ */
+int find_archived_enrollment(int enrollment_id, ArchivedEnrollment *row) {
+    for (int s = 0; s < archive_segment_count; s++) {
+        const ArchiveSegment *segment = archive_segments[s];
+        if (enrollment_id < segment->min_enrollment_id || enrollment_id > segment->max_enrollment_id) continue;
+        
+        const uint8_t *ids = (const uint8_t *)segment + segment->enrollment_ids;
+        uint32_t wanted = (uint32_t)(enrollment_id - segment->min_enrollment_id);
+        for (int r = 0; r < segment->row_count; r++) {
+            if (bits_get(ids, r, segment->enrollment_id_bits) != wanted) continue;
+            ArchiveCursor cursor;
+            archive_cursor_init(&cursor, segment, r / ARCHIVE_BLOCK_ROWS);
+            while (archive_cursor_next(&cursor, row) && cursor.row <= r) {}
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int lookup_archived_enrollment(int enrollment_id, ArchivedEnrollment *row) {
+    pthread_rwlock_rdlock(&enrollment_table_lock);
+    int found = find_archived_enrollment(enrollment_id, row);
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    return found;
+}
+
+/* ============================================================================
+   STATISTICS FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Recompute the derived averages in system_stats from its running totals
+ */
+void refresh_system_averages(void) {
+    system_stats.average_gpa = system_stats.completed_enrollments > 0
+        ? (float)(system_stats.total_credit_points / system_stats.completed_enrollments) : 0.0f;
+    system_stats.average_enrollment_rate = system_stats.total_courses > 0
+        ? (float)(system_stats.enrollment_rate_sum / system_stats.total_courses) : 0.0f;
+}
+
+void stats_student_added(void) {
+    pthread_mutex_lock(&stats_lock);
+    system_stats.total_students++;
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_course_added(Course *course) {
+    course->grade_sum = 0.0;
+    course->graded_count = 0;
+    course->grade_min = 0.0f;
+    course->grade_max = 0.0f;
+    course->grade_bounds_stale = 0;
+    course->archived_grade_min = 0.0f;
+    course->archived_grade_max = 0.0f;
+    course->archived_graded = 0;
+    memset(course_histogram(course), 0, sizeof(GradeHistogram));
+    
+    pthread_mutex_lock(&stats_lock);
+    system_stats.total_courses++;
+    if (course->max_capacity > 0) system_stats.courses_offered++;
+    refresh_system_averages();
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_enrollment_added(Course *course, int count) {
+    pthread_mutex_lock(&stats_lock);
+    system_stats.total_enrollments += count;
+    if (course->max_capacity > 0) {
+        system_stats.enrollment_rate_sum += (double)count / course->max_capacity;
+        refresh_system_averages();
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+void stats_enrollment_dropped(Course *course) {
+    pthread_mutex_lock(&stats_lock);
+    system_stats.total_enrollments--;
+    if (course->max_capacity > 0) {
+        system_stats.enrollment_rate_sum -= 1.0 / course->max_capacity;
+        refresh_system_averages();
+    }
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Histogram bucket of a grade in MIN_GRADE..MAX_GRADE
+ */
+int grade_bucket(float grade) {
+    int bucket = (int)grade - MIN_GRADE;
+    if (bucket < 0) return 0;
+    if (bucket >= GRADE_HISTOGRAM_BUCKETS) return GRADE_HISTOGRAM_BUCKETS - 1;
+    return bucket;
+}
+
+/**
+ * Nearest-rank percentile of the graded count grades in a histogram,
+ * as the lower bound of the bucket holding it. O(buckets).
+ */
+int histogram_percentile(const GradeHistogram *histogram, int graded, int percent) {
+    long rank = ((long)graded * percent + 99) / 100;
+    if (rank < 1) rank = 1;
+    
+    long seen = 0;
+    for (int bucket = 0; bucket < GRADE_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->buckets[bucket];
+        if (seen >= rank) return bucket + MIN_GRADE;
+    }
+    return MAX_GRADE;
+}
+
+/**
+ * Number of histogram grades in [low, high]
+ */
+int histogram_count(const GradeHistogram *histogram, int low, int high) {
+    int count = 0;
+    for (int bucket = grade_bucket(low); bucket <= grade_bucket(high); bucket++) {
+        count += histogram->buckets[bucket];
+    }
+    return count;
+}
+
+/**
+ * Fold a recorded grade into the course, student and system aggregates,
+ * including the student's credit-weighted GPA cache. When the enrollment
+ * was already completed its previous grade is removed first.
+ * The caller holds the student and course locks.
+ */
+void stats_grade_recorded(Course *course, Student *student, int was_completed, int credits,
+                          float old_grade, float old_points, float grade, float points) {
+    GradeHistogram *histogram = course_histogram(course);
+    if (was_completed) {
+        histogram->buckets[grade_bucket(old_grade)]--;
+        course->grade_sum -= old_grade;
+        course->graded_count--;
+        if (old_grade <= course->grade_min || old_grade >= course->grade_max) {
+            course->grade_bounds_stale = 1;
+        }
+        student->credit_points_total -= old_points;
+        student->completed_courses--;
+        student->weighted_points_total -= (double)old_points * credits;
+        student->credits_completed -= credits;
+    }
+    
+    if (course->graded_count == 0 && !course->grade_bounds_stale) {
+        course->grade_min = grade;
+        course->grade_max = grade;
+    } else {
+        if (grade < course->grade_min) course->grade_min = grade;
+        if (grade > course->grade_max) course->grade_max = grade;
+    }
+    histogram->buckets[grade_bucket(grade)]++;
+    course->grade_sum += grade;
+    course->graded_count++;
+    
+    student->credit_points_total += points;
+    student->completed_courses++;
+    student->weighted_points_total += (double)points * credits;
+    student->credits_completed += credits;
+    
+    pthread_mutex_lock(&stats_lock);
+    if (was_completed) {
+        system_stats.total_credit_points -= old_points;
+        system_stats.completed_enrollments--;
+    }
+    system_stats.total_credit_points += points;
+    system_stats.completed_enrollments++;
+    refresh_system_averages();
+    pthread_mutex_unlock(&stats_lock);
+}
+
+/**
+ * Rebuild a course's grade bounds after a regrade removed its old min or max,
+ * from its own enrollment list and the bounds of its archived grades. The
+ * caller holds the course lock exclusively.
+ */
+void refresh_course_grade_bounds(Course *course) {
+    if (!course->grade_bounds_stale) return;
+    
+    int graded = course->archived_graded;
+    float low = course->archived_grade_min, high = course->archived_grade_max;
+    for (int i = course->first_enrollment; i != -1; i = enrollment_at(i)->next_course_enrollment) {
+        const EnrollmentColumns *columns = enrollment_columns_at(i);
+        int slot = table_slot(i);
+        if (columns->status[slot] != 2) continue;
+        float grade = columns->grade[slot];
+        if (graded == 0 || grade < low) low = grade;
+        if (graded == 0 || grade > high) high = grade;
+        graded++;
+    }
+    course->grade_min = graded > 0 ? low : 0.0f;
+    course->grade_max = graded > 0 ? high : 0.0f;
+    course->grade_bounds_stale = 0;
+}
+
+/* ============================================================================
+   JOURNAL FUNCTIONS
+   ============================================================================ */
+
+/**
+ * FNV-1a checksum of a record's sequence number and payload
+ */
+uint32_t journal_checksum(uint64_t sequence, const void *payload, size_t size) {
+    uint32_t hash = 2166136261u;
+    const unsigned char *bytes = (const unsigned char *)&sequence;
+    for (size_t i = 0; i < sizeof(sequence); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    bytes = payload;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Write all of a buffer, retrying short writes
+ */
+int write_all(int fd, const void *data, size_t size) {
+    const char *bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return 1;
+}
+
+/**
+ * Hand buffered records to the kernel without waiting for the disk
+ */
+int journal_flush(void) {
+    if (journal.fd == -1 || journal.buffered == 0) return 1;
+    int ok = write_all(journal.fd, journal.buffer, journal.buffered);
+    journal.buffered = 0;
+    return ok;
+}
+
+/**
+ * Make every appended record durable. This is the group commit point: all
+ * records appended since the previous call share one fdatasync.
+ */
+int journal_sync(void) {
+    pthread_mutex_lock(&journal.lock);
+    if (journal.fd == -1) {
+        pthread_mutex_unlock(&journal.lock);
+        return 1;
+    }
+    int ok = journal_flush();
+    if (journal.pending_records > 0) {
+        ok = fdatasync(journal.fd) == 0 && ok;
+        journal.pending_records = 0;
+    }
+    journal.last_sync = monotonic_seconds();
+    pthread_mutex_unlock(&journal.lock);
+    if (!ok) {
+        log_operation(LOG_ERROR, LOG_OP_JOURNAL, "Failed to write journal");
+    }
+    return ok;
+}
+
+/**
+ * Append one mutation to the journal, syncing when the group commit record
+ * count or interval has been reached. Callers append while holding the lock
+ * that orders the mutation, so replay sees the same order.
+ */
+void journal_append(uint32_t type, const void *payload, size_t size) {
+    if (journal.fd == -1) return;
+    
+    pthread_mutex_lock(&journal.lock);
+    JournalRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.type = type;
+    header.size = (uint32_t)size;
+    header.sequence = ++journal.sequence;
+    header.checksum = journal_checksum(header.sequence, payload, size);
+    
+    if (journal.buffered + sizeof(header) + size > sizeof(journal.buffer)) {
+        journal_flush();
+    }
+    memcpy(journal.buffer + journal.buffered, &header, sizeof(header));
+    memcpy(journal.buffer + journal.buffered + sizeof(header), payload, size);
+    journal.buffered += sizeof(header) + size;
+    journal.pending_records++;
+    
+    int sync_due = journal.pending_records >= journal.sync_records ||
+        (monotonic_seconds() - journal.last_sync) * 1000 >= journal.sync_interval_ms;
+    pthread_mutex_unlock(&journal.lock);
+    if (sync_due) journal_sync();
+}
+
+/**
+ * Write the file header of a new journal
+ */
+int journal_write_header(int fd) {
+    JournalFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    header.version = JOURNAL_VERSION;
+    return write_all(fd, &header, sizeof(header));
+}
+
+/**
+ * Open the journal for appending, creating it with a header if needed
+ */
+int journal_open(const char *path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        log_operation(LOG_ERROR, LOG_OP_JOURNAL, "Failed to open journal file");
+        return 0;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size == 0) {
+        if (!journal_write_header(fd) || fsync(fd) != 0) {
+            close(fd);
+            log_operation(LOG_ERROR, LOG_OP_JOURNAL, "Failed to initialise journal file");
+            return 0;
+        }
+    }
+    
+    journal.fd = fd;
+    journal.buffered = 0;
+    journal.pending_records = 0;
+    journal.last_sync = monotonic_seconds();
+    return 1;
+}
+
+/**
+ * Discard journal records already covered by a snapshot; writers are
+ * stopped by the caller
+ */
+int journal_truncate(void) {
+    if (journal.fd == -1) return 1;
+    if (!journal_sync() || ftruncate(journal.fd, sizeof(JournalFileHeader)) != 0) {
+        log_operation(LOG_ERROR, LOG_OP_JOURNAL, "Failed to truncate journal");
+        return 0;
+    }
+    fdatasync(journal.fd);
+    return 1;
+}
+
+/**
+ * Drop the records before byte offset covered, which a background snapshot
+ * includes, keeping those appended while it was written. The kept tail is
+ * copied into a new file that replaces the journal atomically, so a crash
+ * leaves either journal usable with either snapshot.
+ */
+int journal_compact(off_t covered) {
+    pthread_mutex_lock(&journal.lock);
+    int ok = journal.fd == -1 || journal_flush();
+    off_t end = journal.fd == -1 ? 0 : lseek(journal.fd, 0, SEEK_END);
+    if (!ok || end < covered || covered <= (off_t)sizeof(JournalFileHeader)) {
+        pthread_mutex_unlock(&journal.lock);
+        return ok;
+    }
+    
+    char temp_path[FILE_BUFFER_SIZE];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", journal_path);
+    size_t tail = (size_t)(end - covered);
+    char *kept = malloc(tail > 0 ? tail : 1);
+    int source = open(journal_path, O_RDONLY);
+    ok = kept && source != -1 && pread(source, kept, tail, covered) == (ssize_t)tail;
+    if (source != -1) close(source);
+    
+    int fd = ok ? open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644) : -1;
+    ok = fd != -1 && journal_write_header(fd) && write_all(fd, kept, tail) && fdatasync(fd) == 0 &&
+         rename(temp_path, journal_path) == 0;
+    free(kept);
+    /* dup2 keeps the descriptor number, which appenders test without the lock */
+    ok = ok && dup2(fd, journal.fd) != -1;
+    if (ok) journal.pending_records = 0;
+    else if (fd != -1) remove(temp_path);
+    if (fd != -1) close(fd);
+    pthread_mutex_unlock(&journal.lock);
+    if (!ok) log_operation(LOG_ERROR, LOG_OP_JOURNAL, "Failed to compact journal");
+    return ok;
+}
+
+/**
+ * Sync outstanding records and close the journal
+ */
+void journal_close(void) {
+    if (journal.fd == -1) return;
+    journal_sync();
+    close(journal.fd);
+    journal.fd = -1;
+}
+
+/* ============================================================================
+   RECORD OPERATIONS
+   ============================================================================ */
+
+/**
+ * Describe an operation result code
+ */
+const char *result_message(int result) {
+    switch (result) {
+        case RESULT_OK: return "Success";
+        case RESULT_OUT_OF_MEMORY: return "Out of memory";
+        case RESULT_STUDENT_NOT_FOUND: return "Student not found";
+        case RESULT_COURSE_NOT_FOUND: return "Course not found";
+        case RESULT_COURSE_FULL: return "Course is at maximum capacity";
+        case RESULT_ALREADY_ENROLLED: return "Student is already enrolled in this course";
+        case RESULT_ENROLLMENT_NOT_FOUND: return "Enrollment not found";
+        case RESULT_INVALID_GRADE: return "Grade must be between 0 and 100";
+        case RESULT_WAITLISTED: return "Course is full; student added to the waitlist";
+        case RESULT_NOT_SEATED: return "Enrollment is waitlisted or dropped";
+        case RESULT_CANNOT_DROP: return "Only pending, active or waitlisted enrollments can be dropped";
+        case RESULT_INVALID_ASSESSMENT: return "Assessment needs a known type and marks between 0 and the total";
+        case RESULT_INVALID_TERM: return "Only terms that have ended can be archived";
+        case RESULT_ENROLLMENT_ARCHIVED: return "Enrollment is archived and can no longer change";
+        case RESULT_SNAPSHOT_RUNNING: return "A snapshot is already being written in the background";
+        case RESULT_TOO_MANY_JOBS: return "Too many background jobs are running";
+        case RESULT_NO_ASSESSMENTS: return "Enrollment has no assessments to take a grade from";
+        default: return "Unknown error";
+    }
+}
+
+/**
+ * Reserve the next student slot and assign its ID. The caller fills in
+ * student_profile_at(index) and the major_id, then calls commit_student, or
+ * release_student_reservation to give the slot up. The student table stays
+ * locked until then.
+ * Returns the slot index, or -1 when storage could not be allocated.
+ */
+int reserve_student(void) {
+    pthread_rwlock_wrlock(&student_table_lock);
+    Student *student = table_reserve(&student_table, student_count);
+    StudentProfile *profile = table_reserve(&student_profile_table, student_count);
+    if (!student || !profile) {
+        pthread_rwlock_unlock(&student_table_lock);
+        log_operation(LOG_ERROR, LOG_OP_ADD_STUDENT, "Student storage allocation failed");
+        return -1;
+    }
+    
+    student->student_id = student_count + student_id_base;
+    student->major_id = -1;
+    return student_count;
+}
+
+void release_student_reservation(void) {
+    pthread_rwlock_unlock(&student_table_lock);
+}
+
+/**
+ * Index and publish a reserved student whose profile has been filled in
+ */
+int commit_student(int index) {
+    uint64_t started = monotonic_ns();
+    Student *student = student_at(index);
+    StudentProfile *profile = student_profile_at(index);
+    
+    profile->registration_date = time(NULL);
+    student->is_active = 1;
+    set_student_name_key(student, profile->name);
+    student->first_enrollment = -1;
+    student->last_enrollment = -1;
+    student->credit_points_total = 0.0;
+    student->completed_courses = 0;
+    student->credits_completed = 0;
+    student->weighted_points_total = 0.0;
+    
+    if (!name_index_add(index, profile->name) ||
+        !id_index_insert(&student_id_index, student->student_id, index)) {
+        log_operation(LOG_ERROR, LOG_OP_ADD_STUDENT, "Student index allocation failed");
+        pthread_rwlock_unlock(&student_table_lock);
+        return metric_result(METRIC_ADD_STUDENT, started, RESULT_OUT_OF_MEMORY);
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_ADD_STUDENT, "Added student: %s (ID: %d)", profile->name,
+                   student->student_id);
+    
+    JournalStudentRecord record;
+    memset(&record, 0, sizeof(record));
+    record.student_id = student->student_id;
+    record.profile = *profile;
+    copy_field(record.major, sizeof(record.major), interned_text(student->major_id));
+    journal_append(JOURNAL_ADD_STUDENT, &record, sizeof(record));
+    
+    student_count++;
+    pthread_rwlock_unlock(&student_table_lock);
+    stats_student_added();
+    return metric_result(METRIC_ADD_STUDENT, started, RESULT_OK);
+}
+
+/**
+ * Seats of a course held by this shard. The capacity is split evenly across
+ * shards, so each enforces its share without asking the others and the
+ * deployment as a whole never oversubscribes a course.
+ */
+int shard_seat_quota(int capacity) {
+    if (capacity <= 0) return capacity;
+    return capacity / shard_count + (shard_index < capacity % shard_count);
+}
+
+/**
+ * Reserve the next course slot and assign its ID. The caller fills in the
+ * code_id, credits, capacity and difficulty of course_at(index) and the text of
+ * course_details_at(index), then calls commit_course, or
+ * release_course_reservation to give the slot up.
+ * Returns the slot index, or -1 when storage could not be allocated.
+ */
+int reserve_course(void) {
+    pthread_rwlock_wrlock(&course_table_lock);
+    Course *course = table_reserve(&course_table, course_count);
+    CourseDetails *details = table_reserve(&course_details_table, course_count);
+    GradeHistogram *histogram = table_reserve(&course_histogram_table, course_count);
+    if (!course || !details || !histogram) {
+        pthread_rwlock_unlock(&course_table_lock);
+        log_operation(LOG_ERROR, LOG_OP_ADD_COURSE, "Course storage allocation failed");
+        return -1;
+    }
+    
+    course->course_id = course_count + FIRST_COURSE_ID;
+    course->code_id = -1;
+    return course_count;
+}
+
+void release_course_reservation(void) {
+    pthread_rwlock_unlock(&course_table_lock);
+}
+
+/**
+ * Index and publish a reserved course whose fields have been filled in
+ */
+int commit_course(int index) {
+    Course *course = course_at(index);
+    CourseDetails *details = course_details_at(index);
+    
+    course->current_enrollment = 0;
+    course->waitlist_count = 0;
+    course->waitlist_head = -1;
+    details->created_date = time(NULL);
+    course->first_enrollment = -1;
+    course->last_enrollment = -1;
+    
+    if (!id_index_insert(&course_id_index, course->course_id, index)) {
+        log_operation(LOG_ERROR, LOG_OP_ADD_COURSE, "Course index allocation failed");
+        pthread_rwlock_unlock(&course_table_lock);
+        return RESULT_OUT_OF_MEMORY;
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_ADD_COURSE, "Added course: %s (%s)", details->course_name,
+                   interned_text(course->code_id));
+    
+    JournalCourseRecord record;
+    memset(&record, 0, sizeof(record));
+    record.course_id = course->course_id;
+    copy_field(record.course_code, sizeof(record.course_code), interned_text(course->code_id));
+    record.credits = course->credits;
+    record.max_capacity = course->max_capacity;
+    record.difficulty_level = course->difficulty_level;
+    record.details = *details;
+    journal_append(JOURNAL_ADD_COURSE, &record, sizeof(record));
+    
+    course_count++;
+    stats_course_added(course);
+    pthread_rwlock_unlock(&course_table_lock);
+    return RESULT_OK;
+}
+
+/**
+ * Claim up to wanted seats with one compare-and-swap, without taking the
+ * course lock. Concurrent enrollments race on the counter alone, so a course
+ * is never over-booked. Returns the number of seats taken.
+ */
+int seat_reserve_many(Course *course, int wanted) {
+    int taken = atomic_load_explicit(&course->current_enrollment, memory_order_relaxed);
+    while (taken < course->max_capacity) {
+        int granted = course->max_capacity - taken < wanted ? course->max_capacity - taken : wanted;
+        if (atomic_compare_exchange_weak_explicit(&course->current_enrollment, &taken, taken + granted,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            return granted;
+        }
+        contention_record(CONTENTION_SEAT_RETRY);
+    }
+    return 0;
+}
+
+int seat_reserve(Course *course) {
+    return seat_reserve_many(course, 1);
+}
+
+void seat_release_many(Course *course, int seats) {
+    atomic_fetch_sub_explicit(&course->current_enrollment, seats, memory_order_acq_rel);
+}
+
+void seat_release(Course *course) {
+    seat_release_many(course, 1);
+}
+
+/**
+ * Find the next waitlisted enrollment after index in its course list, -1 if none
+ */
+int next_waitlisted(int index) {
+    for (int i = enrollment_at(index)->next_course_enrollment; i != -1;
+         i = enrollment_at(i)->next_course_enrollment) {
+        if (enrollment_columns_at(i)->status[table_slot(i)] == 4) return i;
+    }
+    return -1;
+}
+
+/**
+ * Give a freed seat to the oldest waitlisted enrollment, or release it when
+ * nobody is waiting. Returns the promoted enrollment index, or -1. The
+ * caller holds the course lock, which orders every waitlist change.
+ */
+int waitlist_promote(Course *course) {
+    int index = course->waitlist_head;
+    if (index == -1) {
+        seat_release(course);
+        return -1;
+    }
+    enrollment_columns_at(index)->status[table_slot(index)] = 0; /* pending */
+    course->waitlist_head = next_waitlisted(index);
+    course->waitlist_count--;
+    return index;
+}
+
+/**
+ * Append an enrollment row with the given status and journal it; the caller
+ * holds the enrollment table lock exclusively. Returns its table position,
+ * or -1 when storage could not be allocated.
+ */
+int append_enrollment_row(int student_id, const Course *course, int status) {
+    int index = enrollment_count;
+    Enrollment *enrollment = table_reserve(&enrollment_table, index);
+    EnrollmentColumns *columns = enrollment_columns_reserve(index);
+    if (!enrollment || !columns) {
+        log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Enrollment storage allocation failed");
+        return -1;
+    }
+    
+    int slot = table_slot(index);
+    enrollment->enrollment_id = next_enrollment_id;
+    columns->student_id[slot] = student_id;
+    columns->course_id[slot] = course->course_id;
+    columns->credits[slot] = course->credits;
+    columns->grade[slot] = 0.0f;
+    enrollment->letter_grade = '-';
+    columns->credit_points[slot] = 0.0f;
+    enrollment->enrollment_date = time(NULL);
+    columns->status[slot] = status;
+    enrollment->next_student_enrollment = -1;
+    enrollment->next_course_enrollment = -1;
+    enrollment->first_assessment = -1;
+    enrollment->last_assessment = -1;
+    memset(enrollment->assessment_marks, 0, sizeof(enrollment->assessment_marks));
+    memset(enrollment->assessment_totals, 0, sizeof(enrollment->assessment_totals));
+    
+    if (!id_index_insert(&enrollment_id_index, enrollment->enrollment_id, index)) {
+        log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Enrollment index allocation failed");
+        return -1;
+    }
+    
+    /* Journaled inside the table lock so replay assigns the same IDs */
+    JournalEnrollmentRecord record;
+    memset(&record, 0, sizeof(record));
+    record.enrollment_id = enrollment->enrollment_id;
+    record.student_id = student_id;
+    record.course_id = course->course_id;
+    record.status = status;
+    record.enrollment_date = enrollment->enrollment_date;
+    journal_append(JOURNAL_ENROLL, &record, sizeof(record));
+    
+    enrollment_count++;
+    next_enrollment_id++;
+    return index;
+}
+
+int append_enrollment(int student_id, const Course *course, int status) {
+    pthread_rwlock_wrlock(&enrollment_table_lock);
+    int index = append_enrollment_row(student_id, course, status);
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    return index;
+}
+
+/**
+ * Check that a student may enroll in a course: the student is active, the
+ * course has seats at all, and no live or waitlisted enrollment exists.
+ * The caller holds the student lock. Failures are logged when log is set.
+ */
+int check_enrollment(const Student *student, const Course *course, int log) {
+    if (!student->is_active) {
+        if (log) log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Student not found");
+        return RESULT_STUDENT_NOT_FOUND;
+    }
+    
+    /* A course without seats has nothing to wait for */
+    if (course->max_capacity <= 0) {
+        if (log) log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Course at maximum capacity");
+        return RESULT_COURSE_FULL;
+    }
+    
+    /* Check for duplicate enrollment, waitlisted ones included */
+    for (int i = student->first_enrollment; i != -1;
+         i = enrollment_at(i)->next_student_enrollment) {
+        EnrollmentColumns *existing = enrollment_columns_at(i);
+        if (existing->course_id[table_slot(i)] == course->course_id && 
+            existing->status[table_slot(i)] != 3) {
+            if (log) log_operation(LOG_WARNING, LOG_OP_ENROLLMENT, "Duplicate enrollment attempt");
+            return RESULT_ALREADY_ENROLLED;
+        }
+    }
+    /* So do courses completed in archived terms */
+    if (archive_has_completed(student->student_id, course->course_id)) {
+        if (log) log_operation(LOG_WARNING, LOG_OP_ENROLLMENT, "Duplicate enrollment attempt");
+        return RESULT_ALREADY_ENROLLED;
+    }
+    return RESULT_OK;
+}
+
+/**
+ * Validate and add an enrollment; the caller holds the student lock. When a
+ * seat is free and nobody is waiting it is claimed without the course lock;
+ * otherwise the enrollment joins the course waitlist under the course lock
+ * and RESULT_WAITLISTED is returned. While journaling, every seat is decided
+ * under the course lock and journaled before it is released, so the records
+ * of a course are in the order replay must decide its seats.
+ */
+int insert_enrollment(int student_index, int course_index, int *enrollment_id) {
+    Student *student = student_at(student_index);
+    Course *course = course_at(course_index);
+    int student_id = student->student_id;
+    int course_id = course->course_id;
+    
+    int result = check_enrollment(student, course, 1);
+    if (result != RESULT_OK) return result;
+    
+    int course_locked = journal.fd != -1;
+    if (course_locked) lock_write(course_lock(course_id), CONTENTION_COURSE_LOCK);
+    int seated = atomic_load(&course->waitlist_count) == 0 && seat_reserve(course);
+    if (!seated && !course_locked) {
+        /* Retry under the lock so a seat freed by a drop is not missed */
+        lock_write(course_lock(course_id), CONTENTION_COURSE_LOCK);
+        course_locked = 1;
+        seated = course->waitlist_count == 0 && seat_reserve(course);
+    }
+    
+    int index = append_enrollment(student_id, course, seated ? 0 : 4);
+    if (index == -1) {
+        if (seated) seat_release(course);
+        if (course_locked) pthread_rwlock_unlock(course_lock(course_id));
+        return RESULT_OUT_OF_MEMORY;
+    }
+    
+    if (!course_locked) lock_write(course_lock(course_id), CONTENTION_COURSE_LOCK);
+    link_enrollment(index, student_index, course_index);
+    if (!seated) {
+        if (course->waitlist_head == -1) course->waitlist_head = index;
+        course->waitlist_count++;
+    }
+    pthread_rwlock_unlock(course_lock(course_id));
+    
+    *enrollment_id = enrollment_at(index)->enrollment_id;
+    if (!seated) {
+        log_operationf(LOG_INFO, LOG_OP_ENROLLMENT, "Waitlisted student %d for course %d",
+                       student_id, course_id);
+        return RESULT_WAITLISTED;
+    }
+    
+    stats_enrollment_added(course, 1);
+    log_operationf(LOG_SUCCESS, LOG_OP_ENROLLMENT, "Enrolled student %d in course %d",
+                   student_id, course_id);
+    return RESULT_OK;
+}
+
+/**
+ * Enroll a student in a course, storing the new enrollment ID on success.
+ * A full course waitlists the student and returns RESULT_WAITLISTED.
+ */
+int create_enrollment(int student_id, int course_id, int *enrollment_id) {
+    uint64_t started = monotonic_ns();
+    /* Validate student exists */
+    int student_index = lookup_student(student_id);
+    if (student_index == -1) {
+        log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Student not found");
+        return metric_result(METRIC_ENROLL, started, RESULT_STUDENT_NOT_FOUND);
+    }
+    
+    /* Validate course exists */
+    int course_index = lookup_course(course_id);
+    
+    if (course_index == -1) {
+        log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Course not found");
+        return metric_result(METRIC_ENROLL, started, RESULT_COURSE_NOT_FOUND);
+    }
+    
+    /* The student stays locked until the enrollment is linked */
+    lock_write(student_lock(student_id), CONTENTION_STUDENT_LOCK);
+    int result = insert_enrollment(student_index, course_index, enrollment_id);
+    pthread_rwlock_unlock(student_lock(student_id));
+    return metric_result(METRIC_ENROLL, started, result);
+}
+
+/**
+ * Result for an enrollment ID that has no live row, logged under operation:
+ * the enrollment was archived, or never existed
+ */
+int missing_enrollment_result(int enrollment_id, int operation) {
+    ArchivedEnrollment row;
+    if (lookup_archived_enrollment(enrollment_id, &row)) {
+        log_operation(LOG_ERROR, operation, "Enrollment is archived");
+        return RESULT_ENROLLMENT_ARCHIVED;
+    }
+    log_operation(LOG_ERROR, operation, "Enrollment not found");
+    return RESULT_ENROLLMENT_NOT_FOUND;
+}
+
+/**
+ * Set a validated grade on an enrollment row and mark it completed, keeping
+ * the running aggregates current. The caller holds the student and course locks.
+ */
+int set_enrollment_grade(int enrollment_index, Student *student, Course *course, float grade) {
+    Enrollment *enrollment = enrollment_at(enrollment_index);
+    EnrollmentColumns *columns = enrollment_columns_at(enrollment_index);
+    int slot = table_slot(enrollment_index);
+    
+    if (columns->status[slot] >= 3) return RESULT_NOT_SEATED;
+    
+    int was_completed = columns->status[slot] == 2;
+    float old_grade = columns->grade[slot];
+    float old_points = columns->credit_points[slot];
+    
+    columns->grade[slot] = grade;
+    enrollment->letter_grade = get_letter_grade(grade);
+    columns->credit_points[slot] = get_gpa_from_grade(enrollment->letter_grade);
+    columns->status[slot] = 2; /* completed */
+    
+    stats_grade_recorded(course, student, was_completed, columns->credits[slot], old_grade, old_points,
+                         grade, columns->credit_points[slot]);
+    return RESULT_OK;
+}
+
+/**
+ * Record a validated grade on an enrollment row, mark it completed and
+ * journal it. The caller holds the student and course locks.
+ */
+int grade_enrollment_row(int enrollment_index, Student *student, Course *course, float grade) {
+    int result = set_enrollment_grade(enrollment_index, student, course, grade);
+    if (result == RESULT_OK) {
+        JournalGradeRecord record = { enrollment_at(enrollment_index)->enrollment_id, grade };
+        journal_append(JOURNAL_GRADE, &record, sizeof(record));
+    }
+    return result;
+}
+
+/**
+ * Record the grade for an enrollment and mark it completed
+ */
+int apply_grade(int enrollment_id, float grade) {
+    uint64_t started = monotonic_ns();
+    if (grade < MIN_GRADE || grade > MAX_GRADE) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Invalid grade value");
+        return metric_result(METRIC_GRADE, started, RESULT_INVALID_GRADE);
+    }
+    
+    /* Find enrollment */
+    Student *student;
+    Course *course;
+    int enrollment_index = lock_enrollment(enrollment_id, &student, &course);
+    
+    if (enrollment_index == -1) {
+        return metric_result(METRIC_GRADE, started, missing_enrollment_result(enrollment_id, LOG_OP_RECORD_GRADE));
+    }
+    
+    int result = grade_enrollment_row(enrollment_index, student, course, grade);
+    pthread_rwlock_unlock(course_lock(course->course_id));
+    pthread_rwlock_unlock(student_lock(student->student_id));
+    
+    if (result != RESULT_OK) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Enrollment does not hold a seat");
+        return metric_result(METRIC_GRADE, started, result);
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_RECORD_GRADE, "Recorded grade %.2f for enrollment %d",
+                   grade, enrollment_id);
+    return metric_result(METRIC_GRADE, started, RESULT_OK);
+}
+
+/**
+ * Look up an assessment type by name, ignoring case.
+ * Returns ASSESSMENT_QUIZ .. ASSESSMENT_FINAL, or -1 if unknown.
+ */
+int parse_assessment_type(const char *text) {
+    for (int type = 0; type < ASSESSMENT_TYPE_COUNT; type++) {
+        if (strcasecmp(text, assessment_type_names[type]) == 0) return type;
+    }
+    return -1;
+}
+
+/**
+ * Interned ID of an assessment type. Types are interned on first use rather
+ * than at startup, since loading a snapshot needs an empty string pool.
+ */
+int assessment_type_id(int type) {
+    int id = intern_find(assessment_type_names[type]);
+    return id != -1 ? id : intern_string(assessment_type_names[type]);
+}
+
+/**
+ * Final grade from an enrollment's per-type totals: each type assessed so
+ * far scores its summed marks over its summed maximum, and the scores are
+ * averaged with assessment_weights renormalised over those types
+ */
+float weighted_assessment_grade(const Enrollment *enrollment) {
+    float weighted = 0.0f, weights = 0.0f;
+    for (int type = 0; type < ASSESSMENT_TYPE_COUNT; type++) {
+        if (enrollment->assessment_totals[type] <= 0.0f) continue;
+        weighted += assessment_weights[type] * enrollment->assessment_marks[type] /
+                    enrollment->assessment_totals[type];
+        weights += assessment_weights[type];
+    }
+    float grade = weights > 0.0f ? MAX_GRADE * weighted / weights : 0.0f;
+    return grade > MAX_GRADE ? MAX_GRADE : grade;
+}
+
+/**
+ * Append an assessment record and journal it; the caller holds the
+ * enrollment's student and course locks. Returns its table position, or -1
+ * when storage could not be allocated.
+ */
+int append_grade_record(int enrollment_id, int type, int type_id, float marks, float total_marks) {
+    pthread_rwlock_wrlock(&assessment_table_lock);
+    int index = assessment_count;
+    GradeRecord *record = table_reserve(&grade_record_table, index);
+    if (!record) {
+        pthread_rwlock_unlock(&assessment_table_lock);
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Assessment storage allocation failed");
+        return -1;
+    }
+    
+    record->assessment_id = index + assessment_id_base;
+    record->enrollment_id = enrollment_id;
+    record->assessment_type_id = type_id;
+    record->marks_obtained = marks;
+    record->total_marks = total_marks;
+    record->percentage = MAX_GRADE * marks / total_marks;
+    record->assessment_date = time(NULL);
+    record->next_assessment = -1;
+    
+    /* Journaled inside the table lock so replay assigns the same IDs */
+    JournalAssessmentRecord entry = { record->assessment_id, enrollment_id, type, marks, total_marks,
+                                      0, record->assessment_date };
+    journal_append(JOURNAL_ASSESSMENT, &entry, sizeof(entry));
+    
+    assessment_count++;
+    pthread_rwlock_unlock(&assessment_table_lock);
+    return index;
+}
+
+/**
+ * Record one assessment of an enrollment, storing the new assessment ID on
+ * success. The enrollment's per-type totals absorb the marks, so its running
+ * grade is recomputed in O(1) however many assessments came before. The
+ * enrollment's status and recorded grade are left alone; only apply_grade
+ * or complete_enrollment completes it.
+ */
+int apply_assessment(int enrollment_id, int type, float marks, float total_marks, int *assessment_id) {
+    uint64_t started = monotonic_ns();
+    if (type < 0 || type >= ASSESSMENT_TYPE_COUNT || !(total_marks > 0.0f) ||
+        !(marks >= 0.0f) || marks > total_marks) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Invalid assessment");
+        return metric_result(METRIC_GRADE, started, RESULT_INVALID_ASSESSMENT);
+    }
+    
+    int type_id = assessment_type_id(type);
+    if (type_id == -1) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "String pool allocation failed");
+        return metric_result(METRIC_GRADE, started, RESULT_OUT_OF_MEMORY);
+    }
+    Student *student;
+    Course *course;
+    int enrollment_index = lock_enrollment(enrollment_id, &student, &course);
+    if (enrollment_index == -1) {
+        return metric_result(METRIC_GRADE, started, missing_enrollment_result(enrollment_id, LOG_OP_RECORD_GRADE));
+    }
+    
+    Enrollment *enrollment = enrollment_at(enrollment_index);
+    EnrollmentColumns *columns = enrollment_columns_at(enrollment_index);
+    int slot = table_slot(enrollment_index);
+    int result = columns->status[slot] >= 3 ? RESULT_NOT_SEATED : RESULT_OK;
+    int index = -1;
+    float grade = 0.0f;
+    if (result == RESULT_OK) {
+        index = append_grade_record(enrollment_id, type, type_id, marks, total_marks);
+        if (index == -1) result = RESULT_OUT_OF_MEMORY;
+    }
+    if (result == RESULT_OK) {
+        if (enrollment->last_assessment == -1) enrollment->first_assessment = index;
+        else grade_record_at(enrollment->last_assessment)->next_assessment = index;
+        enrollment->last_assessment = index;
+        enrollment->assessment_marks[type] += marks;
+        enrollment->assessment_totals[type] += total_marks;
+        grade = weighted_assessment_grade(enrollment);
+    }
+    pthread_rwlock_unlock(course_lock(course->course_id));
+    pthread_rwlock_unlock(student_lock(student->student_id));
+    
+    if (result == RESULT_NOT_SEATED) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Enrollment does not hold a seat");
+    }
+    if (result != RESULT_OK) return metric_result(METRIC_GRADE, started, result);
+    
+    *assessment_id = index + assessment_id_base;
+    log_operationf(LOG_SUCCESS, LOG_OP_RECORD_GRADE, "Recorded %s %.2f/%.2f for enrollment %d; running grade %.2f",
+                   assessment_type_names[type], marks, total_marks, enrollment_id, grade);
+    return metric_result(METRIC_GRADE, started, RESULT_OK);
+}
+
+/**
+ * Complete an enrollment with the running grade of its assessments as the
+ * final grade, storing it in grade. The grade is journaled like one from
+ * apply_grade, so replay does not depend on the assessments.
+ */
+int complete_enrollment(int enrollment_id, float *grade) {
+    uint64_t started = monotonic_ns();
+    Student *student;
+    Course *course;
+    int enrollment_index = lock_enrollment(enrollment_id, &student, &course);
+    if (enrollment_index == -1) {
+        return metric_result(METRIC_GRADE, started, missing_enrollment_result(enrollment_id, LOG_OP_RECORD_GRADE));
+    }
+    
+    const Enrollment *enrollment = enrollment_at(enrollment_index);
+    int result = enrollment->first_assessment == -1 ? RESULT_NO_ASSESSMENTS : RESULT_OK;
+    if (result == RESULT_OK) {
+        *grade = weighted_assessment_grade(enrollment);
+        result = grade_enrollment_row(enrollment_index, student, course, *grade);
+    }
+    pthread_rwlock_unlock(course_lock(course->course_id));
+    pthread_rwlock_unlock(student_lock(student->student_id));
+    
+    if (result != RESULT_OK) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, result == RESULT_NO_ASSESSMENTS
+                      ? "Enrollment has no assessments" : "Enrollment does not hold a seat");
+        return metric_result(METRIC_GRADE, started, result);
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_RECORD_GRADE, "Completed enrollment %d with grade %.2f",
+                   enrollment_id, *grade);
+    return metric_result(METRIC_GRADE, started, RESULT_OK);
+}
+
+/**
+ * Drop a pending, active or waitlisted enrollment. A freed seat passes
+ * straight to the oldest waitlisted enrollment of the course.
+ */
+int drop_enrollment(int enrollment_id) {
+    Student *student;
+    Course *course;
+    int enrollment_index = lock_enrollment(enrollment_id, &student, &course);
+    
+    if (enrollment_index == -1) {
+        return missing_enrollment_result(enrollment_id, LOG_OP_DROP_ENROLLMENT);
+    }
+    
+    EnrollmentColumns *columns = enrollment_columns_at(enrollment_index);
+    int slot = table_slot(enrollment_index);
+    int course_id = course->course_id;
+    int student_id = student->student_id;
+    
+    int status = columns->status[slot];
+    if (status == 2 || status == 3) {
+        pthread_rwlock_unlock(course_lock(course_id));
+        pthread_rwlock_unlock(student_lock(student_id));
+        log_operation(LOG_ERROR, LOG_OP_DROP_ENROLLMENT, "Enrollment cannot be dropped");
+        return RESULT_CANNOT_DROP;
+    }
+    
+    columns->status[slot] = 3; /* dropped */
+    int promoted = -1;
+    if (status == 4) {
+        if (course->waitlist_head == enrollment_index) {
+            course->waitlist_head = next_waitlisted(enrollment_index);
+        }
+        course->waitlist_count--;
+    } else {
+        promoted = waitlist_promote(course);
+    }
+    
+    JournalDropRecord record = { enrollment_id, 0 };
+    journal_append(JOURNAL_DROP, &record, sizeof(record));
+    int promoted_id = promoted != -1 ? enrollment_at(promoted)->enrollment_id : 0;
+    
+    pthread_rwlock_unlock(course_lock(course_id));
+    pthread_rwlock_unlock(student_lock(student_id));
+    
+    if (status != 4) stats_enrollment_dropped(course);
+    if (promoted != -1) {
+        stats_enrollment_added(course, 1);
+        log_operationf(LOG_SUCCESS, LOG_OP_DROP_ENROLLMENT,
+                       "Dropped enrollment %d; enrollment %d promoted from the waitlist",
+                       enrollment_id, promoted_id);
+    } else {
+        log_operationf(LOG_SUCCESS, LOG_OP_DROP_ENROLLMENT, "Dropped enrollment %d", enrollment_id);
+    }
+    return RESULT_OK;
+}
+
+int compare_archive_candidate(const void *a, const void *b) {
+    const ArchiveCandidate *left = a, *right = b;
+    if (left->term != right->term) return left->term < right->term ? -1 : 1;
+    if (left->student_id != right->student_id) return left->student_id < right->student_id ? -1 : 1;
+    return (left->enrollment_id > right->enrollment_id) - (left->enrollment_id < right->enrollment_id);
+}
+
+/**
+ * Copy a live enrollment row to a lower position; the caller holds every
+ * record lock
+ */
+void move_enrollment_row(int from, int to) {
+    *enrollment_at(to) = *enrollment_at(from);
+    const EnrollmentColumns *source = enrollment_columns_at(from);
+    EnrollmentColumns *target = enrollment_columns_at(to);
+    int from_slot = table_slot(from), to_slot = table_slot(to);
+    target->student_id[to_slot] = source->student_id[from_slot];
+    target->course_id[to_slot] = source->course_id[from_slot];
+    target->status[to_slot] = source->status[from_slot];
+    target->grade[to_slot] = source->grade[from_slot];
+    target->credit_points[to_slot] = source->credit_points[from_slot];
+    target->credits[to_slot] = source->credits[from_slot];
+}
+
+/**
+ * Move the completed and dropped enrollments of every ended term up to
+ * through_term into new archive segments, one per term, and compact the
+ * live rows that remain. Live rows keep their order, so every student's and
+ * course's enrollment list does too. Counters, GPA caches and histograms
+ * still cover the archived rows. Stores the number of enrollments archived.
+ */
+int archive_enrollments(int through_term, int *archived) {
+    *archived = 0;
+    if (through_term >= term_of(time(NULL))) {
+        log_operation(LOG_ERROR, LOG_OP_ARCHIVE, "Term has not ended");
+        return RESULT_INVALID_TERM;
+    }
+    
+    lock_all_records();
+    size_t rows = (size_t)(enrollment_count > 0 ? enrollment_count : 1);
+    ArchiveCandidate *candidates = malloc(rows * sizeof(ArchiveCandidate));
+    int *positions = malloc(rows * sizeof(int));
+    ArchiveSegment **built = NULL;
+    int count = 0, segments = 0, ok = candidates && positions;
+    
+    for (int i = 0; ok && i < enrollment_count; i++) {
+        const EnrollmentColumns *columns = enrollment_columns_at(i);
+        int slot = table_slot(i);
+        positions[i] = 0;
+        if (columns->status[slot] != 2 && columns->status[slot] != 3) continue;
+        int term = term_of(enrollment_at(i)->enrollment_date);
+        if (term > through_term) continue;
+        candidates[count++] = (ArchiveCandidate){ term, columns->student_id[slot],
+                                                  enrollment_at(i)->enrollment_id, i };
+        positions[i] = -1;
+    }
+    if (ok && count > 1) qsort(candidates, count, sizeof(ArchiveCandidate), compare_archive_candidate);
+    
+    /* Every segment is built before anything changes, so running out of
+       memory leaves the tables as they were */
+    int terms = 0;
+    for (int i = 0; ok && i < count; i++) {
+        if (i == 0 || candidates[i].term != candidates[i - 1].term) terms++;
+    }
+    if (ok && terms > 0) {
+        built = malloc((size_t)terms * sizeof(ArchiveSegment *));
+        ok = built != NULL;
+        if (ok && archive_segment_count + terms > archive_segment_capacity) {
+            int grown = archive_segment_count + terms;
+            if (grown < archive_segment_capacity * 2) grown = archive_segment_capacity * 2;
+            const ArchiveSegment **resized = realloc(archive_segments, (size_t)grown * sizeof(ArchiveSegment *));
+            ok = resized != NULL;
+            if (ok) {
+                archive_segments = resized;
+                archive_segment_capacity = grown;
+            }
+        }
+    }
+    for (int start = 0; ok && start < count; segments++) {
+        int end = start + 1;
+        while (end < count && candidates[end].term == candidates[start].term) end++;
+        built[segments] = archive_build_segment(candidates[start].term, &candidates[start], end - start);
+        ok = built[segments] != NULL;
+        start = end;
+    }
+    if (!ok) {
+        for (int s = 0; built && s < segments; s++) free(built[s]);
+        unlock_all_records();
+        free(built);
+        free(positions);
+        free(candidates);
+        log_operation(LOG_ERROR, LOG_OP_ARCHIVE, "Archive allocation failed");
+        return RESULT_OUT_OF_MEMORY;
+    }
+    
+    /* Archived grades never change, so their bounds are kept with the course */
+    for (int i = 0; i < count; i++) {
+        const EnrollmentColumns *columns = enrollment_columns_at(candidates[i].index);
+        int slot = table_slot(candidates[i].index);
+        if (columns->status[slot] != 2) continue;
+        Course *course = course_at(find_course(columns->course_id[slot]));
+        float grade = columns->grade[slot];
+        if (course->archived_graded == 0 || grade < course->archived_grade_min) course->archived_grade_min = grade;
+        if (course->archived_graded == 0 || grade > course->archived_grade_max) course->archived_grade_max = grade;
+        course->archived_graded++;
+    }
+    
+    int live = 0;
+    for (int i = 0; i < enrollment_count; i++) {
+        if (positions[i] == -1) continue;
+        if (live != i) move_enrollment_row(i, live);
+        positions[i] = live++;
+    }
+    
+    /* Waitlisted rows are never archived, so every waitlist head has a new position */
+    for (int s = 0; s < student_count; s++) {
+        student_at(s)->first_enrollment = student_at(s)->last_enrollment = -1;
+    }
+    for (int c = 0; c < course_count; c++) {
+        Course *course = course_at(c);
+        course->first_enrollment = course->last_enrollment = -1;
+        if (course->waitlist_head != -1) course->waitlist_head = positions[course->waitlist_head];
+    }
+    id_index_clear(&enrollment_id_index);
+    for (int i = 0; i < live; i++) {
+        Enrollment *enrollment = enrollment_at(i);
+        const EnrollmentColumns *columns = enrollment_columns_at(i);
+        enrollment->next_student_enrollment = -1;
+        enrollment->next_course_enrollment = -1;
+        link_enrollment(i, find_student(columns->student_id[table_slot(i)]),
+                        find_course(columns->course_id[table_slot(i)]));
+        id_index_insert(&enrollment_id_index, enrollment->enrollment_id, i); /* fewer entries than before */
+    }
+    enrollment_count = live;
+    for (int s = 0; s < segments; s++) archive_segments[archive_segment_count++] = built[s];
+    archived_enrollment_count += count;
+    
+    if (count > 0) {
+        JournalArchiveRecord record = { through_term, count };
+        journal_append(JOURNAL_ARCHIVE, &record, sizeof(record));
+    }
+    unlock_all_records();
+    free(built);
+    free(positions);
+    free(candidates);
+    
+    *archived = count;
+    log_operationf(LOG_SUCCESS, LOG_OP_ARCHIVE, "Archived %d enrollments into %d segment%s; %d remain live",
+                   count, segments, segments == 1 ? "" : "s", live);
+    return RESULT_OK;
+}
+
+/* ============================================================================
+   BULK OPERATIONS
+   ============================================================================ */
+
+int compare_bulk_order(const void *a, const void *b) {
+    const BulkOrder *left = a, *right = b;
+    if (left->course_index != right->course_index) {
+        return left->course_index < right->course_index ? -1 : 1;
+    }
+    return (left->position > right->position) - (left->position < right->position);
+}
+
+/**
+ * Enroll many (student, course) pairs at once. Every ID is resolved once
+ * with writers held off for the whole batch; requests are then applied
+ * course by course, claiming the seats for a course in one step. Requests
+ * beyond capacity are waitlisted in input order. One summary line is logged.
+ * Returns the number of failed requests, or -1 when out of memory.
+ */
+int bulk_enroll(EnrollmentRequest *requests, int count) {
+    BulkOrder *order = malloc((size_t)(count > 0 ? count : 1) * sizeof(BulkOrder));
+    if (!order) {
+        log_operation(LOG_ERROR, LOG_OP_ENROLLMENT, "Bulk enrollment allocation failed");
+        return -1;
+    }
+    
+    lock_all_records();
+    int ordered = 0;
+    for (int i = 0; i < count; i++) {
+        int student_index = find_student(requests[i].student_id);
+        int course_index = find_course(requests[i].course_id);
+        requests[i].enrollment_id = 0;
+        if (student_index == -1) {
+            requests[i].result = RESULT_STUDENT_NOT_FOUND;
+        } else if (course_index == -1) {
+            requests[i].result = RESULT_COURSE_NOT_FOUND;
+        } else {
+            order[ordered++] = (BulkOrder){ course_index, student_index, -1, i };
+        }
+    }
+    qsort(order, ordered, sizeof(BulkOrder), compare_bulk_order);
+    
+    for (int start = 0, end; start < ordered; start = end) {
+        Course *course = course_at(order[start].course_index);
+        for (end = start; end < ordered && order[end].course_index == order[start].course_index; end++) {}
+        
+        int seats = 0, seated_count = 0;
+        for (int k = start; k < end; k++) {
+            EnrollmentRequest *request = &requests[order[k].position];
+            request->result = check_enrollment(student_at(order[k].student_index), course, 0);
+            if (request->result != RESULT_OK) continue;
+            
+            /* Seats for the rest of the group are claimed together; once
+               anyone waits, later requests queue behind them */
+            if (seats == 0 && course->waitlist_count == 0) seats = seat_reserve_many(course, end - k);
+            int seated = seats > 0;
+            int index = append_enrollment_row(request->student_id, course, seated ? 0 : 4);
+            if (index == -1) {
+                request->result = RESULT_OUT_OF_MEMORY;
+                continue;
+            }
+            
+            link_enrollment(index, order[k].student_index, order[k].course_index);
+            request->enrollment_id = enrollment_at(index)->enrollment_id;
+            if (seated) {
+                seats--;
+                seated_count++;
+            } else {
+                if (course->waitlist_head == -1) course->waitlist_head = index;
+                course->waitlist_count++;
+                request->result = RESULT_WAITLISTED;
+            }
+        }
+        if (seats > 0) seat_release_many(course, seats);
+        if (seated_count > 0) stats_enrollment_added(course, seated_count);
+    }
+    unlock_all_records();
+    free(order);
+    
+    int enrolled = 0, waitlisted = 0;
+    for (int i = 0; i < count; i++) {
+        if (requests[i].result == RESULT_OK) enrolled++;
+        else if (requests[i].result == RESULT_WAITLISTED) waitlisted++;
+    }
+    int failed = count - enrolled - waitlisted;
+    log_operationf(failed ? LOG_WARNING : LOG_SUCCESS, LOG_OP_ENROLLMENT,
+                   "Bulk enrolled %d of %d requests (%d waitlisted, %d failed)",
+                   enrolled, count, waitlisted, failed);
+    return failed;
+}
+
+/**
+ * Record many (enrollment, grade) pairs at once, resolving every ID once and
+ * applying the grades course by course. One summary line is logged.
+ * Returns the number of failed requests, or -1 when out of memory.
+ */
+int bulk_grade(GradeRequest *requests, int count) {
+    BulkOrder *order = malloc((size_t)(count > 0 ? count : 1) * sizeof(BulkOrder));
+    if (!order) {
+        log_operation(LOG_ERROR, LOG_OP_RECORD_GRADE, "Bulk grade allocation failed");
+        return -1;
+    }
+    
+    lock_all_records();
+    int ordered = 0;
+    for (int i = 0; i < count; i++) {
+        int enrollment_index = find_enrollment(requests[i].enrollment_id);
+        if (requests[i].grade < MIN_GRADE || requests[i].grade > MAX_GRADE) {
+            requests[i].result = RESULT_INVALID_GRADE;
+        } else if (enrollment_index == -1) {
+            ArchivedEnrollment row;
+            requests[i].result = find_archived_enrollment(requests[i].enrollment_id, &row)
+                ? RESULT_ENROLLMENT_ARCHIVED : RESULT_ENROLLMENT_NOT_FOUND;
+        } else {
+            EnrollmentColumns *columns = enrollment_columns_at(enrollment_index);
+            int slot = table_slot(enrollment_index);
+            order[ordered++] = (BulkOrder){ find_course(columns->course_id[slot]),
+                                            find_student(columns->student_id[slot]),
+                                            enrollment_index, i };
+        }
+    }
+    qsort(order, ordered, sizeof(BulkOrder), compare_bulk_order);
+    
+    for (int k = 0; k < ordered; k++) {
+        GradeRequest *request = &requests[order[k].position];
+        request->result = grade_enrollment_row(order[k].enrollment_index,
+                                               student_at(order[k].student_index),
+                                               course_at(order[k].course_index), request->grade);
+    }
+    unlock_all_records();
+    free(order);
+    
+    int failed = 0;
+    for (int i = 0; i < count; i++) {
+        if (requests[i].result != RESULT_OK) failed++;
+    }
+    log_operationf(failed ? LOG_WARNING : LOG_SUCCESS, LOG_OP_RECORD_GRADE,
+                   "Bulk recorded %d of %d grades (%d failed)", count - failed, count, failed);
+    return failed;
+}
+
+/* ============================================================================
+   STUDENT MANAGEMENT FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Add a new student to the system
+ */
+int add_student(void) {
+    int index = reserve_student();
+    if (index == -1) {
+        printf("Error: Out of memory while allocating student!\n");
+        return 0;
+    }
+    
+    Student *student = student_at(index);
+    StudentProfile *profile = student_profile_at(index);
+    
+    printf("\n");
+    print_separator('=', 60);
+    printf("                    ADD NEW STUDENT\n");
+    print_separator('=', 60);
+    
+    printf("Enter student name: ");
+    fgets(profile->name, MAX_NAME_LENGTH, stdin);
+    profile->name[strcspn(profile->name, "\n")] = 0;
+    
+    printf("Enter email address: ");
+    fgets(profile->email, MAX_NAME_LENGTH, stdin);
+    profile->email[strcspn(profile->email, "\n")] = 0;
+    
+    if (!is_valid_email(profile->email)) {
+        printf("Warning: Email format may be invalid\n");
+        log_operation(LOG_WARNING, LOG_OP_ADD_STUDENT, "Invalid email format");
+    }
+    
+    printf("Enter phone number: ");
+    fgets(profile->phone, 20, stdin);
+    profile->phone[strcspn(profile->phone, "\n")] = 0;
+    
+    if (!is_valid_phone(profile->phone)) {
+        printf("Warning: Phone number format may be invalid\n");
+        log_operation(LOG_WARNING, LOG_OP_ADD_STUDENT, "Invalid phone format");
+    }
+    
+    printf("Enter address: ");
+    fgets(profile->address, MAX_DESCRIPTION, stdin);
+    profile->address[strcspn(profile->address, "\n")] = 0;
+    
+    printf("Enter admission year: ");
+    scanf("%d", &profile->admission_year);
+    clear_input_buffer();
+    
+    char major[MAX_NAME_LENGTH];
+    printf("Enter major: ");
+    if (!fgets(major, sizeof(major), stdin)) major[0] = '\0';
+    major[strcspn(major, "\n")] = 0;
+    student->major_id = intern_string(major);
+    
+    if (commit_student(index) != RESULT_OK) {
+        printf("Error: Out of memory while indexing student!\n");
+        return 0;
+    }
+    
+    printf("\n✓ Student added successfully with ID: %d\n", student->student_id);
+    return 1;
+}
+
+/**
+ * Print one page of the student table
+ */
+void print_student_list(ListPage page) {
+    pthread_rwlock_rdlock(&student_table_lock);
+    int count = student_count;
+    pthread_rwlock_unlock(&student_table_lock);
+    
+    FILE *out = render_begin();
+    if (count == 0) {
+        fprintf(out, "No students in the system.\n");
+        render_end();
+        return;
+    }
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 100);
+    fprintf(out, "%-6s %-25s %-30s %-15s %-10s\n", "ID", "Name", "Email", "Phone", "Major");
+    write_separator(out, '=', 100);
+    
+    /* Rows below count are fully written and never move */
+    for (long long i = page_first_row(&page); i < count && !page_done(&page, i); i++) {
+        if (student_at(i)->is_active) {
+            StudentProfile *profile = student_profile_at(i);
+            fprintf(out, "%-6d %-25s %-30s %-15s %-10s\n",
+                    student_at(i)->student_id,
+                    profile->name,
+                    profile->email,
+                    profile->phone,
+                    interned_text(student_at(i)->major_id));
+        }
+    }
+    
+    write_separator(out, '=', 100);
+    fprintf(out, "Total Active Students: %d\n", count);
+    write_page_footer(out, &page, count);
+    fprintf(out, "\n");
+    render_end();
+}
+
+/**
+ * Display all students
+ */
+void display_all_students(void) {
+    print_student_list(LIST_ALL_ROWS);
+}
+
+/**
+ * Display student details
+ */
+void display_student_details(int student_id) {
+    FILE *out = session_output();
+    int i = lookup_student(student_id);
+    Student *student = i != -1 ? student_at(i) : NULL;
+    if (student && student->is_active) {
+        StudentProfile *profile = student_profile_at(i);
+        fprintf(out, "\n");
+        print_separator('=', 60);
+        fprintf(out, "                    STUDENT DETAILS\n");
+        print_separator('=', 60);
+        fprintf(out, "Student ID:      %d\n", student->student_id);
+        fprintf(out, "Name:            %s\n", profile->name);
+        fprintf(out, "Email:           %s\n", profile->email);
+        fprintf(out, "Phone:           %s\n", profile->phone);
+        fprintf(out, "Address:         %s\n", profile->address);
+        fprintf(out, "Admission Year:  %d\n", profile->admission_year);
+        fprintf(out, "Major:           %s\n", interned_text(student->major_id));
+        fprintf(out, "Status:          %s\n", student->is_active ? "Active" : "Inactive");
+        
+        char datetime[50];
+        get_current_datetime_string(datetime, sizeof(datetime));
+        fprintf(out, "Registration:    %s\n", datetime);
+        print_separator('=', 60);
+        fprintf(out, "\n");
+        return;
+    }
+    
+    fprintf(out, "Student not found.\n");
+    log_operation(LOG_WARNING, LOG_OP_DISPLAY_STUDENT, "Student ID not found");
+}
+
+/**
+ * Run a name search and print the ranked matches
+ */
+void print_name_search(const char *text, int flags, int limit) {
+    FILE *out = render_begin();
+    NameMatch best[SEARCH_MAX_LIMIT];
+    int total;
+    if (limit > SEARCH_MAX_LIMIT) limit = SEARCH_MAX_LIMIT;
+    uint64_t started = monotonic_ns();
+    pthread_rwlock_rdlock(&student_table_lock);
+    int found = search_students(text, flags, best, limit, &total);
+    pthread_rwlock_unlock(&student_table_lock);
+    metric_record(METRIC_NAME_SEARCH, started, 1);
+    
+    fprintf(out, "\n");
+    print_separator('=', 100);
+    fprintf(out, "%-6s %-25s %-30s %-15s %-10s\n", "ID", "Name", "Email", "Phone", "Major");
+    print_separator('=', 100);
+    
+    for (int i = 0; i < found; i++) {
+        int index = best[i].student_index;
+        StudentProfile *profile = student_profile_at(index);
+        fprintf(out, "%-6d %-25s %-30s %-15s %-10s\n",
+                     student_at(index)->student_id,
+                     profile->name,
+                     profile->email,
+                     profile->phone,
+                     interned_text(student_at(index)->major_id));
+    }
+    
+    print_separator('=', 100);
+    
+    if (total == 0) {
+        fprintf(out, "No students found matching '%s'\n", text);
+    } else if (total > found) {
+        fprintf(out, "Found %d student(s), showing the best %d\n", total, found);
+    } else {
+        fprintf(out, "Found %d student(s)\n", total);
+    }
+    fprintf(out, "\n");
+    render_end();
+}
+
+/**
+ * Search student by name
+ */
+void search_student_by_name(void) {
+    char search_name[MAX_NAME_LENGTH];
+    char answer[16];
+    int flags = 0;
+    
+    printf("Enter student name to search: ");
+    fgets(search_name, MAX_NAME_LENGTH, stdin);
+    search_name[strcspn(search_name, "\n")] = 0;
+    printf("Ignore case? (y/n): ");
+    if (fgets(answer, sizeof(answer), stdin) && tolower((unsigned char)answer[0]) == 'y') {
+        flags |= SEARCH_IGNORE_CASE;
+    }
+    printf("Match name start only? (y/n): ");
+    if (fgets(answer, sizeof(answer), stdin) && tolower((unsigned char)answer[0]) == 'y') {
+        flags |= SEARCH_PREFIX;
+    }
+    
+    print_name_search(search_name, flags, SEARCH_DEFAULT_LIMIT);
+}
+
+/* ============================================================================
+   COURSE MANAGEMENT FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Add a new course
+ */
+int add_course(void) {
+    int index = reserve_course();
+    if (index == -1) {
+        printf("Error: Out of memory while allocating course!\n");
+        return 0;
+    }
+    
+    Course *course = course_at(index);
+    CourseDetails *details = course_details_at(index);
+    
+    printf("\n");
+    print_separator('=', 60);
+    printf("                     ADD NEW COURSE\n");
+    print_separator('=', 60);
+    
+    char code[MAX_COURSE_CODE];
+    printf("Enter course code (e.g., CS101): ");
+    if (!fgets(code, sizeof(code), stdin)) code[0] = '\0';
+    code[strcspn(code, "\n")] = 0;
+    course->code_id = intern_string(code);
+    
+    printf("Enter course name: ");
+    fgets(details->course_name, MAX_NAME_LENGTH, stdin);
+    details->course_name[strcspn(details->course_name, "\n")] = 0;
+    
+    printf("Enter course description: ");
+    fgets(details->description, MAX_DESCRIPTION, stdin);
+    details->description[strcspn(details->description, "\n")] = 0;
+    
+    printf("Enter course credits: ");
+    scanf("%d", &course->credits);
+    
+    printf("Enter maximum capacity: ");
+    scanf("%d", &course->max_capacity);
+    course->max_capacity = shard_seat_quota(course->max_capacity);
+    
+    printf("Enter difficulty level (1.0 - 5.0): ");
+    scanf("%f", &course->difficulty_level);
+    
+    clear_input_buffer();
+    
+    if (commit_course(index) != RESULT_OK) {
+        printf("Error: Out of memory while indexing course!\n");
+        return 0;
+    }
+    
+    printf("\n✓ Course added successfully with ID: %d\n", course->course_id);
+    return 1;
+}
+
+/**
+ * Print one page of the course table
+ */
+void print_course_list(ListPage page) {
+    pthread_rwlock_rdlock(&course_table_lock);
+    int count = course_count;
+    pthread_rwlock_unlock(&course_table_lock);
+    
+    FILE *out = render_begin();
+    if (count == 0) {
+        fprintf(out, "No courses in the system.\n");
+        render_end();
+        return;
+    }
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 120);
+    fprintf(out, "%-6s %-10s %-25s %-8s %-12s %-10s %-15s\n",
+            "ID", "Code", "Name", "Credits", "Capacity", "Enrolled", "Difficulty");
+    write_separator(out, '=', 120);
+    
+    for (long long i = page_first_row(&page); i < count && !page_done(&page, i); i++) {
+        Course *course = course_at(i);
+        fprintf(out, "%-6d %-10s %-25s %-8d %-12d %-10d %-15.1f\n",
+                course->course_id,
+                interned_text(course->code_id),
+                course_details_at(i)->course_name,
+                course->credits,
+                course->max_capacity,
+                course->current_enrollment,
+                course->difficulty_level);
+    }
+    
+    write_separator(out, '=', 120);
+    fprintf(out, "Total Courses: %d\n", count);
+    write_page_footer(out, &page, count);
+    fprintf(out, "\n");
+    render_end();
+}
+
+/**
+ * Display all courses
+ */
+void display_all_courses(void) {
+    print_course_list(LIST_ALL_ROWS);
+}
+
+/**
+ * Display course details
+ */
+void display_course_details(int course_id) {
+    FILE *out = session_output();
+    int i = lookup_course(course_id);
+    if (i != -1) {
+        lock_read(course_lock(course_id), CONTENTION_COURSE_LOCK);
+        Course *course = course_at(i);
+        CourseDetails *details = course_details_at(i);
+        fprintf(out, "\n");
+        print_separator('=', 70);
+        fprintf(out, "                      COURSE DETAILS\n");
+        print_separator('=', 70);
+        fprintf(out, "Course ID:           %d\n", course->course_id);
+        fprintf(out, "Course Code:         %s\n", interned_text(course->code_id));
+        fprintf(out, "Course Name:         %s\n", details->course_name);
+        fprintf(out, "Description:         %s\n", details->description);
+        fprintf(out, "Credits:             %d\n", course->credits);
+        fprintf(out, "Maximum Capacity:    %d\n", course->max_capacity);
+        fprintf(out, "Current Enrollment:  %d\n", course->current_enrollment);
+        fprintf(out, "Enrollment Rate:     %.1f%%\n", 
+                     (float)course->current_enrollment / course->max_capacity * 100);
+        fprintf(out, "Difficulty Level:    %.1f/5.0\n", course->difficulty_level);
+        fprintf(out, "Available Seats:     %d\n", course->max_capacity - course->current_enrollment);
+        fprintf(out, "Waitlisted:          %d\n", course->waitlist_count);
+        pthread_rwlock_unlock(course_lock(course_id));
+        print_separator('=', 70);
+        fprintf(out, "\n");
+        return;
+    }
+    
+    fprintf(out, "Course not found.\n");
+    log_operation(LOG_WARNING, LOG_OP_DISPLAY_COURSE, "Course ID not found");
+}
+
+/* ============================================================================
+   ENROLLMENT MANAGEMENT FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Enroll a student in a course
+ */
+int enroll_student_in_course(void) {
+    printf("\n");
+    print_separator('=', 60);
+    printf("                  ENROLL STUDENT\n");
+    print_separator('=', 60);
+    
+    printf("Enter student ID: ");
+    int student_id;
+    scanf("%d", &student_id);
+    
+    printf("Enter course ID: ");
+    int course_id;
+    scanf("%d", &course_id);
+    
+    clear_input_buffer();
+    
+    int enrollment_id;
+    int result = create_enrollment(student_id, course_id, &enrollment_id);
+    if (result == RESULT_WAITLISTED) {
+        printf("\nCourse is full; student added to the waitlist.\n");
+        printf("  Enrollment ID: %d\n", enrollment_id);
+        return 1;
+    }
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return 0;
+    }
+    
+    printf("\n✓ Student successfully enrolled in course!\n");
+    printf("  Enrollment ID: %d\n", enrollment_id);
+    return 1;
+}
+
+/**
+ * Print a student's enrollments
+ */
+void print_student_enrollments(int student_id, ListPage page) {
+    FILE *out = render_begin();
+    /* Verify student exists */
+    int student_index = lookup_student(student_id);
+    if (student_index == -1) {
+        fprintf(out, "Student not found.\n");
+        render_end();
+        return;
+    }
+    
+    lock_read(student_lock(student_id), CONTENTION_STUDENT_LOCK);
+    fprintf(out, "\n");
+    write_separator(out, '=', 100);
+    fprintf(out, "%-6s %-25s %-10s %-10s %-8s %-15s\n", 
+                 "Enr.ID", "Course Name", "Course Code", "Credits", "Grade", "Status");
+    write_separator(out, '=', 100);
+    
+    /* Archived rows are merged in by enrollment ID, the order of the live list */
+    ArchivedEnrollment *archived = NULL;
+    int archived_count = archive_student_rows(student_id, &archived);
+    if (archived_count == -1) {
+        fprintf(out, "Warning: archived enrollments could not be read.\n");
+        archived_count = 0;
+    }
+    
+    int enrolled = 0;
+    int a = 0;
+    for (int i = student_at(student_index)->first_enrollment; i != -1 || a < archived_count;) {
+        int from_archive = a < archived_count &&
+                           (i == -1 || archived[a].enrollment_id < enrollment_at(i)->enrollment_id);
+        ArchivedEnrollment row;
+        if (from_archive) {
+            row = archived[a++];
+        } else {
+            const EnrollmentColumns *columns = enrollment_columns_at(i);
+            int slot = table_slot(i);
+            row.enrollment_id = enrollment_at(i)->enrollment_id;
+            row.course_id = columns->course_id[slot];
+            row.credits = columns->credits[slot];
+            row.grade = columns->grade[slot];
+            row.status = columns->status[slot];
+            i = enrollment_at(i)->next_student_enrollment;
+        }
+        if (enrolled < page_first_row(&page) || page_done(&page, enrolled)) {
+            enrolled++;
+            continue;
+        }
+        
+        /* Find course name */
+        char course_name[MAX_NAME_LENGTH] = "Unknown";
+        char course_code[MAX_COURSE_CODE] = "Unknown";
+        
+        int j = lookup_course(row.course_id);
+        if (j != -1) {
+            strcpy(course_name, course_details_at(j)->course_name);
+            copy_field(course_code, sizeof(course_code), interned_text(course_at(j)->code_id));
+        }
+        
+        char status[20] = "Pending";
+        if (row.status == 1) strcpy(status, "Active");
+        else if (row.status == 2) strcpy(status, "Completed");
+        else if (row.status == 3) strcpy(status, "Dropped");
+        else if (row.status == 4) strcpy(status, "Waitlisted");
+        
+        fprintf(out, "%-6d %-25s %-10s %-10d %-8.1f %-15s\n",
+                     row.enrollment_id,
+                     course_name,
+                     course_code,
+                     row.credits,
+                     row.grade,
+                     status);
+        enrolled++;
+    }
+    free(archived);
+    
+    Student *student = student_at(student_index);
+    int credits_completed = student->credits_completed;
+    double weighted_points = student->weighted_points_total;
+    pthread_rwlock_unlock(student_lock(student_id));
+    write_separator(out, '=', 100);
+    
+    if (enrolled == 0) {
+        fprintf(out, "Student has no enrollments.\n");
+    } else {
+        fprintf(out, "Total Enrollments: %d\n", enrolled);
+        if (credits_completed > 0) {
+            fprintf(out, "Credits Completed: %d, Credit-Weighted GPA: %.2f\n",
+                    credits_completed, weighted_points / credits_completed);
+        }
+        write_page_footer(out, &page, enrolled);
+    }
+    fprintf(out, "\n");
+    render_end();
+}
+
+/**
+ * View student enrollments
+ */
+void view_student_enrollments(void) {
+    printf("Enter student ID: ");
+    int student_id;
+    scanf("%d", &student_id);
+    clear_input_buffer();
+    print_student_enrollments(student_id, LIST_ALL_ROWS);
+}
+
+/* ============================================================================
+   GRADE MANAGEMENT FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Print the assessments of an enrollment in arrival order, with each type's
+ * score and the grade currently on the enrollment
+ */
+void print_assessments(int enrollment_id) {
+    FILE *out = render_begin();
+    ArchivedEnrollment archived;
+    int enrollment_index = lookup_enrollment(enrollment_id);
+    int student_id;
+    if (enrollment_index != -1) {
+        student_id = enrollment_columns_at(enrollment_index)->student_id[table_slot(enrollment_index)];
+    } else if (lookup_archived_enrollment(enrollment_id, &archived)) {
+        student_id = archived.student_id;
+    } else {
+        fprintf(out, "Enrollment not found.\n");
+        render_end();
+        return;
+    }
+    
+    /* The student lock keeps the row in place; it may have been archived since the lookup */
+    lock_read(student_lock(student_id), CONTENTION_STUDENT_LOCK);
+    enrollment_index = lookup_enrollment(enrollment_id);
+    if (enrollment_index == -1) lookup_archived_enrollment(enrollment_id, &archived);
+    fprintf(out, "\n");
+    write_separator(out, '=', 80);
+    fprintf(out, "              ASSESSMENTS FOR ENROLLMENT %d\n", enrollment_id);
+    write_separator(out, '=', 80);
+    fprintf(out, "%-8s %-12s %-10s %-10s %-8s %-20s\n", "ID", "Type", "Marks", "Out Of", "Score", "Date");
+    write_separator(out, '-', 80);
+    
+    /* Records of a live enrollment are linked from it; those of an archived
+       one are found by scanning the assessment table */
+    float marks[ASSESSMENT_TYPE_COUNT] = { 0 }, totals[ASSESSMENT_TYPE_COUNT] = { 0 };
+    int records = committed_count(&assessment_table_lock, &assessment_count);
+    int listed = 0;
+    int i = enrollment_index != -1 ? enrollment_at(enrollment_index)->first_assessment : 0;
+    while (enrollment_index != -1 ? i != -1 : i < records) {
+        const GradeRecord *record = grade_record_at(i);
+        i = enrollment_index != -1 ? record->next_assessment : i + 1;
+        if (record->enrollment_id != enrollment_id) continue;
+        
+        char date[32];
+        struct tm tm_info;
+        localtime_r(&record->assessment_date, &tm_info);
+        strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm_info);
+        fprintf(out, "%-8d %-12s %-10.2f %-10.2f %-8.1f %s\n", record->assessment_id,
+                interned_text(record->assessment_type_id), record->marks_obtained, record->total_marks,
+                record->percentage, date);
+        int type = parse_assessment_type(interned_text(record->assessment_type_id));
+        if (type != -1) {
+            marks[type] += record->marks_obtained;
+            totals[type] += record->total_marks;
+        }
+        listed++;
+    }
+    
+    write_separator(out, '-', 80);
+    for (int type = 0; type < ASSESSMENT_TYPE_COUNT; type++) {
+        if (totals[type] <= 0.0f) continue;
+        fprintf(out, "%-12s %6.1f%%  (weight %.0f%%)\n", assessment_type_names[type],
+                MAX_GRADE * marks[type] / totals[type], assessment_weights[type] * 100.0f);
+    }
+    fprintf(out, "Assessments: %d\n", listed);
+    if (enrollment_index != -1) {
+        const EnrollmentColumns *columns = enrollment_columns_at(enrollment_index);
+        int slot = table_slot(enrollment_index);
+        if (listed > 0) {
+            fprintf(out, "Running Grade: %.2f\n", weighted_assessment_grade(enrollment_at(enrollment_index)));
+        }
+        if (columns->status[slot] == 2) {
+            fprintf(out, "Final Grade: %.2f (%c)\n", columns->grade[slot],
+                    enrollment_at(enrollment_index)->letter_grade);
+        } else {
+            fprintf(out, "Final Grade: not recorded\n");
+        }
+    } else {
+        fprintf(out, "Final Grade: %.2f (%c), archived\n", archived.grade,
+                archived.status == 2 ? get_letter_grade(archived.grade) : '-');
+    }
+    write_separator(out, '=', 80);
+    pthread_rwlock_unlock(student_lock(student_id));
+    render_end();
+}
+
+/**
+ * Record a grade for a student
+ */
+int record_grade(void) {
+    printf("\n");
+    print_separator('=', 60);
+    printf("                   RECORD GRADE\n");
+    print_separator('=', 60);
+    
+    printf("Enter enrollment ID: ");
+    int enrollment_id;
+    scanf("%d", &enrollment_id);
+    
+    printf("Enter grade (0-100): ");
+    float grade;
+    scanf("%f", &grade);
+    
+    clear_input_buffer();
+    
+    int result = apply_grade(enrollment_id, grade);
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return 0;
+    }
+    
+    int enrollment_index = find_enrollment(enrollment_id);
+    printf("\n✓ Grade recorded successfully!\n");
+    printf("  Enrollment ID: %d\n", enrollment_id);
+    printf("  Grade: %.2f (%c)\n", grade, enrollment_at(enrollment_index)->letter_grade);
+    printf("  GPA Points: %.2f\n",
+           enrollment_columns_at(enrollment_index)->credit_points[table_slot(enrollment_index)]);
+    return 1;
+}
+
+/**
+ * Record one assessment for an enrollment and show the updated gradebook
+ */
+int record_assessment(void) {
+    printf("\n");
+    print_separator('=', 60);
+    printf("                 RECORD ASSESSMENT\n");
+    print_separator('=', 60);
+    
+    printf("Enter enrollment ID: ");
+    int enrollment_id;
+    scanf("%d", &enrollment_id);
+    
+    printf("Enter type (Quiz/Assignment/Midterm/Final): ");
+    char type[20];
+    scanf("%19s", type);
+    
+    printf("Enter marks obtained: ");
+    float marks;
+    scanf("%f", &marks);
+    
+    printf("Enter total marks: ");
+    float total_marks;
+    scanf("%f", &total_marks);
+    
+    clear_input_buffer();
+    
+    int assessment_id;
+    int result = apply_assessment(enrollment_id, parse_assessment_type(type), marks, total_marks,
+                                  &assessment_id);
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return 0;
+    }
+    
+    printf("\n✓ Assessment recorded successfully!\n");
+    printf("  Assessment ID: %d\n", assessment_id);
+    print_assessments(enrollment_id);
+    return 1;
+}
+
+/**
+ * Drop an enrollment, promoting the next waitlisted student if a seat frees up
+ */
+int drop_student_enrollment(void) {
+    printf("\n");
+    print_separator('=', 60);
+    printf("                 DROP ENROLLMENT\n");
+    print_separator('=', 60);
+    
+    printf("Enter enrollment ID: ");
+    int enrollment_id;
+    scanf("%d", &enrollment_id);
+    
+    clear_input_buffer();
+    
+    int result = drop_enrollment(enrollment_id);
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return 0;
+    }
+    
+    printf("\n✓ Enrollment %d dropped.\n", enrollment_id);
+    return 1;
+}
+
+/**
+ * Print every archive segment with its size against the live row layout
+ */
+void print_archive_summary(void) {
+    FILE *out = render_begin();
+    double live_row_bytes = sizeof(Enrollment) + (double)sizeof(EnrollmentColumns) / TABLE_CHUNK_SIZE;
+    
+    pthread_rwlock_rdlock(&enrollment_table_lock);
+    fprintf(out, "\n");
+    write_separator(out, '=', 60);
+    fprintf(out, "                    ENROLLMENT ARCHIVE\n");
+    write_separator(out, '=', 60);
+    fprintf(out, "%-14s %-10s %-12s %-10s\n", "Term", "Rows", "Bytes", "Bytes/Row");
+    write_separator(out, '-', 60);
+    uint64_t total_bytes = 0;
+    for (int s = 0; s < archive_segment_count; s++) {
+        const ArchiveSegment *segment = archive_segments[s];
+        char term[32];
+        format_term(segment->term, term, sizeof(term));
+        fprintf(out, "%-14s %-10d %-12u %-10.2f\n", term, segment->row_count, segment->size,
+                (double)segment->size / segment->row_count);
+        total_bytes += segment->size;
+    }
+    write_separator(out, '=', 60);
+    fprintf(out, "Archived: %d enrollments in %llu bytes", archived_enrollment_count,
+            (unsigned long long)total_bytes);
+    if (archived_enrollment_count > 0) {
+        fprintf(out, ", %.2f bytes/row", (double)total_bytes / archived_enrollment_count);
+    }
+    fprintf(out, "\nLive: %d enrollments at %.2f bytes/row\n", enrollment_count, live_row_bytes);
+    pthread_rwlock_unlock(&enrollment_table_lock);
+    render_end();
+}
+
+/**
+ * Archive the enrollments of every term up to one read from the menu
+ */
+void archive_interactive(void) {
+    printf("\n");
+    print_separator('=', 60);
+    printf("                 ARCHIVE PAST TERMS\n");
+    print_separator('=', 60);
+    
+    printf("Archive through year: ");
+    int year;
+    if (scanf("%d", &year) != 1) year = 0;
+    
+    printf("Term (spring/fall): ");
+    char half[16];
+    if (scanf("%15s", half) != 1) half[0] = '\0';
+    
+    clear_input_buffer();
+    
+    int term = term_number(year, half);
+    int archived;
+    int result = term == -1 ? RESULT_INVALID_TERM : archive_enrollments(term, &archived);
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return;
+    }
+    
+    char name[32];
+    format_term(term, name, sizeof(name));
+    printf("\n✓ Archived %d enrollments through %s.\n", archived, name);
+    print_archive_summary();
+}
+
+/**
+ * Print a student's GPA and credit-weighted GPA from the cached totals
+ */
+void print_student_gpa(int student_id) {
+    FILE *out = session_output();
+    /* Verify student exists */
+    int student_index = lookup_student(student_id);
+    
+    if (student_index == -1) {
+        fprintf(out, "Student not found.\n");
+        return;
+    }
+    
+    Student *student = student_at(student_index);
+    lock_read(student_lock(student_id), CONTENTION_STUDENT_LOCK);
+    float total_gpa = (float)student->credit_points_total;
+    int completed_courses = student->completed_courses;
+    double weighted_points = student->weighted_points_total;
+    int credits_completed = student->credits_completed;
+    pthread_rwlock_unlock(student_lock(student_id));
+    
+    fprintf(out, "\n");
+    print_separator('=', 60);
+    fprintf(out, "                    STUDENT GPA\n");
+    print_separator('=', 60);
+    fprintf(out, "Student: %s\n", student_profile_at(student_index)->name);
+    fprintf(out, "Student ID: %d\n", student_id);
+    fprintf(out, "Completed Courses: %d\n", completed_courses);
+    fprintf(out, "Credits Completed: %d\n", credits_completed);
+    
+    if (completed_courses > 0) {
+        float gpa = total_gpa / completed_courses;
+        fprintf(out, "GPA: %.2f\n", gpa);
+        if (credits_completed > 0) {
+            fprintf(out, "Credit-Weighted GPA: %.2f\n", weighted_points / credits_completed);
+        }
+    } else {
+        fprintf(out, "GPA: N/A (No completed courses)\n");
+    }
+    
+    print_separator('=', 60);
+    fprintf(out, "\n");
+}
+
+/**
+ * Calculate student GPA
+ */
+void calculate_student_gpa(void) {
+    printf("Enter student ID: ");
+    int student_id;
+    scanf("%d", &student_id);
+    clear_input_buffer();
+    print_student_gpa(student_id);
+}
+
+/* ============================================================================
+   ANALYTICS AND REPORTING FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Print the system statistics report for a copy of the statistics
+ */
+void write_system_statistics(FILE *out, const SystemStats *stats, unsigned long long log_entries) {
+    fprintf(out, "\n");
+    write_separator(out, '=', 80);
+    fprintf(out, "                      SYSTEM STATISTICS\n");
+    write_separator(out, '=', 80);
+    
+    fprintf(out, "Total Students (Active):    %d\n", stats->total_students);
+    fprintf(out, "Total Courses:              %d\n", stats->total_courses);
+    fprintf(out, "Total Enrollments:          %d\n", stats->total_enrollments);
+    fprintf(out, "Total Log Entries:          %llu\n", log_entries);
+    
+    /* Averages are maintained by record_grade and enroll_student_in_course */
+    if (stats->completed_enrollments > 0) {
+        fprintf(out, "Average GPA (System):       %.2f\n", stats->average_gpa);
+    }
+    
+    if (stats->total_courses > 0) {
+        fprintf(out, "Average Enrollment Rate:    %.1f%%\n", stats->average_enrollment_rate * 100);
+    }
+    
+    write_separator(out, '=', 80);
+    fprintf(out, "\n");
+}
+
+/**
+ * Display system statistics
+ */
+void display_system_statistics(void) {
+    pthread_mutex_lock(&stats_lock);
+    SystemStats stats = system_stats;
+    pthread_mutex_unlock(&stats_lock);
+    write_system_statistics(session_output(), &stats, (unsigned long long)log_entries_written());
+}
+
+/**
+ * Print the class statistics report of a course from its grade aggregates
+ */
+void write_class_statistics(FILE *out, int course_id, const char *name, const char *code,
+                            const ClassSummary *summary) {
+    const GradeHistogram *histogram = &summary->histogram;
+    int graded = summary->graded;
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 70);
+    fprintf(out, "                    CLASS STATISTICS\n");
+    write_separator(out, '=', 70);
+    fprintf(out, "Course: %s (%s)\n", name, code);
+    fprintf(out, "Course ID: %d\n", course_id);
+    fprintf(out, "Total Enrollment: %d\n", summary->current_enrollment);
+    fprintf(out, "Students Graded: %d\n", graded);
+    
+    if (graded > 0) {
+        float average_grade = (float)summary->grade_sum / graded;
+        fprintf(out, "Average Grade: %.2f\n", average_grade);
+        fprintf(out, "Highest Grade: %.2f\n", summary->grade_max);
+        fprintf(out, "Lowest Grade: %.2f\n", summary->grade_min);
+        fprintf(out, "Grade Range: %.2f\n", summary->grade_max - summary->grade_min);
+        fprintf(out, "Median Grade: %d\n", histogram_percentile(histogram, graded, 50));
+        fprintf(out, "Percentiles: P10 %d  P25 %d  P75 %d  P90 %d\n",
+                histogram_percentile(histogram, graded, 10),
+                histogram_percentile(histogram, graded, 25),
+                histogram_percentile(histogram, graded, 75),
+                histogram_percentile(histogram, graded, 90));
+        fprintf(out, "Letter Grades: A %d  B %d  C %d  D %d  F %d\n",
+                histogram_count(histogram, GRADE_A_MIN, MAX_GRADE),
+                histogram_count(histogram, GRADE_B_MIN, GRADE_A_MIN - 1),
+                histogram_count(histogram, GRADE_C_MIN, GRADE_B_MIN - 1),
+                histogram_count(histogram, GRADE_D_MIN, GRADE_C_MIN - 1),
+                histogram_count(histogram, GRADE_F_MIN, GRADE_D_MIN - 1));
+    } else {
+        fprintf(out, "No grades recorded for this course.\n");
+    }
+    
+    write_separator(out, '=', 70);
+    fprintf(out, "\n");
+}
+
+/**
+ * Copy a course's grade aggregates. Returns its table position, or -1 if
+ * the course does not exist.
+ */
+int read_class_summary(int course_id, ClassSummary *summary) {
+    int course_index = lookup_course(course_id);
+    if (course_index == -1) return -1;
+    
+    /* Exclusive: refreshing stale bounds writes the course */
+    Course *course = course_at(course_index);
+    lock_write(course_lock(course_id), CONTENTION_COURSE_LOCK);
+    refresh_course_grade_bounds(course);
+    summary->current_enrollment = course->current_enrollment;
+    summary->graded = course->graded_count;
+    summary->grade_sum = course->grade_sum;
+    summary->grade_min = course->grade_min;
+    summary->grade_max = course->grade_max;
+    summary->histogram = *course_histogram(course);
+    pthread_rwlock_unlock(course_lock(course_id));
+    return course_index;
+}
+
+/**
+ * Print a course's grade statistics from its running aggregates
+ */
+void print_class_statistics(int course_id) {
+    FILE *out = session_output();
+    uint64_t started = monotonic_ns();
+    
+    ClassSummary summary;
+    int course_index = read_class_summary(course_id, &summary);
+    if (course_index == -1) {
+        fprintf(out, "Course not found.\n");
+        metric_record(METRIC_CLASS_STATS, started, 0);
+        return;
+    }
+    
+    write_class_statistics(out, course_id, course_details_at(course_index)->course_name,
+                           interned_text(course_at(course_index)->code_id), &summary);
+    metric_record(METRIC_CLASS_STATS, started, 1);
+}
+
+/**
+ * Print this instance's share of the system statistics in the form the
+ * shard coordinator merges: totals that add up across shards, then the
+ * seats taken and held of every course
+ */
+void write_partial_statistics(FILE *out) {
+    pthread_mutex_lock(&stats_lock);
+    SystemStats stats = system_stats;
+    pthread_mutex_unlock(&stats_lock);
+    
+    fprintf(out, "totals %d %d %d %.17g %llu\n", stats.total_students, stats.total_enrollments,
+            stats.completed_enrollments, stats.total_credit_points,
+            (unsigned long long)log_entries_written());
+    
+    pthread_rwlock_rdlock(&course_table_lock);
+    int count = course_count;
+    pthread_rwlock_unlock(&course_table_lock);
+    for (int i = 0; i < count; i++) {
+        const Course *course = course_at(i);
+        fprintf(out, "seats %d %d %d\n", course->course_id, (int)course->current_enrollment,
+                course->max_capacity);
+    }
+}
+
+/**
+ * Print this instance's grade aggregates for a course in the form the shard
+ * coordinator merges. Returns 0 if the course does not exist.
+ */
+int write_partial_class(FILE *out, int course_id) {
+    ClassSummary summary;
+    int course_index = read_class_summary(course_id, &summary);
+    if (course_index == -1) return 0;
+    
+    fprintf(out, "course %s|%s\n", interned_text(course_at(course_index)->code_id),
+            course_details_at(course_index)->course_name);
+    fprintf(out, "grades %d %d %.17g %.9g %.9g\n", summary.current_enrollment, summary.graded,
+            summary.grade_sum, summary.grade_min, summary.grade_max);
+    fprintf(out, "histogram");
+    for (int b = 0; b < GRADE_HISTOGRAM_BUCKETS; b++) fprintf(out, " %d", summary.histogram.buckets[b]);
+    fprintf(out, "\n");
+    return 1;
+}
+
+/**
+ * Generate class statistics
+ */
+void generate_class_statistics(void) {
+    printf("Enter course ID: ");
+    int course_id;
+    scanf("%d", &course_id);
+    clear_input_buffer();
+    print_class_statistics(course_id);
+}
+
+
+int compare_honor_roll(const void *a, const void *b) {
+    const HonorRollEntry *left = a, *right = b;
+    if (left->gpa != right->gpa) return left->gpa > right->gpa ? -1 : 1;
+    return left->student_index - right->student_index;
+}
+
+/**
+ * Print the dean's list: students with at least min_credits completed and a
+ * credit-weighted GPA of min_gpa or more, best first. Reads only each
+ * student's cached totals, so the cost is O(1) per student.
+ */
+void print_deans_list(float min_gpa, int min_credits) {
+    FILE *out = session_output();
+    uint64_t started = monotonic_ns();
+    
+    lock_all_records_shared();
+    int count = student_count;
+    HonorRollEntry *entries = malloc((size_t)(count > 0 ? count : 1) * sizeof(HonorRollEntry));
+    int listed = 0;
+    for (int i = 0; entries && i < count; i++) {
+        const Student *student = student_at(i);
+        if (!student->is_active || student->credits_completed < min_credits ||
+            student->credits_completed <= 0) continue;
+        float gpa = (float)(student->weighted_points_total / student->credits_completed);
+        if (gpa >= min_gpa) entries[listed++] = (HonorRollEntry){ i, student->credits_completed, gpa };
+    }
+    unlock_all_records();
+    
+    if (!entries) {
+        fprintf(out, "Error: Out of memory!\n");
+        metric_record(METRIC_DEANS_LIST, started, 0);
+        return;
+    }
+    qsort(entries, listed, sizeof(HonorRollEntry), compare_honor_roll);
+    
+    fprintf(out, "\n");
+    print_separator('=', 70);
+    fprintf(out, "          DEAN'S LIST (GPA >= %.2f, %d+ credits)\n", min_gpa, min_credits);
+    print_separator('=', 70);
+    fprintf(out, "%-8s %-30s %-10s %-10s\n", "ID", "Name", "Credits", "GPA");
+    print_separator('-', 70);
+    for (int i = 0; i < listed; i++) {
+        fprintf(out, "%-8d %-30s %-10d %.2f\n", student_at(entries[i].student_index)->student_id,
+                student_profile_at(entries[i].student_index)->name, entries[i].credits, entries[i].gpa);
+    }
+    print_separator('=', 70);
+    fprintf(out, "Students Listed: %d\n\n", listed);
+    free(entries);
+    metric_record(METRIC_DEANS_LIST, started, 1);
+}
+
+int compare_major_totals(const void *a, const void *b) {
+    const MajorTotals *left = a, *right = b;
+    return strcmp(interned_text(left->major_id), interned_text(right->major_id));
+}
+
+/**
+ * Print student counts and credit-weighted GPA per major. Students are
+ * grouped by their interned major ID, so the scan never compares strings.
+ */
+void print_major_report(void) {
+    FILE *out = session_output();
+    
+    lock_all_records_shared();
+    pthread_rwlock_rdlock(&interned.lock);
+    int major_count = interned.count;
+    pthread_rwlock_unlock(&interned.lock);
+    
+    MajorTotals *totals = calloc((size_t)(major_count > 0 ? major_count : 1), sizeof(MajorTotals));
+    for (int i = 0; totals && i < student_count; i++) {
+        const Student *student = student_at(i);
+        if (!student->is_active || student->major_id < 0 || student->major_id >= major_count) continue;
+        MajorTotals *major = &totals[student->major_id];
+        major->students++;
+        major->credits += student->credits_completed;
+        major->weighted_points += student->weighted_points_total;
+    }
+    unlock_all_records();
+    
+    if (!totals) {
+        fprintf(out, "Error: Out of memory!\n");
+        return;
+    }
+    
+    /* Course codes and assessment types share the pool; keep only IDs used as majors */
+    int listed = 0;
+    for (int id = 0; id < major_count; id++) {
+        if (totals[id].students == 0) continue;
+        totals[listed] = totals[id];
+        totals[listed++].major_id = id;
+    }
+    qsort(totals, listed, sizeof(MajorTotals), compare_major_totals);
+    
+    fprintf(out, "\n");
+    print_separator('=', 70);
+    fprintf(out, "                    MAJOR REPORT\n");
+    print_separator('=', 70);
+    fprintf(out, "%-30s %-10s %-10s %-10s\n", "Major", "Students", "Credits", "GPA");
+    print_separator('-', 70);
+    for (int i = 0; i < listed; i++) {
+        fprintf(out, "%-30s %-10d %-10d ", interned_text(totals[i].major_id),
+                totals[i].students, totals[i].credits);
+        if (totals[i].credits > 0) {
+            fprintf(out, "%.2f\n", totals[i].weighted_points / totals[i].credits);
+        } else {
+            fprintf(out, "N/A\n");
+        }
+    }
+    print_separator('=', 70);
+    fprintf(out, "Majors Listed: %d\n\n", listed);
+    free(totals);
+}
+
+/* ============================================================================
+   RANKED VIEWS
+   ============================================================================ */
+
+int rank_by_score(const RankedEntry *a, const RankedEntry *b) {
+    if (a->score != b->score) return a->score > b->score ? 1 : -1;
+    return a->index < b->index ? 1 : -1;
+}
+
+int rank_by_name(const RankedEntry *a, const RankedEntry *b) {
+    int order = strcasecmp(student_profile_at(b->index)->name, student_profile_at(a->index)->name);
+    if (order != 0) return order;
+    return a->index < b->index ? 1 : -1;
+}
+
+/**
+ * Prepare a selection of the best limit entries. Returns 0 when out of memory.
+ */
+int topk_init(TopK *top, int limit, RankCompare compare) {
+    top->heap = malloc((size_t)(limit > 0 ? limit : 1) * sizeof(RankedEntry));
+    top->count = 0;
+    top->limit = limit;
+    top->compare = compare;
+    return top->heap != NULL;
+}
+
+void topk_sift_down(TopK *top, int position) {
+    RankedEntry *heap = top->heap;
+    for (;;) {
+        int weakest = position, left = 2 * position + 1, right = left + 1;
+        if (left < top->count && top->compare(&heap[weakest], &heap[left]) > 0) weakest = left;
+        if (right < top->count && top->compare(&heap[weakest], &heap[right]) > 0) weakest = right;
+        if (weakest == position) return;
+        
+        RankedEntry entry = heap[position];
+        heap[position] = heap[weakest];
+        heap[weakest] = entry;
+        position = weakest;
+    }
+}
+
+/**
+ * Offer a candidate; it is kept while it ranks among the best limit seen
+ */
+void topk_offer(TopK *top, RankedEntry entry) {
+    if (top->count < top->limit) {
+        int position = top->count++;
+        while (position > 0) {
+            int parent = (position - 1) / 2;
+            if (top->compare(&top->heap[parent], &entry) < 0) break;
+            top->heap[position] = top->heap[parent];
+            position = parent;
+        }
+        top->heap[position] = entry;
+    } else if (top->limit > 0 && top->compare(&entry, &top->heap[0]) > 0) {
+        top->heap[0] = entry;
+        topk_sift_down(top, 0);
+    }
+}
+
+/**
+ * Sort the kept entries best first, in place
+ */
+void topk_finish(TopK *top) {
+    int kept = top->count;
+    while (top->count > 1) {
+        RankedEntry weakest = top->heap[0];
+        top->heap[0] = top->heap[--top->count];
+        topk_sift_down(top, 0);
+        top->heap[top->count] = weakest;
+    }
+    top->count = kept;
+}
+
+/**
+ * Print the k students with the highest credit-weighted GPA. One pass over
+ * the cached GPA totals feeds a k-entry heap, so the cost is O(N log k)
+ * with no sort of the whole table.
+ */
+void print_top_gpa(int k) {
+    TopK top;
+    if (!topk_init(&top, k, rank_by_score)) {
+        fprintf(session_output(), "Error: Out of memory!\n");
+        return;
+    }
+    
+    FILE *out = render_begin();
+    lock_all_records_shared();
+    for (int i = 0; i < student_count; i++) {
+        const Student *student = student_at(i);
+        if (!student->is_active || student->credits_completed <= 0) continue;
+        topk_offer(&top, (RankedEntry){ i, student->weighted_points_total / student->credits_completed });
+    }
+    topk_finish(&top);
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 80);
+    fprintf(out, "                 TOP %d STUDENTS BY CREDIT-WEIGHTED GPA\n", k);
+    write_separator(out, '=', 80);
+    fprintf(out, "%-6s %-8s %-30s %-15s %-8s %-6s\n", "Rank", "ID", "Name", "Major", "Credits", "GPA");
+    write_separator(out, '-', 80);
+    for (int rank = 0; rank < top.count; rank++) {
+        const Student *student = student_at(top.heap[rank].index);
+        fprintf(out, "%-6d %-8d %-30s %-15s %-8d %.2f\n", rank + 1, student->student_id,
+                student_profile_at(top.heap[rank].index)->name, interned_text(student->major_id),
+                student->credits_completed, top.heap[rank].score);
+    }
+    unlock_all_records();
+    write_separator(out, '=', 80);
+    fprintf(out, "Students Listed: %d\n\n", top.count);
+    render_end();
+    free(top.heap);
+}
+
+/**
+ * Print the k courses closest to capacity by fill ratio (seats taken over
+ * capacity), in O(N log k) like print_top_gpa
+ */
+void print_course_fill(int k) {
+    TopK top;
+    if (!topk_init(&top, k, rank_by_score)) {
+        fprintf(session_output(), "Error: Out of memory!\n");
+        return;
+    }
+    
+    FILE *out = render_begin();
+    lock_all_records_shared();
+    for (int i = 0; i < course_count; i++) {
+        const Course *course = course_at(i);
+        if (course->max_capacity <= 0) continue;
+        topk_offer(&top, (RankedEntry){ i, (double)course->current_enrollment / course->max_capacity });
+    }
+    topk_finish(&top);
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 100);
+    fprintf(out, "                       TOP %d COURSES CLOSEST TO CAPACITY\n", k);
+    write_separator(out, '=', 100);
+    fprintf(out, "%-6s %-6s %-10s %-30s %-10s %-10s %-8s %-8s\n",
+            "Rank", "ID", "Code", "Name", "Enrolled", "Capacity", "Fill", "Waitlist");
+    write_separator(out, '-', 100);
+    for (int rank = 0; rank < top.count; rank++) {
+        const Course *course = course_at(top.heap[rank].index);
+        fprintf(out, "%-6d %-6d %-10s %-30s %-10d %-10d %5.1f%%   %-8d\n", rank + 1, course->course_id,
+                interned_text(course->code_id), course_details_at(top.heap[rank].index)->course_name,
+                (int)course->current_enrollment, course->max_capacity, top.heap[rank].score * 100.0,
+                (int)course->waitlist_count);
+    }
+    unlock_all_records();
+    write_separator(out, '=', 100);
+    fprintf(out, "Courses Listed: %d\n\n", top.count);
+    render_end();
+    free(top.heap);
+}
+
+/**
+ * Print active students in name order. A page only needs the first
+ * page * limit names, so those are selected with a heap in O(N log K)
+ * rather than sorting every name; an unpaged listing sorts them all.
+ */
+void print_students_by_name(ListPage page) {
+    lock_all_records_shared();
+    long long first = page_first_row(&page);
+    long long wanted = page.limit > 0 ? first + page.limit : student_count;
+    int k = wanted < student_count ? (int)wanted : student_count;
+    
+    TopK top;
+    if (!topk_init(&top, k, rank_by_name)) {
+        unlock_all_records();
+        fprintf(session_output(), "Error: Out of memory!\n");
+        return;
+    }
+    int active = 0;
+    for (int i = 0; i < student_count; i++) {
+        if (!student_at(i)->is_active) continue;
+        topk_offer(&top, (RankedEntry){ i, 0.0 });
+        active++;
+    }
+    unlock_all_records();
+    topk_finish(&top);
+    
+    /* Names and IDs never change once committed, so rows print unlocked */
+    FILE *out = render_begin();
+    fprintf(out, "\n");
+    write_separator(out, '=', 100);
+    fprintf(out, "%-6s %-25s %-30s %-15s %-10s\n", "ID", "Name", "Email", "Phone", "Major");
+    write_separator(out, '=', 100);
+    for (long long row = first; row < top.count; row++) {
+        int index = top.heap[row].index;
+        const StudentProfile *profile = student_profile_at(index);
+        fprintf(out, "%-6d %-25s %-30s %-15s %-10s\n", student_at(index)->student_id, profile->name,
+                profile->email, profile->phone, interned_text(student_at(index)->major_id));
+    }
+    write_separator(out, '=', 100);
+    fprintf(out, "Total Active Students: %d\n", active);
+    write_page_footer(out, &page, active);
+    fprintf(out, "\n");
+    render_end();
+    free(top.heap);
+}
+
+/**
+ * Ask how many rows a ranked view should list, defaulting to TOP_K_DEFAULT
+ */
+int read_rank_count(void) {
+    printf("How many to list (default %d): ", TOP_K_DEFAULT);
+    char line[32];
+    if (!fgets(line, sizeof(line), stdin)) return TOP_K_DEFAULT;
+    int k = atoi(line);
+    return k > 0 ? k : TOP_K_DEFAULT;
+}
+
+void display_top_gpa(void) {
+    print_top_gpa(read_rank_count());
+}
+
+void display_course_fill(void) {
+    print_course_fill(read_rank_count());
+}
+
+void display_students_by_name(void) {
+    print_students_by_name(LIST_ALL_ROWS);
+}
+
+/* ============================================================================
+   TERM REPORT ENGINE
+   ============================================================================ */
+
+/**
+ * Fold one completed enrollment into a partition's private totals
+ */
+void report_add_completed(ReportPartition *partition, int student_id, int course_id, int credits,
+                          float grade, float credit_points) {
+    const TermReport *report = partition->report;
+    unsigned int student = (unsigned int)(student_id - student_id_base);
+    unsigned int course = (unsigned int)(course_id - FIRST_COURSE_ID);
+    if (student >= (unsigned int)report->student_count ||
+        course >= (unsigned int)report->course_count) return;
+    
+    StudentTotals *student_totals = &partition->students[student];
+    student_totals->credit_points += credit_points;
+    student_totals->completed++;
+    student_totals->credits += credits;
+    student_totals->weighted_points += (double)credit_points * credits;
+    
+    CourseTotals *totals = &partition->courses[course];
+    if (totals->graded == 0 || grade < totals->grade_min) totals->grade_min = grade;
+    if (totals->graded == 0 || grade > totals->grade_max) totals->grade_max = grade;
+    totals->grade_sum += grade;
+    totals->graded++;
+}
+
+/**
+ * Report thread, scan phase: fold completed enrollment rows of the
+ * partition, and every threads-th archive segment, into its private
+ * per-student and per-course totals
+ */
+void *report_scan_partition(void *arg) {
+    ReportPartition *partition = arg;
+    const TermReport *report = partition->report;
+    
+    for (int start = partition->first_row; start < partition->end_row; start += TABLE_CHUNK_SIZE) {
+        const EnrollmentColumns *columns = enrollment_columns_at(start);
+        int n = partition->end_row - start < TABLE_CHUNK_SIZE ? partition->end_row - start : TABLE_CHUNK_SIZE;
+        
+        for (int slot = 0; slot < n; slot++) {
+            if (columns->status[slot] != 2) continue;
+            report_add_completed(partition, columns->student_id[slot], columns->course_id[slot],
+                                 columns->credits[slot], columns->grade[slot], columns->credit_points[slot]);
+        }
+    }
+    
+    for (int s = (int)(partition - report->partitions); s < archive_segment_count; s += report->threads) {
+        ArchiveCursor cursor;
+        ArchivedEnrollment row;
+        archive_cursor_init(&cursor, archive_segments[s], 0);
+        while (archive_cursor_next(&cursor, &row)) {
+            if (row.status != 2) continue;
+            report_add_completed(partition, row.student_id, row.course_id, row.credits, row.grade,
+                                 get_gpa_from_grade(get_letter_grade(row.grade)));
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Report thread, merge phase: fold every partition's totals for this
+ * thread's slice of students and courses into partition 0
+ */
+void *report_merge_partition(void *arg) {
+    ReportPartition *partition = arg;
+    TermReport *report = partition->report;
+    
+    for (int t = 1; t < report->threads; t++) {
+        const ReportPartition *other = &report->partitions[t];
+        for (int i = partition->merge_first_student; i < partition->merge_end_student; i++) {
+            report->students[i].credit_points += other->students[i].credit_points;
+            report->students[i].completed += other->students[i].completed;
+            report->students[i].credits += other->students[i].credits;
+            report->students[i].weighted_points += other->students[i].weighted_points;
+        }
+        for (int i = partition->merge_first_course; i < partition->merge_end_course; i++) {
+            const CourseTotals *from = &other->courses[i];
+            CourseTotals *into = &report->courses[i];
+            if (from->graded == 0) continue;
+            if (into->graded == 0 || from->grade_min < into->grade_min) into->grade_min = from->grade_min;
+            if (into->graded == 0 || from->grade_max > into->grade_max) into->grade_max = from->grade_max;
+            into->grade_sum += from->grade_sum;
+            into->graded += from->graded;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Run one report phase on every partition, the first on the calling thread
+ */
+void report_run_phase(TermReport *report, void *(*phase)(void *)) {
+    int started[REPORT_MAX_THREADS] = { 0 };
+    for (int t = 1; t < report->threads; t++) {
+        started[t] = pthread_create(&report->partitions[t].thread, NULL, phase,
+                                    &report->partitions[t]) == 0;
+    }
+    phase(&report->partitions[0]);
+    for (int t = 1; t < report->threads; t++) {
+        if (started[t]) pthread_join(report->partitions[t].thread, NULL);
+        else phase(&report->partitions[t]);
+    }
+}
+
+/**
+ * Split [0, total) into parts, returning the start of part index
+ */
+int report_split(int total, int parts, int index, int align) {
+    long long start = (long long)total * index / parts;
+    start -= start % align;
+    return index == parts ? total : (int)start;
+}
+
+/**
+ * Build the GPA of every student and the grade statistics of every course
+ * from the enrollment rows and archive segments, in parallel. Rows are partitioned across
+ * threads on chunk boundaries, each thread accumulates into private
+ * arrays, and the arrays are then merged by slices, again in parallel.
+ * Writers are held off for the run. Returns 0 when out of memory.
+ */
+int build_term_report(TermReport *report) {
+    memset(report, 0, sizeof(*report));
+    double started = monotonic_seconds();
+    
+    lock_all_records_shared();
+    report->student_count = student_count;
+    report->course_count = course_count;
+    report->enrollment_count = enrollment_count;
+    report->archived_count = archived_enrollment_count;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int chunks = (report->enrollment_count + TABLE_CHUNK_SIZE - 1) / TABLE_CHUNK_SIZE;
+    if (chunks < archive_segment_count) chunks = archive_segment_count;
+    report->threads = cpus < 1 ? 1 : cpus > REPORT_MAX_THREADS ? REPORT_MAX_THREADS : (int)cpus;
+    if (report->threads > chunks) report->threads = chunks > 0 ? chunks : 1;
+    
+    int ok = 1;
+    for (int t = 0; t < report->threads; t++) {
+        ReportPartition *partition = &report->partitions[t];
+        partition->report = report;
+        partition->first_row = report_split(report->enrollment_count, report->threads, t, TABLE_CHUNK_SIZE);
+        partition->end_row = report_split(report->enrollment_count, report->threads, t + 1, TABLE_CHUNK_SIZE);
+        partition->merge_first_student = report_split(report->student_count, report->threads, t, 1);
+        partition->merge_end_student = report_split(report->student_count, report->threads, t + 1, 1);
+        partition->merge_first_course = report_split(report->course_count, report->threads, t, 1);
+        partition->merge_end_course = report_split(report->course_count, report->threads, t + 1, 1);
+        partition->students = calloc(report->student_count + 1, sizeof(StudentTotals));
+        partition->courses = calloc(report->course_count + 1, sizeof(CourseTotals));
+        if (!partition->students || !partition->courses) ok = 0;
+    }
+    
+    if (ok) {
+        report->students = report->partitions[0].students;
+        report->courses = report->partitions[0].courses;
+        report_run_phase(report, report_scan_partition);
+        if (report->threads > 1) report_run_phase(report, report_merge_partition);
+    }
+    unlock_all_records();
+    
+    /* Only the merged totals in partition 0 are kept */
+    for (int t = ok ? 1 : 0; t < report->threads; t++) {
+        free(report->partitions[t].students);
+        free(report->partitions[t].courses);
+        report->partitions[t].students = NULL;
+        report->partitions[t].courses = NULL;
+    }
+    if (!ok) {
+        log_operation(LOG_ERROR, LOG_OP_REPORT, "Term report allocation failed");
+        return 0;
+    }
+    
+    report->seconds = monotonic_seconds() - started;
+    log_operationf(LOG_SUCCESS, LOG_OP_REPORT, "Term report over %d enrollments in %.1f ms, %d thread%s",
+                   report->enrollment_count + report->archived_count, report->seconds * 1000,
+                   report->threads, report->threads == 1 ? "" : "s");
+    return 1;
+}
+
+void free_term_report(TermReport *report) {
+    free(report->students);
+    free(report->courses);
+    report->students = NULL;
+    report->courses = NULL;
+}
+
+/**
+ * Write the selected report tables. Names and codes are written once
+ * records stopped moving, so no lock is needed to read them.
+ */
+void write_term_report(const TermReport *report, int tables, FILE *out) {
+    if (tables & REPORT_STUDENTS) {
+        fprintf(out, "\n");
+        write_separator(out, '=', 80);
+        fprintf(out, "                    TERM REPORT: STUDENT GPA\n");
+        write_separator(out, '=', 80);
+        fprintf(out, "%-8s %-30s %-10s %-8s %-6s %-8s\n", "ID", "Name", "Completed", "Credits", "GPA",
+                "Weighted");
+        write_separator(out, '-', 80);
+        for (int i = 0; i < report->student_count; i++) {
+            const StudentTotals *totals = &report->students[i];
+            fprintf(out, "%-8d %-30s %-10d %-8d ", student_at(i)->student_id,
+                    student_profile_at(i)->name, totals->completed, totals->credits);
+            if (totals->completed > 0) fprintf(out, "%-6.2f ", totals->credit_points / totals->completed);
+            else fprintf(out, "%-6s ", "N/A");
+            if (totals->credits > 0) fprintf(out, "%.2f\n", totals->weighted_points / totals->credits);
+            else fprintf(out, "N/A\n");
+        }
+        write_separator(out, '=', 80);
+    }
+    
+    if (tables & REPORT_COURSES) {
+        fprintf(out, "\n");
+        write_separator(out, '=', 90);
+        fprintf(out, "                    TERM REPORT: CLASS STATISTICS\n");
+        write_separator(out, '=', 90);
+        fprintf(out, "%-8s %-12s %-10s %-8s %-10s %-10s %-10s %-10s\n", "ID", "Code", "Enrolled", "Graded",
+                "Average", "Highest", "Lowest", "Range");
+        write_separator(out, '-', 90);
+        for (int i = 0; i < report->course_count; i++) {
+            const CourseTotals *totals = &report->courses[i];
+            const Course *course = course_at(i);
+            fprintf(out, "%-8d %-12s %-10d %-8d ", course->course_id, interned_text(course->code_id),
+                    course->current_enrollment, totals->graded);
+            if (totals->graded > 0) {
+                fprintf(out, "%-10.2f %-10.2f %-10.2f %-10.2f\n", totals->grade_sum / totals->graded,
+                        totals->grade_max, totals->grade_min, totals->grade_max - totals->grade_min);
+            } else {
+                fprintf(out, "%-10s %-10s %-10s %-10s\n", "N/A", "-", "-", "-");
+            }
+        }
+        write_separator(out, '=', 90);
+    }
+    
+    fprintf(out, "Computed from %d enrollments in %.1f ms using %d thread%s\n\n",
+            report->enrollment_count + report->archived_count, report->seconds * 1000, report->threads,
+            report->threads == 1 ? "" : "s");
+}
+
+/**
+ * Build a term report and write it to path, or to the session output when
+ * path is "-". Returns 0 on failure.
+ */
+int run_term_report(int tables, const char *path) {
+    uint64_t started = monotonic_ns();
+    TermReport report;
+    if (!build_term_report(&report)) {
+        metric_record(METRIC_TERM_REPORT, started, 0);
+        return 0;
+    }
+    
+    int to_output = strcmp(path, "-") == 0;
+    FILE *out = to_output ? render_begin() : fopen(path, "w");
+    if (!out) {
+        free_term_report(&report);
+        log_operation(LOG_ERROR, LOG_OP_REPORT, "Failed to open report file");
+        metric_record(METRIC_TERM_REPORT, started, 0);
+        return 0;
+    }
+    if (!to_output) setvbuf(out, NULL, _IOFBF, 1 << 20);
+    
+    write_term_report(&report, tables, out);
+    free_term_report(&report);
+    int ok = to_output ? fflush(out) == 0 : fclose(out) == 0;
+    if (to_output) render_end();
+    if (!ok) log_operation(LOG_ERROR, LOG_OP_REPORT, "Failed to write report file");
+    metric_record(METRIC_TERM_REPORT, started, ok);
+    return ok;
+}
+
+int parse_report_tables(const char *name) {
+    if (strcmp(name, "students") == 0) return REPORT_STUDENTS;
+    if (strcmp(name, "courses") == 0) return REPORT_COURSES;
+    if (strcmp(name, "all") == 0) return REPORT_ALL;
+    return 0;
+}
+
+/**
+ * Prompt for the report tables and destination and run it
+ */
+void term_report_interactive(void) {
+    char table_name[16], path[FILE_BUFFER_SIZE];
+    
+    printf("Report on (students/courses/all): ");
+    if (scanf("%15s", table_name) != 1) table_name[0] = '\0';
+    clear_input_buffer();
+    int tables = parse_report_tables(table_name);
+    if (!tables) {
+        printf("Error: Unknown report '%s'!\n", table_name);
+        return;
+    }
+    
+    printf("Output file (- for screen): ");
+    if (scanf("%4095s", path) != 1) strcpy(path, "-");
+    clear_input_buffer();
+    
+    if (!run_term_report(tables, path)) {
+        printf("Error: Could not write report to '%s'!\n", path);
+    } else if (strcmp(path, "-") != 0) {
+        printf("\n✓ Term report written to %s\n", path);
+    }
+}
+
+/* ============================================================================
+   LOG AND REPORTING FUNCTIONS
+   ============================================================================ */
+
+/**
+ * Print the heading of the log table
+ */
+void print_log_header(void) {
+    FILE *out = session_output();
+    fprintf(out, "\n");
+    print_separator('=', 120);
+    fprintf(out, "%-6s %-12s %-20s %-20s %-50s\n", 
+                 "ID", "Level", "Timestamp", "Operation", "Details");
+    print_separator('=', 120);
+}
+
+/**
+ * Print one log row. The formatted timestamp is kept by the caller and only
+ * rebuilt when the second changes.
+ */
+void print_log_entry(uint64_t sequence, char *timestamp, time_t *timestamp_second) {
+    FILE *out = session_output();
+    LogEntry entry;
+    if (!log_read(sequence, &entry)) return;
+    
+    time_t wall_time = log_wall_time(entry.timestamp_ns);
+    if (wall_time != *timestamp_second) {
+        struct tm tm_info;
+        localtime_r(&wall_time, &tm_info);
+        strftime(timestamp, 32, "%Y-%m-%d %H:%M:%S", &tm_info);
+        *timestamp_second = wall_time;
+    }
+    
+    fprintf(out, "%-6llu %-12s %-20s %-20s %-50s\n",
+                 (unsigned long long)sequence,
+                 log_level_name(entry.log_level),
+                 timestamp,
+                 log_operation_names[entry.operation],
+                 entry.details);
+}
+
+/**
+ * Display system log
+ */
+void display_system_log(void) {
+    uint64_t head = log_entries_written();
+    if (head < log_oldest_sequence()) {
+        printf("No log entries.\n");
+        return;
+    }
+    
+    FILE *out = render_begin();
+    print_log_header();
+    char timestamp[32];
+    time_t timestamp_second = -1;
+    for (uint64_t sequence = log_oldest_sequence(); sequence <= head; sequence++) {
+        print_log_entry(sequence, timestamp, &timestamp_second);
+    }
+    
+    write_separator(out, '=', 120);
+    fprintf(out, "Total Log Entries: %llu\n", (unsigned long long)head);
+    if (log_oldest_sequence() > 1) {
+        fprintf(out, "(showing entries from ID %llu; older entries are in '%s')\n",
+                (unsigned long long)log_oldest_sequence(), log_flusher.path);
+    }
+    fprintf(out, "\n");
+    render_end();
+}
+
+/**
+ * Log ID at a position of the chosen query source: the whole ring when
+ * level is 0, otherwise that level's index. A claimed index slot may not be
+ * written yet and still hold 0 or an ID from the previous lap, which
+ * log_read rejects.
+ */
+uint64_t log_source_sequence(int level, uint64_t position) {
+    if (level == 0) return position;
+    return atomic_load_explicit(&log_level_index[level][position & (LOG_RING_SIZE - 1)],
+                                memory_order_acquire);
+}
+
+/**
+ * Timestamp at a source position; entries overwritten mid-search sort first
+ */
+uint64_t log_source_timestamp(int level, uint64_t position) {
+    LogEntry entry;
+    if (!log_read(log_source_sequence(level, position), &entry)) return 0;
+    return entry.timestamp_ns;
+}
+
+/**
+ * Position in [low, high) near the first entry whose timestamp is at least
+ * timestamp_ns. The source is only nearly sorted by time, so callers widen
+ * the result and check each entry.
+ */
+uint64_t log_search_time(int level, uint64_t low, uint64_t high, uint64_t timestamp_ns) {
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (log_source_timestamp(level, middle) < timestamp_ns) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * Convert a wall-clock time to the log's monotonic clock
+ */
+uint64_t log_monotonic_time(time_t wall_time) {
+    int64_t offset = (int64_t)(wall_time - log_wall_base) * 1000000000;
+    return offset < -(int64_t)log_monotonic_base ? 0 : log_monotonic_base + offset;
+}
+
+/**
+ * Collect the log IDs matching a query, oldest first, into results.
+ * Level filters walk that level's index and time bounds are found by binary
+ * search, so only entries near the window are visited.
+ * The timestamp is taken after the ID is claimed, and index positions are
+ * claimed after publishing, so concurrent writers leave entries a few
+ * positions out of time order. A writer descheduled in between can land
+ * further out than LOG_QUERY_SLACK and be missed by a time-bounded query;
+ * level and operation filters alone never miss.
+ * Returns the number of matches stored.
+ */
+int log_query(const LogQuery *query, uint64_t *results, int max_results) {
+    int level = query->level;
+    uint64_t oldest = log_oldest_sequence();
+    uint64_t low, high;
+    
+    if (level == 0) {
+        low = oldest;
+        high = log_entries_written() + 1;
+    } else {
+        high = atomic_load_explicit(&log_level_head[level], memory_order_acquire);
+        low = high > LOG_RING_SIZE ? high - LOG_RING_SIZE : 0;
+        /* Skip index slots whose entries have left the main ring */
+        uint64_t search_high = high;
+        while (low < search_high) {
+            uint64_t middle = low + (search_high - low) / 2;
+            if (log_source_sequence(level, middle) < oldest) {
+                low = middle + 1;
+            } else {
+                search_high = middle;
+            }
+        }
+    }
+    
+    uint64_t first = low, last = high;
+    uint64_t since_ns = query->since ? log_monotonic_time(query->since) : 0;
+    uint64_t until_ns = query->until ? log_monotonic_time(query->until + 1) : UINT64_MAX;
+    if (query->since) {
+        low = log_search_time(level, low, high, since_ns);
+        low = low - first > LOG_QUERY_SLACK ? low - LOG_QUERY_SLACK : first;
+    }
+    if (query->until) {
+        high = log_search_time(level, low, high, until_ns);
+        high = last - high > LOG_QUERY_SLACK ? high + LOG_QUERY_SLACK : last;
+    }
+    
+    /* Walk back from the newest so a limit stops the scan early */
+    int limit = query->limit > 0 && query->limit < max_results ? query->limit : max_results;
+    int found = 0;
+    LogEntry entry;
+    for (uint64_t position = high; position > low && found < limit; position--) {
+        uint64_t sequence = log_source_sequence(level, position - 1);
+        if (!log_read(sequence, &entry)) continue;
+        if (level != 0 && entry.log_level != level) continue;
+        if (entry.timestamp_ns < since_ns || entry.timestamp_ns >= until_ns) continue;
+        if (query->operation >= 0 && entry.operation != query->operation) continue;
+        results[found++] = sequence;
+    }
+    
+    for (int i = 0; i < found / 2; i++) {
+        uint64_t swap = results[i];
+        results[i] = results[found - 1 - i];
+        results[found - 1 - i] = swap;
+    }
+    return found;
+}
+
+/**
+ * Run a query and print the matching entries
+ */
+void print_log_query(const LogQuery *query, ListPage page) {
+    uint64_t *results = malloc(LOG_RING_SIZE * sizeof(uint64_t));
+    if (!results) return;
+    int found = log_query(query, results, LOG_RING_SIZE);
+    FILE *out = render_begin();
     if (found == 0) {
-        printf("No students found matching '%s'\n", search_name);
+        fprintf(out, "No matching log entries.\n");
+        render_end();
+        free(results);
+        return;
+    }
+    
+    print_log_header();
+    char timestamp[32];
+    time_t timestamp_second = -1;
+    for (long long i = page_first_row(&page); i < found && !page_done(&page, i); i++) {
+        print_log_entry(results[i], timestamp, &timestamp_second);
+    }
+    write_separator(out, '=', 120);
+    fprintf(out, "Matching Entries Shown: %d\n", found);
+    write_page_footer(out, &page, found);
+    fprintf(out, "\n");
+    render_end();
+    free(results);
+}
+
+/**
+ * Look up a log level by name, case-insensitively
+ * Returns the level, 0 for "all", or -1 if unknown
+ */
+int parse_log_level(const char *name) {
+    if (strcasecmp(name, "all") == 0) return 0;
+    for (int level = 1; level < LOG_LEVEL_COUNT; level++) {
+        if (strcasecmp(name, log_level_name(level)) == 0) return level;
+    }
+    return -1;
+}
+
+/**
+ * Look up a log operation by name, case-insensitively, ignoring spaces,
+ * dashes and underscores so "record-grade" matches "Record Grade"
+ * Returns the LOG_OP_* value, or -1 if unknown
+ */
+int parse_log_operation(const char *name) {
+    for (int operation = 0; operation < LOG_OP_COUNT; operation++) {
+        const char *a = name, *b = log_operation_names[operation];
+        while (*a || *b) {
+            while (*a == ' ' || *a == '-' || *a == '_') a++;
+            while (*b == ' ') b++;
+            if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) break;
+            if (*a) a++;
+            if (*b) b++;
+        }
+        if (!*a && !*b) return operation;
+    }
+    return -1;
+}
+
+/**
+ * Prompt for log filters and show the matching entries
+ */
+void query_system_log(void) {
+    LogQuery query = { 0, -1, 0, 0, LOG_QUERY_DEFAULT_LIMIT };
+    char input[MAX_NAME_LENGTH];
+    int minutes;
+    
+    printf("Filter by level (all/info/warning/error/success): ");
+    if (!fgets(input, sizeof(input), stdin)) return;
+    input[strcspn(input, "\r\n")] = 0;
+    if (input[0] && (query.level = parse_log_level(input)) == -1) {
+        printf("Error: Unknown log level!\n");
+        return;
+    }
+    
+    printf("Filter by operation (blank for all): ");
+    if (!fgets(input, sizeof(input), stdin)) return;
+    input[strcspn(input, "\r\n")] = 0;
+    if (input[0] && (query.operation = parse_log_operation(input)) == -1) {
+        printf("Error: Unknown operation!\n");
+        return;
+    }
+    
+    printf("Entries from the last N minutes (0 for all): ");
+    if (scanf("%d", &minutes) == 1 && minutes > 0) {
+        query.since = time(NULL) - (time_t)minutes * 60;
+    }
+    clear_input_buffer();
+    
+    printf("Show at most (0 for %d): ", LOG_QUERY_DEFAULT_LIMIT);
+    if (scanf("%d", &query.limit) != 1 || query.limit <= 0) {
+        query.limit = LOG_QUERY_DEFAULT_LIMIT;
+    }
+    clear_input_buffer();
+    
+    print_log_query(&query, LIST_ALL_ROWS);
+}
+
+/**
+ * Write the human-readable export of every table to path, headed by
+ * export_date. The date is formatted by the caller, because a forked child
+ * must not take the time zone lock another thread may have held.
+ * Returns 0 if the file could not be created.
+ */
+int write_data_export(const char *path, const char *export_date) {
+    uint64_t started = monotonic_ns();
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        log_operation(LOG_ERROR, LOG_OP_EXPORT_DATA, "Failed to create file");
+        metric_record(METRIC_EXPORT, started, 0);
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    
+    fprintf(file, "================== SYSTEM DATA EXPORT ==================\n");
+    fprintf(file, "Export Date: %s\n\n", export_date);
+    
+    /* Export students */
+    fprintf(file, "\n============ STUDENTS ============\n");
+    fprintf(file, "Total Students: %d\n\n", student_count);
+    for (int i = 0; i < student_count; i++) {
+        StudentProfile *profile = student_profile_at(i);
+        fprintf(file, "ID: %d | Name: %s | Email: %s | Phone: %s | Major: %s\n",
+                student_at(i)->student_id,
+                profile->name,
+                profile->email,
+                profile->phone,
+                interned_text(student_at(i)->major_id));
+    }
+    
+    job_progress((uint64_t)ftell(file), 0);
+    
+    /* Export courses */
+    fprintf(file, "\n============ COURSES ============\n");
+    fprintf(file, "Total Courses: %d\n\n", course_count);
+    for (int i = 0; i < course_count; i++) {
+        Course *course = course_at(i);
+        fprintf(file, "ID: %d | Code: %s | Name: %s | Credits: %d | Enrolled: %d/%d\n",
+                course->course_id,
+                interned_text(course->code_id),
+                course_details_at(i)->course_name,
+                course->credits,
+                course->current_enrollment,
+                course->max_capacity);
+    }
+    
+    job_progress((uint64_t)ftell(file), 0);
+    
+    /* Export enrollments */
+    fprintf(file, "\n============ ENROLLMENTS ============\n");
+    fprintf(file, "Total Enrollments: %d\n\n", enrollment_count);
+    for (int i = 0; i < enrollment_count; i++) {
+        EnrollmentColumns *columns = enrollment_columns_at(i);
+        int slot = table_slot(i);
+        fprintf(file, "Enrollment ID: %d | Student: %d | Course: %d | Grade: %.2f | Status: %d\n",
+                enrollment_at(i)->enrollment_id,
+                columns->student_id[slot],
+                columns->course_id[slot],
+                columns->grade[slot],
+                columns->status[slot]);
+    }
+    
+    fprintf(file, "\n========== END OF EXPORT ==========\n");
+    
+    fclose(file);
+    log_operation(LOG_SUCCESS, LOG_OP_EXPORT_DATA, "Data exported to file");
+    metric_record(METRIC_EXPORT, started, 1);
+    return 1;
+}
+
+/* ============================================================================
+   LOG FILE WRITER
+   ============================================================================ */
+
+/**
+ * Shift path -> path.1 -> ... -> path.LOG_ROTATE_KEEP and start a new file
+ */
+void log_flusher_rotate(void) {
+    char older[FILE_BUFFER_SIZE], newer[FILE_BUFFER_SIZE];
+    
+    if (log_flusher.file) fclose(log_flusher.file);
+    for (int i = LOG_ROTATE_KEEP; i > 0; i--) {
+        snprintf(older, sizeof(older), "%s.%d", log_flusher.path, i);
+        if (i > 1) {
+            snprintf(newer, sizeof(newer), "%s.%d", log_flusher.path, i - 1);
+        } else {
+            snprintf(newer, sizeof(newer), "%s", log_flusher.path);
+        }
+        rename(newer, older);
+    }
+    log_flusher.file = fopen(log_flusher.path, "a");
+    log_flusher.file_bytes = 0;
+}
+
+/**
+ * Append every entry published since the last drain to the log file
+ */
+void log_flusher_drain(void) {
+    uint64_t head = log_entries_written();
+    uint64_t oldest = log_oldest_sequence();
+    LogEntry entry;
+    
+    if (!log_flusher.file) return;
+    if (log_flusher.next_sequence < oldest) {
+        log_flusher.file_bytes += fprintf(log_flusher.file, "... %llu entries overwritten before flush\n",
+                                          (unsigned long long)(oldest - log_flusher.next_sequence));
+        log_flusher.next_sequence = oldest;
+    }
+    
+    for (; log_flusher.next_sequence <= head; log_flusher.next_sequence++) {
+        const LogEntry *slot = &system_log[(log_flusher.next_sequence - 1) & (LOG_RING_SIZE - 1)];
+        uint64_t published = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (published == 0 || published < log_flusher.next_sequence) {
+            break; /* claimed but not yet published; picked up on the next pass */
+        }
+        if (!log_read(log_flusher.next_sequence, &entry)) continue; /* overwritten */
+        
+        /* Entries arrive in time order, so the formatted second is reused */
+        time_t wall_time = log_wall_time(entry.timestamp_ns);
+        if (wall_time != log_flusher.timestamp_second) {
+            struct tm tm_info;
+            localtime_r(&wall_time, &tm_info);
+            strftime(log_flusher.timestamp, sizeof(log_flusher.timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+            log_flusher.timestamp_second = wall_time;
+        }
+        
+        /* "ID timestamp LEVEL [Operation] details", assembled without printf */
+        char line[LOG_DETAILS_SIZE + 128];
+        char digits[24];
+        int n = 0;
+        for (uint64_t id = log_flusher.next_sequence; id > 0; id /= 10) digits[n++] = (char)('0' + id % 10);
+        char *out = line;
+        while (n > 0) *out++ = digits[--n];
+        *out++ = ' ';
+        out = stpcpy(out, log_flusher.timestamp);
+        *out++ = ' ';
+        out = stpcpy(out, log_level_name(entry.log_level));
+        out = stpcpy(out, " [");
+        out = stpcpy(out, log_operation_names[entry.operation]);
+        out = stpcpy(out, "] ");
+        out = stpcpy(out, entry.details);
+        *out++ = '\n';
+        fwrite(line, 1, out - line, log_flusher.file);
+        log_flusher.file_bytes += out - line;
+        if (log_flusher.file_bytes >= LOG_ROTATE_BYTES) {
+            log_flusher_rotate();
+            if (!log_flusher.file) return;
+        }
+    }
+    fflush(log_flusher.file);
+}
+
+/**
+ * Flusher thread: drain every LOG_FLUSH_INTERVAL_MS until asked to stop
+ */
+void *log_flusher_main(void *unused) {
+    (void)unused;
+    pthread_mutex_lock(&log_flusher.lock);
+    while (!log_flusher.stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_FLUSH_INTERVAL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&log_flusher.wake, &log_flusher.lock, &deadline);
+        
+        pthread_mutex_unlock(&log_flusher.lock);
+        log_flusher_drain();
+        pthread_mutex_lock(&log_flusher.lock);
+    }
+    pthread_mutex_unlock(&log_flusher.lock);
+    return NULL;
+}
+
+/**
+ * Newest log ID in a log file, 0 if it holds none. Only the tail is read;
+ * lines that do not start with an ID, such as overwrite notes, are skipped.
+ */
+uint64_t log_file_last_sequence(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    char tail[4096];
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    long start = size > (long)sizeof(tail) ? size - (long)sizeof(tail) : 0;
+    fseek(file, start, SEEK_SET);
+    size_t length = fread(tail, 1, sizeof(tail), file);
+    fclose(file);
+    
+    uint64_t last = 0;
+    const char *line = tail, *end;
+    /* The first line may be cut by the window and the last by a crash */
+    while ((end = memchr(line, '\n', tail + length - line)) != NULL) {
+        if ((line != tail || start == 0) && isdigit((unsigned char)line[0])) {
+            last = strtoull(line, NULL, 10);
+        }
+        line = end + 1;
+    }
+    return last;
+}
+
+/**
+ * Open the log file and start the background flusher. IDs continue from
+ * the newest entry in the file, or in its first rotation when the file is
+ * empty, so they never repeat across sessions.
+ */
+int log_flusher_start(void) {
+    char rotated[FILE_BUFFER_SIZE];
+    snprintf(rotated, sizeof(rotated), "%s.1", log_flusher.path);
+    uint64_t last = log_file_last_sequence(log_flusher.path);
+    log_continue_from(last ? last : log_file_last_sequence(rotated));
+    
+    log_flusher.file = fopen(log_flusher.path, "a");
+    if (!log_flusher.file) {
+        log_operation(LOG_ERROR, LOG_OP_SYSTEM_INIT, "Failed to open log file");
+        return 0;
+    }
+    setvbuf(log_flusher.file, NULL, _IOFBF, 1 << 16);
+    fseek(log_flusher.file, 0, SEEK_END);
+    log_flusher.file_bytes = ftell(log_flusher.file);
+    
+    if (pthread_create(&log_flusher.thread, NULL, log_flusher_main, NULL) != 0) {
+        fclose(log_flusher.file);
+        log_flusher.file = NULL;
+        log_operation(LOG_ERROR, LOG_OP_SYSTEM_INIT, "Failed to start log flusher");
+        return 0;
+    }
+    log_flusher.running = 1;
+    return 1;
+}
+
+/**
+ * Stop the flusher after a final drain
+ */
+void log_flusher_stop(void) {
+    if (!log_flusher.running) return;
+    pthread_mutex_lock(&log_flusher.lock);
+    log_flusher.stopping = 1;
+    pthread_cond_signal(&log_flusher.wake);
+    pthread_mutex_unlock(&log_flusher.lock);
+    pthread_join(log_flusher.thread, NULL);
+    log_flusher.running = 0;
+    
+    log_flusher_drain();
+    fclose(log_flusher.file);
+    log_flusher.file = NULL;
+}
+
+/* ============================================================================
+   STREAMING EXPORT
+   ============================================================================ */
+
+/**
+ * Write out the buffered bytes
+ */
+void export_flush(ExportWriter *writer) {
+    if (writer->used > 0 && !writer->failed) {
+        if (write_all(writer->fd, writer->buffer, writer->used)) {
+            writer->bytes_written += writer->used;
+            job_progress(writer->bytes_written, 0);
+        } else {
+            writer->failed = 1;
+        }
+    }
+    writer->used = 0;
+}
+
+/**
+ * Make room for at least size more bytes and return where they go
+ */
+char *export_reserve(ExportWriter *writer, size_t size) {
+    if (writer->used + size > writer->size) export_flush(writer);
+    return writer->buffer + writer->used;
+}
+
+void export_char(ExportWriter *writer, char c) {
+    *export_reserve(writer, 1) = c;
+    writer->used++;
+}
+
+void export_literal(ExportWriter *writer, const char *text) {
+    size_t length = strlen(text);
+    memcpy(export_reserve(writer, length), text, length);
+    writer->used += length;
+}
+
+/**
+ * Append a signed integer in decimal
+ */
+void export_int(ExportWriter *writer, long long value) {
+    char digits[24];
+    int n = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[n++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    
+    char *out = export_reserve(writer, n + 1);
+    char *start = out;
+    if (value < 0) *out++ = '-';
+    while (n > 0) *out++ = digits[--n];
+    writer->used += out - start;
+}
+
+/**
+ * Append a value rounded to two decimal places, falling back to
+ * snprintf for magnitudes the fixed-point path cannot hold
+ */
+void export_fixed2(ExportWriter *writer, double value) {
+    if (!(value > -1e15 && value < 1e15)) {
+        char *out = export_reserve(writer, EXPORT_FIELD_RESERVE);
+        writer->used += snprintf(out, EXPORT_FIELD_RESERVE, "%.2f", value);
+        return;
+    }
+    long long hundredths = llround(value * 100.0);
+    if (hundredths < 0) {
+        export_char(writer, '-');
+        hundredths = -hundredths;
+    }
+    export_int(writer, hundredths / 100);
+    char *out = export_reserve(writer, 3);
+    out[0] = '.';
+    out[1] = (char)('0' + hundredths / 10 % 10);
+    out[2] = (char)('0' + hundredths % 10);
+    writer->used += 3;
+}
+
+/**
+ * Append a CSV field, quoting it only when it contains a separator,
+ * quote or line break
+ */
+void export_csv_string(ExportWriter *writer, const char *text) {
+    size_t length = strlen(text);
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        memcpy(export_reserve(writer, length), text, length);
+        writer->used += length;
+        return;
+    }
+    
+    char *out = export_reserve(writer, length * 2 + 2);
+    char *start = out;
+    *out++ = '"';
+    for (const char *p = text; *p; p++) {
+        if (*p == '"') *out++ = '"';
+        *out++ = *p;
+    }
+    *out++ = '"';
+    writer->used += out - start;
+}
+
+/**
+ * Append a quoted JSON string with the required escapes
+ */
+void export_json_string(ExportWriter *writer, const char *text) {
+    static const char hex[] = "0123456789abcdef";
+    size_t length = strlen(text);
+    char *out = export_reserve(writer, length * 6 + 2);
+    char *start = out;
+    
+    *out++ = '"';
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            *out++ = '\\';
+            *out++ = (char)*p;
+        } else if (*p < 0x20) {
+            memcpy(out, "\\u00", 4);
+            out[4] = hex[*p >> 4];
+            out[5] = hex[*p & 0xF];
+            out += 6;
+        } else {
+            *out++ = (char)*p;
+        }
+    }
+    *out++ = '"';
+    writer->used += out - start;
+}
+
+/**
+ * Append a string field in the writer's format. JSON fields are written
+ * as "key":value; CSV fields are comma separated in header order.
+ */
+void export_string_field(ExportWriter *writer, int format, const char *key, const char *value, int first) {
+    if (format == EXPORT_CSV) {
+        if (!first) export_char(writer, ',');
+        export_csv_string(writer, value);
+    } else {
+        export_literal(writer, first ? "\"" : ",\"");
+        export_literal(writer, key);
+        export_literal(writer, "\":");
+        export_json_string(writer, value);
+    }
+}
+
+void export_int_field(ExportWriter *writer, int format, const char *key, long long value, int first) {
+    if (format == EXPORT_CSV) {
+        if (!first) export_char(writer, ',');
+    } else {
+        export_literal(writer, first ? "\"" : ",\"");
+        export_literal(writer, key);
+        export_literal(writer, "\":");
+    }
+    export_int(writer, value);
+}
+
+void export_fixed2_field(ExportWriter *writer, int format, const char *key, double value) {
+    if (format == EXPORT_CSV) {
+        export_char(writer, ',');
+    } else {
+        export_literal(writer, ",\"");
+        export_literal(writer, key);
+        export_literal(writer, "\":");
+    }
+    export_fixed2(writer, value);
+}
+
+/**
+ * Begin a row. JSON Lines rows name their record type so that one stream
+ * can carry every table.
+ */
+void export_row_start(ExportWriter *writer, int format, const char *record) {
+    if (format == EXPORT_JSONL) {
+        export_literal(writer, "{\"record\":\"");
+        export_literal(writer, record);
+        export_literal(writer, "\",");
+    }
+}
+
+void export_row_end(ExportWriter *writer, int format) {
+    export_literal(writer, format == EXPORT_JSONL ? "}\n" : "\n");
+}
+
+void export_students(ExportWriter *writer, int format) {
+    if (format == EXPORT_CSV) {
+        export_literal(writer, "student_id,name,email,phone,address,admission_year,major,"
+                               "registration_date,is_active\n");
+    }
+    for (int i = 0; i < student_count; i++) {
+        const Student *student = student_at(i);
+        const StudentProfile *profile = student_profile_at(i);
+        export_row_start(writer, format, "student");
+        export_int_field(writer, format, "student_id", student->student_id, 1);
+        export_string_field(writer, format, "name", profile->name, 0);
+        export_string_field(writer, format, "email", profile->email, 0);
+        export_string_field(writer, format, "phone", profile->phone, 0);
+        export_string_field(writer, format, "address", profile->address, 0);
+        export_int_field(writer, format, "admission_year", profile->admission_year, 0);
+        export_string_field(writer, format, "major", interned_text(student->major_id), 0);
+        export_int_field(writer, format, "registration_date", profile->registration_date, 0);
+        export_int_field(writer, format, "is_active", student->is_active, 0);
+        export_row_end(writer, format);
+    }
+}
+
+void export_courses(ExportWriter *writer, int format) {
+    if (format == EXPORT_CSV) {
+        export_literal(writer, "course_id,course_code,course_name,description,credits,max_capacity,"
+                               "current_enrollment,difficulty_level,created_date\n");
+    }
+    for (int i = 0; i < course_count; i++) {
+        const Course *course = course_at(i);
+        const CourseDetails *details = course_details_at(i);
+        export_row_start(writer, format, "course");
+        export_int_field(writer, format, "course_id", course->course_id, 1);
+        export_string_field(writer, format, "course_code", interned_text(course->code_id), 0);
+        export_string_field(writer, format, "course_name", details->course_name, 0);
+        export_string_field(writer, format, "description", details->description, 0);
+        export_int_field(writer, format, "credits", course->credits, 0);
+        export_int_field(writer, format, "max_capacity", course->max_capacity, 0);
+        export_int_field(writer, format, "current_enrollment", course->current_enrollment, 0);
+        export_fixed2_field(writer, format, "difficulty_level", course->difficulty_level);
+        export_int_field(writer, format, "created_date", details->created_date, 0);
+        export_row_end(writer, format);
+    }
+}
+
+void export_enrollments(ExportWriter *writer, int format) {
+    if (format == EXPORT_CSV) {
+        export_literal(writer, "enrollment_id,student_id,course_id,grade,letter_grade,credit_points,"
+                               "status,enrollment_date\n");
+    }
+    for (int i = 0; i < enrollment_count; i++) {
+        const Enrollment *enrollment = enrollment_at(i);
+        const EnrollmentColumns *columns = enrollment_columns_at(i);
+        int slot = table_slot(i);
+        char letter[2] = { enrollment->letter_grade, '\0' };
+        export_row_start(writer, format, "enrollment");
+        export_int_field(writer, format, "enrollment_id", enrollment->enrollment_id, 1);
+        export_int_field(writer, format, "student_id", columns->student_id[slot], 0);
+        export_int_field(writer, format, "course_id", columns->course_id[slot], 0);
+        export_fixed2_field(writer, format, "grade", columns->grade[slot]);
+        export_string_field(writer, format, "letter_grade", letter, 0);
+        export_fixed2_field(writer, format, "credit_points", columns->credit_points[slot]);
+        export_int_field(writer, format, "status", columns->status[slot], 0);
+        export_int_field(writer, format, "enrollment_date", enrollment->enrollment_date, 0);
+        export_row_end(writer, format);
+    }
+}
+
+/**
+ * Parse an export format name
+ * Returns the EXPORT_CSV/EXPORT_JSONL value, or -1 if unknown
+ */
+int parse_export_format(const char *name) {
+    if (strcmp(name, "csv") == 0) return EXPORT_CSV;
+    if (strcmp(name, "jsonl") == 0 || strcmp(name, "json") == 0) return EXPORT_JSONL;
+    return -1;
+}
+
+/**
+ * Parse an export table name into EXPORT_* table flags, or 0 if unknown
+ */
+int parse_export_tables(const char *name) {
+    if (strcmp(name, "students") == 0) return EXPORT_STUDENTS;
+    if (strcmp(name, "courses") == 0) return EXPORT_COURSES;
+    if (strcmp(name, "enrollments") == 0) return EXPORT_ENROLLMENTS;
+    if (strcmp(name, "all") == 0) return EXPORT_ALL;
+    return 0;
+}
+
+/**
+ * Stream the selected tables to path, or to the session output when path is "-".
+ * CSV carries a single table per file; JSON Lines may carry several.
+ * Returns the number of bytes written, or -1 on error.
+ */
+long long export_records(int format, int tables, const char *path) {
+    uint64_t started = monotonic_ns();
+    if (format == EXPORT_CSV && tables != EXPORT_STUDENTS && tables != EXPORT_COURSES &&
+        tables != EXPORT_ENROLLMENTS) {
+        log_operation(LOG_ERROR, LOG_OP_STREAM_EXPORT, "CSV export takes a single table");
+        metric_record(METRIC_EXPORT, started, 0);
+        return -1;
+    }
+    
+    ExportWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.size = export_buffer_size;
+    writer.buffer = malloc(writer.size);
+    int to_stdout = strcmp(path, "-") == 0;
+    if (to_stdout) {
+        fflush(session_output());
+        writer.fd = fileno(session_output());
+    } else {
+        writer.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (!writer.buffer || writer.fd == -1) {
+        free(writer.buffer);
+        if (writer.fd != -1 && !to_stdout) close(writer.fd);
+        log_operation(LOG_ERROR, LOG_OP_STREAM_EXPORT, "Failed to open export output");
+        metric_record(METRIC_EXPORT, started, 0);
+        return -1;
+    }
+    
+    if (tables & EXPORT_STUDENTS) export_students(&writer, format);
+    if (tables & EXPORT_COURSES) export_courses(&writer, format);
+    if (tables & EXPORT_ENROLLMENTS) export_enrollments(&writer, format);
+    export_flush(&writer);
+    
+    free(writer.buffer);
+    if (!to_stdout && close(writer.fd) != 0) writer.failed = 1;
+    if (writer.failed) {
+        log_operation(LOG_ERROR, LOG_OP_STREAM_EXPORT, "Failed to write export output");
+        metric_record(METRIC_EXPORT, started, 0);
+        return -1;
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_STREAM_EXPORT, "Exported %llu bytes of %s to %s",
+                   (unsigned long long)writer.bytes_written,
+                   format == EXPORT_CSV ? "CSV" : "JSON Lines", to_stdout ? "stdout" : path);
+    metric_record(METRIC_EXPORT, started, 1);
+    return (long long)writer.bytes_written;
+}
+
+/* ============================================================================
+   SNAPSHOT PERSISTENCE
+   ============================================================================ */
+
+/**
+ * Number of chunks needed to hold count records
+ */
+int chunks_for(int count) {
+    return (count + TABLE_CHUNK_SIZE - 1) >> TABLE_CHUNK_SHIFT;
+}
+
+/**
+ * Round a file offset up to the snapshot section alignment
+ */
+uint64_t snapshot_align(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) & ~(uint64_t)(SNAPSHOT_ALIGNMENT - 1);
+}
+
+/**
+ * Write zero bytes until the file reaches the given offset
+ */
+int write_padding(FILE *file, uint64_t *position, uint64_t target) {
+    static const char zeros[SNAPSHOT_ALIGNMENT];
+    while (*position < target) {
+        size_t n = target - *position < sizeof(zeros) ? target - *position : sizeof(zeros);
+        if (fwrite(zeros, 1, n, file) != n) return 0;
+        *position += n;
+    }
+    return 1;
+}
+
+/**
+ * Write every chunk of a table in order, one fwrite per chunk
+ */
+int write_table_chunks(FILE *file, const ChunkedTable *table, int count, uint64_t *position) {
+    size_t chunk_bytes = table->record_size * TABLE_CHUNK_SIZE;
+    for (int chunk = 0; chunk < chunks_for(count); chunk++) {
+        if (fwrite(table->chunks[chunk], 1, chunk_bytes, file) != chunk_bytes) return 0;
+        *position += chunk_bytes;
+    }
+    return 1;
+}
+
+/**
+ * Write all records to a versioned binary snapshot. The file is
+ * written beside the target and renamed into place once it is on disk.
+ */
+int write_snapshot(const char *path) {
+    char temp_path[FILE_BUFFER_SIZE];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        log_operation(LOG_ERROR, LOG_OP_SAVE_SNAPSHOT, "Failed to create snapshot file");
+        return 0;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.header_size = sizeof(SnapshotHeader);
+    header.student_count = student_count;
+    header.course_count = course_count;
+    header.enrollment_count = enrollment_count;
+    pthread_rwlock_rdlock(&interned.lock);
+    header.string_count = interned.count;
+    header.assessment_count = assessment_count;
+    header.shard_index = shard_index;
+    header.shard_count = shard_count;
+    header.next_enrollment_id = next_enrollment_id;
+    header.saved_at = time(NULL);
+    header.journal_sequence = journal.sequence;
+    header.stats = system_stats;
+    
+    /* Lay out the sections back to back, each starting on an aligned offset */
+    uint64_t archive_bytes = 0;
+    for (int s = 0; s < archive_segment_count; s++) archive_bytes += archive_segments[s]->size;
+    size_t record_sizes[SNAPSHOT_SECTION_COUNT] = {
+        sizeof(Student), sizeof(StudentProfile), sizeof(Course), sizeof(CourseDetails),
+        sizeof(Enrollment), sizeof(EnrollmentColumns), 1, sizeof(GradeRecord), 1
+    };
+    uint64_t record_counts[SNAPSHOT_SECTION_COUNT] = {
+        (uint64_t)chunks_for(student_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(student_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(course_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(course_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(enrollment_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(enrollment_count),
+        interned.pool_bytes,
+        (uint64_t)chunks_for(assessment_count) * TABLE_CHUNK_SIZE,
+        archive_bytes
+    };
+    uint64_t offset = snapshot_align(sizeof(SnapshotHeader));
+    for (int i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        header.sections[i].offset = offset;
+        header.sections[i].size = record_counts[i] * record_sizes[i];
+        header.sections[i].record_size = (uint32_t)record_sizes[i];
+        offset = snapshot_align(offset + header.sections[i].size);
+    }
+    uint64_t file_size = header.sections[SNAPSHOT_SECTION_COUNT - 1].offset +
+                         header.sections[SNAPSHOT_SECTION_COUNT - 1].size;
+    
+    uint64_t position = 0;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    position += sizeof(header);
+    
+    const ChunkedTable *tables[] = {
+        &student_table, &student_profile_table, &course_table, &course_details_table, &enrollment_table
+    };
+    const int counts[] = { student_count, student_count, course_count, course_count, enrollment_count };
+    for (int i = 0; ok && i < 5; i++) {
+        ok = write_padding(file, &position, header.sections[i].offset) &&
+             write_table_chunks(file, tables[i], counts[i], &position);
+        job_progress(position, file_size);
+    }
+    
+    ok = ok && write_padding(file, &position, header.sections[SNAPSHOT_ENROLLMENT_COLUMNS].offset);
+    for (int chunk = 0; ok && chunk < chunks_for(enrollment_count); chunk++) {
+        ok = fwrite(enrollment_columns[chunk], sizeof(EnrollmentColumns), 1, file) == 1;
+        position += sizeof(EnrollmentColumns);
+    }
+    
+    /* The string pool is written in ID order, so loading re-interns each string under its ID */
+    ok = ok && write_padding(file, &position, header.sections[SNAPSHOT_STRINGS].offset);
+    for (int id = 0; ok && id < header.string_count; id++) {
+        const char *text = interned_text(id);
+        size_t bytes = (unsigned char)text[-1] + 2;
+        ok = fwrite(text - 1, 1, bytes, file) == bytes;
+        position += bytes;
+    }
+    pthread_rwlock_unlock(&interned.lock);
+    
+    ok = ok && write_padding(file, &position, header.sections[SNAPSHOT_ASSESSMENTS].offset) &&
+         write_table_chunks(file, &grade_record_table, assessment_count, &position);
+    job_progress(position, file_size);
+    
+    /* Archive segments are self-describing and stored back to back */
+    ok = ok && write_padding(file, &position, header.sections[SNAPSHOT_ARCHIVE].offset);
+    for (int s = 0; ok && s < archive_segment_count; s++) {
+        ok = fwrite(archive_segments[s], archive_segments[s]->size, 1, file) == 1;
+        position += archive_segments[s]->size;
+    }
+    
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        log_operation(LOG_ERROR, LOG_OP_SAVE_SNAPSHOT, "Failed to write snapshot file");
+        return 0;
+    }
+    
+    job_progress(position, file_size);
+    log_operationf(LOG_SUCCESS, LOG_OP_SAVE_SNAPSHOT, "Saved %d students, %d courses, %d enrollments",
+                   student_count, course_count, enrollment_count);
+    return 1;
+}
+
+/**
+ * Save a snapshot while writers are stopped by the caller
+ */
+int save_snapshot(const char *path) {
+    if (!write_snapshot(path)) return 0;
+    
+    /* Records up to the snapshot's journal_sequence are now in the snapshot replayed at startup */
+    if (strcmp(path, snapshot_path) == 0) {
+        journal_truncate();
+    }
+    return 1;
+}
+
+/**
+ * Check that a snapshot header matches this build and fits inside the file
+ */
+int snapshot_header_valid(const SnapshotHeader *header, size_t file_size) {
+    const uint32_t record_sizes[SNAPSHOT_SECTION_COUNT] = {
+        sizeof(Student), sizeof(StudentProfile), sizeof(Course), sizeof(CourseDetails),
+        sizeof(Enrollment), sizeof(EnrollmentColumns), 1, sizeof(GradeRecord), 1
+    };
+    
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        header->version != SNAPSHOT_VERSION || header->header_size != sizeof(SnapshotHeader)) {
+        return 0;
+    }
+    if (header->student_count < 0 || header->course_count < 0 || header->enrollment_count < 0 ||
+        header->string_count < 0 || header->assessment_count < 0 ||
+        chunks_for(header->student_count) > TABLE_MAX_CHUNKS ||
+        chunks_for(header->course_count) > TABLE_MAX_CHUNKS ||
+        chunks_for(header->enrollment_count) > TABLE_MAX_CHUNKS ||
+        chunks_for(header->assessment_count) > TABLE_MAX_CHUNKS) {
+        return 0;
+    }
+    
+    const uint64_t expected_records[SNAPSHOT_SECTION_COUNT] = {
+        (uint64_t)chunks_for(header->student_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(header->student_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(header->course_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(header->course_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(header->enrollment_count) * TABLE_CHUNK_SIZE,
+        (uint64_t)chunks_for(header->enrollment_count),
+        header->sections[SNAPSHOT_STRINGS].size, /* checked string by string on load */
+        (uint64_t)chunks_for(header->assessment_count) * TABLE_CHUNK_SIZE,
+        header->sections[SNAPSHOT_ARCHIVE].size /* checked segment by segment on load */
+    };
+    for (int i = 0; i < SNAPSHOT_SECTION_COUNT; i++) {
+        const SnapshotSection *section = &header->sections[i];
+        if (section->record_size != record_sizes[i] ||
+            section->size != expected_records[i] * record_sizes[i] ||
+            section->offset % SNAPSHOT_ALIGNMENT != 0 ||
+            section->offset > file_size || section->size > file_size - section->offset) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Point a table's chunk directory at its section of the mapped snapshot
+ */
+void map_table_chunks(ChunkedTable *table, const SnapshotSection *section, int count) {
+    char *base = (char *)snapshot_mapping + section->offset;
+    size_t chunk_bytes = table->record_size * TABLE_CHUNK_SIZE;
+    for (int chunk = 0; chunk < chunks_for(count); chunk++) {
+        table->chunks[chunk] = base + (size_t)chunk * chunk_bytes;
+    }
+}
+
+/**
+ * Intern the strings of a mapped snapshot pool in place, so each gets back
+ * the ID it was saved under. Returns 0 if the pool is malformed.
+ */
+int map_string_pool(const SnapshotSection *section, int count) {
+    const char *base = (const char *)snapshot_mapping + section->offset;
+    uint64_t position = 0;
+    
+    pthread_rwlock_wrlock(&interned.lock);
+    for (int id = 0; id < count; id++) {
+        size_t length = position < section->size ? (unsigned char)base[position] : 0;
+        if (position + length + 2 > section->size || base[position + length + 1] != '\0' ||
+            intern_add(base + position + 1) != id) {
+            pthread_rwlock_unlock(&interned.lock);
+            return 0;
+        }
+        position += length + 2;
+    }
+    pthread_rwlock_unlock(&interned.lock);
+    return 1;
+}
+
+/**
+ * Point the archive at the segments of a mapped snapshot, checking each one
+ * before it is used. Returns 0 if the section is malformed or out of memory.
+ */
+int map_archive_segments(const SnapshotSection *section) {
+    const uint8_t *base = (const uint8_t *)snapshot_mapping + section->offset;
+    uint64_t position = 0;
+    int count = 0;
+    
+    while (position < section->size) {
+        const ArchiveSegment *segment = (const ArchiveSegment *)(base + position);
+        if (!archive_segment_valid(segment, section->size - position)) return 0;
+        position += segment->size;
+        count++;
+    }
+    
+    archive_segments = count > 0 ? malloc((size_t)count * sizeof(ArchiveSegment *)) : NULL;
+    if (count > 0 && !archive_segments) return 0;
+    archive_segment_capacity = count;
+    for (position = 0; position < section->size;) {
+        const ArchiveSegment *segment = (const ArchiveSegment *)(base + position);
+        archive_segments[archive_segment_count++] = segment;
+        archived_enrollment_count += segment->row_count;
+        position += segment->size;
+    }
+    return 1;
+}
+
+/**
+ * Load a snapshot into an empty system. The file is mapped privately and its
+ * chunks are used in place, so pages are only read as records are touched and
+ * later writes stay private to this process.
+ * Returns 1 when loaded, 0 when no snapshot exists, -1 when the file is
+ * rejected before anything is installed, and -2 when it fails later, after
+ * tables, strings and indexes already point into the mapping.
+ */
+int load_snapshot(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot file is truncated");
+        return -1;
+    }
+    
+    void *mapping = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Failed to map snapshot file");
+        return -1;
+    }
+    
+    const SnapshotHeader *header = mapping;
+    if (!snapshot_header_valid(header, info.st_size)) {
+        munmap(mapping, info.st_size);
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot format or version mismatch");
+        return -1;
+    }
+    
+    if (header->shard_index != shard_index || header->shard_count != shard_count) {
+        int saved_index = header->shard_index, saved_count = header->shard_count;
+        munmap(mapping, info.st_size);
+        log_operationf(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot was saved by shard %d/%d",
+                       saved_index, saved_count);
+        return -1;
+    }
+    
+    snapshot_mapping = mapping;
+    snapshot_mapping_size = info.st_size;
+    
+    map_table_chunks(&student_table, &header->sections[SNAPSHOT_STUDENTS], header->student_count);
+    map_table_chunks(&student_profile_table, &header->sections[SNAPSHOT_STUDENT_PROFILES],
+                     header->student_count);
+    map_table_chunks(&course_table, &header->sections[SNAPSHOT_COURSES], header->course_count);
+    map_table_chunks(&course_details_table, &header->sections[SNAPSHOT_COURSE_DETAILS],
+                     header->course_count);
+    map_table_chunks(&enrollment_table, &header->sections[SNAPSHOT_ENROLLMENTS],
+                     header->enrollment_count);
+    map_table_chunks(&grade_record_table, &header->sections[SNAPSHOT_ASSESSMENTS],
+                     header->assessment_count);
+    
+    EnrollmentColumns *blocks = (EnrollmentColumns *)
+        ((char *)mapping + header->sections[SNAPSHOT_ENROLLMENT_COLUMNS].offset);
+    for (int chunk = 0; chunk < chunks_for(header->enrollment_count); chunk++) {
+        enrollment_columns[chunk] = &blocks[chunk];
+    }
+    
+    if (!map_string_pool(&header->sections[SNAPSHOT_STRINGS], header->string_count)) {
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot string pool is malformed");
+        return -2;
+    }
+    if (!map_archive_segments(&header->sections[SNAPSHOT_ARCHIVE])) {
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot archive is malformed");
+        return -2;
+    }
+    
+    student_count = header->student_count;
+    course_count = header->course_count;
+    enrollment_count = header->enrollment_count;
+    assessment_count = header->assessment_count;
+    next_enrollment_id = header->next_enrollment_id;
+    system_stats = header->stats;
+    journal.sequence = header->journal_sequence;
+    
+    /* ID indexes are rebuilt rather than stored; presizing avoids rehashing */
+    if (!id_index_reserve(&student_id_index, student_count) ||
+        !id_index_reserve(&course_id_index, course_count) ||
+        !id_index_reserve(&enrollment_id_index, enrollment_count)) {
+        log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Index allocation failed");
+        return -2;
+    }
+    for (int i = 0; i < student_count; i++) {
+        id_index_insert(&student_id_index, student_at(i)->student_id, i);
+        const Student *student = student_at(i);
+        if (!name_index_add(i, student->name_truncated ? student_profile_at(i)->name : student->name_key)) {
+            log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Name index allocation failed");
+            return -2;
+        }
+    }
+    for (int i = 0; i < course_count; i++) {
+        id_index_insert(&course_id_index, course_at(i)->course_id, i);
+        if (!table_reserve(&course_histogram_table, i)) {
+            log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Histogram allocation failed");
+            return -2;
+        }
+    }
+    /* Grade histograms are derived like the indexes and rebuilt in one pass */
+    for (int i = 0; i < enrollment_count; i++) {
+        id_index_insert(&enrollment_id_index, enrollment_at(i)->enrollment_id, i);
+        const EnrollmentColumns *columns = enrollment_columns[i >> TABLE_CHUNK_SHIFT];
+        int slot = table_slot(i);
+        /* The course ID comes from the file, so it is looked up rather than trusted */
+        int course = lookup_course(columns->course_id[slot]);
+        if (course == -1) {
+            log_operation(LOG_ERROR, LOG_OP_LOAD_SNAPSHOT, "Snapshot enrollment has an unknown course");
+            return -2;
+        }
+        if (columns->status[slot] == 2) {
+            course_histogram(course_at(course))->buckets[grade_bucket(columns->grade[slot])]++;
+        }
+    }
+    for (int s = 0; s < archive_segment_count; s++) {
+        ArchiveCursor cursor;
+        ArchivedEnrollment row;
+        archive_cursor_init(&cursor, archive_segments[s], 0);
+        while (archive_cursor_next(&cursor, &row)) {
+            int course = lookup_course(row.course_id);
+            if (row.status == 2 && course != -1) {
+                course_histogram(course_at(course))->buckets[grade_bucket(row.grade)]++;
+            }
+        }
+    }
+    
+    log_operationf(LOG_SUCCESS, LOG_OP_LOAD_SNAPSHOT, "Loaded %d students, %d courses, %d enrollments",
+                   student_count, course_count, enrollment_count);
+    return 1;
+}
+
+/* ============================================================================
+   BACKGROUND JOBS
+   ============================================================================ */
+
+const char *job_kind_name(int kind) {
+    return kind == JOB_SNAPSHOT ? "Snapshot" : kind == JOB_EXPORT ? "Export" : "Text export";
+}
+
+/**
+ * Child side of a job. Descriptors other than the progress pipe are closed
+ * first, so client connections and the journal are not held open by the
+ * child. The child exits without running atexit handlers or flushing the
+ * stdio buffers it inherited.
+ */
+void background_child(const BackgroundJob *job, int progress_fd) {
+    long limit = sysconf(_SC_OPEN_MAX);
+    if (limit < 0 || limit > JOB_CLOSE_FD_LIMIT) limit = JOB_CLOSE_FD_LIMIT;
+    for (int fd = 3; fd < limit; fd++) {
+        if (fd != progress_fd) close(fd);
+    }
+    background_progress_fd = progress_fd;
+    
+    /* Only the forking thread is copied, so nothing else runs or releases a lock */
+    log_flusher.running = 0;
+    pthread_mutex_init(&metric_shards_lock, NULL);
+    
+    int ok;
+    if (job->kind == JOB_SNAPSHOT) ok = write_snapshot(job->path);
+    else if (job->kind == JOB_EXPORT) ok = export_records(job->format, job->tables, job->path) >= 0;
+    else ok = write_data_export(job->path, job->export_date);
+    _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/**
+ * Monitor thread of a job: follow the child's progress until it closes the
+ * pipe, reap it, and drop the journal records a completed snapshot of the
+ * default snapshot file covers
+ */
+void *background_monitor(void *arg) {
+    BackgroundJob *job = arg;
+    JobProgress progress;
+    ssize_t n;
+    
+    /* Messages are smaller than PIPE_BUF, so every read returns whole ones */
+    while ((n = read(job->progress_fd, &progress, sizeof(progress))) != 0) {
+        if (n == (ssize_t)sizeof(progress)) {
+            atomic_store_explicit(&job->bytes_written, progress.bytes_written, memory_order_relaxed);
+            atomic_store_explicit(&job->bytes_total, progress.bytes_total, memory_order_relaxed);
+        } else if (n < 0 && errno != EINTR) {
+            break;
+        }
+    }
+    close(job->progress_fd);
+    
+    int status = 0;
+    while (waitpid(job->pid, &status, 0) == -1 && errno == EINTR) {
+    }
+    int ok = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    
+    pthread_mutex_lock(&background_lock);
+    if (ok && job->kind == JOB_SNAPSHOT && strcmp(job->path, snapshot_path) == 0) {
+        ok = journal_compact(job->journal_covered);
+    }
+    job->finished_ns = monotonic_ns();
+    job->state = ok ? JOB_SUCCEEDED : JOB_FAILED;
+    if (job->kind != JOB_SNAPSHOT) metric_record(METRIC_EXPORT, job->started_ns, ok); /* the child's copy is lost */
+    uint64_t bytes = atomic_load_explicit(&job->bytes_written, memory_order_relaxed);
+    if (ok) {
+        log_operationf(LOG_SUCCESS, LOG_OP_BACKGROUND, "Job %d: %s to %s wrote %llu bytes in %.1f s",
+                       job->id, job_kind_name(job->kind), job->path, (unsigned long long)bytes,
+                       (job->finished_ns - job->started_ns) / 1e9);
+    } else {
+        log_operationf(LOG_ERROR, LOG_OP_BACKGROUND, "Job %d: %s to %s failed", job->id,
+                       job_kind_name(job->kind), job->path);
+    }
+    pthread_cond_broadcast(&background_done);
+    pthread_mutex_unlock(&background_lock);
+    return NULL;
+}
+
+/**
+ * Number of running jobs of a kind, or of every kind when kind is -1.
+ * The caller holds background_lock.
+ */
+int background_running(int kind) {
+    int running = 0;
+    for (int i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+        const BackgroundJob *job = &background_jobs[i];
+        if (job->state == JOB_RUNNING && (kind == -1 || job->kind == kind)) running++;
+    }
+    return running;
+}
+
+/**
+ * Start writing a snapshot or export in the background. Writers are held
+ * off only while the process forks; the child then works from a
+ * copy-on-write view of that moment, and a monitor thread reaps it. One
+ * snapshot runs at a time, so the journal is compacted in order.
+ * Stores the job ID and returns a RESULT_* code.
+ */
+int background_start(int kind, int format, int tables, const char *path, int *job_id) {
+    pthread_mutex_lock(&background_lock);
+    if (kind == JOB_SNAPSHOT && background_running(JOB_SNAPSHOT) > 0) {
+        pthread_mutex_unlock(&background_lock);
+        return RESULT_SNAPSHOT_RUNNING;
+    }
+    BackgroundJob *job = NULL;
+    for (int i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+        BackgroundJob *slot = &background_jobs[i];
+        if (slot->state != JOB_RUNNING && (!job || slot->id < job->id)) job = slot;
+    }
+    if (!job) {
+        pthread_mutex_unlock(&background_lock);
+        log_operation(LOG_ERROR, LOG_OP_BACKGROUND, "No background job slot is free");
+        return RESULT_TOO_MANY_JOBS;
+    }
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        int error = errno;
+        pthread_mutex_unlock(&background_lock);
+        log_operationf(LOG_ERROR, LOG_OP_BACKGROUND, "Failed to create a progress pipe: %s", strerror(error));
+        return RESULT_OUT_OF_MEMORY;
+    }
+    
+    memset(job, 0, sizeof(*job));
+    job->kind = kind;
+    job->format = format;
+    job->tables = tables;
+    copy_field(job->path, sizeof(job->path), path);
+    if (kind == JOB_TEXT_EXPORT) get_export_date_string(job->export_date, sizeof(job->export_date));
+    job->started_ns = monotonic_ns();
+    
+    /* Every writer and string insert is held off while the process forks */
+    lock_all_records();
+    pthread_rwlock_rdlock(&interned.lock);
+    pthread_mutex_lock(&journal.lock);
+    journal_flush();
+    job->journal_covered = journal.fd == -1 ? 0 : lseek(journal.fd, 0, SEEK_END);
+    pthread_mutex_unlock(&journal.lock);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(pipe_fds[0]);
+        background_child(job, pipe_fds[1]);
+    }
+    pthread_rwlock_unlock(&interned.lock);
+    unlock_all_records();
+    close(pipe_fds[1]);
+    
+    if (pid == -1) {
+        close(pipe_fds[0]);
+        pthread_mutex_unlock(&background_lock);
+        log_operation(LOG_ERROR, LOG_OP_BACKGROUND, "Failed to fork background job");
+        return RESULT_OUT_OF_MEMORY;
+    }
+    job->id = ++background_job_count;
+    job->pid = pid;
+    job->progress_fd = pipe_fds[0];
+    job->state = JOB_RUNNING;
+    *job_id = job->id;
+    log_operationf(LOG_INFO, LOG_OP_BACKGROUND, "Job %d: %s to %s started (pid %d)", job->id,
+                   job_kind_name(kind), job->path, (int)pid);
+    
+    pthread_t thread;
+    int monitored = pthread_create(&thread, NULL, background_monitor, job) == 0;
+    pthread_mutex_unlock(&background_lock);
+    if (monitored) pthread_detach(thread);
+    else background_monitor(job); /* no thread to spare: wait for the child here */
+    return RESULT_OK;
+}
+
+/**
+ * Wait until no job of a kind (-1 for any) is running
+ */
+void background_wait(int kind) {
+    pthread_mutex_lock(&background_lock);
+    while (background_running(kind) > 0) {
+        pthread_cond_wait(&background_done, &background_lock);
+    }
+    pthread_mutex_unlock(&background_lock);
+}
+
+/**
+ * Save a snapshot with writers stopped, once any background snapshot has
+ * finished, so the two never race to rename the file or trim the journal
+ */
+int save_snapshot_now(const char *path) {
+    pthread_mutex_lock(&background_lock);
+    while (background_running(JOB_SNAPSHOT) > 0) {
+        pthread_cond_wait(&background_done, &background_lock);
+    }
+    lock_all_records();
+    int saved = save_snapshot(path);
+    unlock_all_records();
+    pthread_mutex_unlock(&background_lock);
+    return saved;
+}
+
+/**
+ * Print every job still held in a slot with its progress
+ */
+void print_background_jobs(void) {
+    static const char *const states[] = { "Idle", "Running", "Done", "Failed" };
+    FILE *out = render_begin();
+    uint64_t now = monotonic_ns();
+    
+    fprintf(out, "\n");
+    write_separator(out, '=', 90);
+    fprintf(out, "                         BACKGROUND JOBS\n");
+    write_separator(out, '=', 90);
+    fprintf(out, "%-4s %-12s %-8s %12s %9s %9s  %s\n", "ID", "Job", "State", "Written MB", "Progress",
+            "Elapsed", "Path");
+    write_separator(out, '-', 90);
+    
+    int listed = 0;
+    pthread_mutex_lock(&background_lock);
+    for (int id = background_job_count - MAX_BACKGROUND_JOBS + 1; id <= background_job_count; id++) {
+        for (int i = 0; i < MAX_BACKGROUND_JOBS; i++) {
+            const BackgroundJob *job = &background_jobs[i];
+            if (job->id != id || id <= 0) continue;
+            uint64_t written = atomic_load_explicit(&job->bytes_written, memory_order_relaxed);
+            uint64_t total = atomic_load_explicit(&job->bytes_total, memory_order_relaxed);
+            char progress[16] = "-";
+            if (job->state == JOB_SUCCEEDED) strcpy(progress, "100.0%");
+            else if (total > 0) snprintf(progress, sizeof(progress), "%.1f%%", 100.0 * written / total);
+            fprintf(out, "%-4d %-12s %-8s %12.1f %9s %8.1fs  %s\n", job->id, job_kind_name(job->kind),
+                    states[job->state], written / 1048576.0, progress,
+                    ((job->state == JOB_RUNNING ? now : job->finished_ns) - job->started_ns) / 1e9, job->path);
+            listed++;
+        }
+    }
+    pthread_mutex_unlock(&background_lock);
+    
+    if (listed == 0) fprintf(out, "No background jobs have been started.\n");
+    write_separator(out, '=', 90);
+    render_end();
+}
+
+/**
+ * Start a job from the menu and say how to follow it
+ */
+void start_job_interactive(int kind, int format, int tables, const char *path) {
+    int job_id;
+    int result = background_start(kind, format, tables, path, &job_id);
+    if (result != RESULT_OK) {
+        printf("Error: %s!\n", result_message(result));
+        return;
+    }
+    printf("✓ %s to '%s' started in the background as job %d\n", job_kind_name(kind), path, job_id);
+    printf("  Progress is shown under Background Jobs.\n");
+}
+
+/**
+ * Export data to file
+ */
+void export_data_to_file(void) {
+    start_job_interactive(JOB_TEXT_EXPORT, 0, 0, DEFAULT_EXPORT_PATH);
+}
+
+/**
+ * Prompt for an export format, table and destination. Exports to the
+ * screen run at once; exports to a file run in the background.
+ */
+void stream_export_interactive(void) {
+    char format_name[16], table_name[16], path[FILE_BUFFER_SIZE];
+    
+    printf("Enter format (csv/jsonl): ");
+    if (!fgets(format_name, sizeof(format_name), stdin)) return;
+    format_name[strcspn(format_name, "\r\n")] = 0;
+    printf("Enter table (students/courses/enrollments/all): ");
+    if (!fgets(table_name, sizeof(table_name), stdin)) return;
+    table_name[strcspn(table_name, "\r\n")] = 0;
+    printf("Enter output path (- for screen): ");
+    if (!fgets(path, sizeof(path), stdin)) return;
+    path[strcspn(path, "\r\n")] = 0;
+    
+    int format = parse_export_format(format_name);
+    int tables = parse_export_tables(table_name);
+    if (format == -1 || tables == 0 || path[0] == '\0') {
+        printf("Error: Unknown export format, table or path!\n");
+        log_operation(LOG_ERROR, LOG_OP_STREAM_EXPORT, "Invalid export options");
+        return;
+    }
+    
+    if (format == EXPORT_CSV && tables == EXPORT_ALL) {
+        printf("Error: Export failed! CSV export takes a single table.\n");
+        return;
+    }
+    if (strcmp(path, "-") != 0) {
+        start_job_interactive(JOB_EXPORT, format, tables, path);
+        return;
+    }
+    
+    double started = monotonic_seconds();
+    long long bytes = export_records(format, tables, path);
+    double elapsed = monotonic_seconds() - started;
+    if (bytes < 0) {
+        printf("Error: Export failed!\n");
+        return;
+    }
+    printf("✓ Exported %lld bytes in %.3f s", bytes, elapsed);
+    if (elapsed > 0) printf(" (%.0f MB/s)", bytes / elapsed / (1 << 20));
+    printf("\n");
+}
+
+/**
+ * Save a snapshot from the menu
+ */
+void save_snapshot_interactive(void) {
+    start_job_interactive(JOB_SNAPSHOT, 0, 0, snapshot_path);
+}
+
+/* ============================================================================
+   JOURNAL RECOVERY
+   ============================================================================ */
+
+/**
+ * Apply one journal record through the normal record operations. Stored IDs
+ * and timestamps are checked and restored so the state matches the original.
+ * Returns 1 on success, 0 if the record does not fit the current state.
+ */
+int replay_journal_record(const JournalRecordHeader *header, const void *payload) {
+    int result = RESULT_OUT_OF_MEMORY;
+    
+    if (header->type == JOURNAL_ADD_STUDENT && header->size == sizeof(JournalStudentRecord)) {
+        const JournalStudentRecord *record = payload;
+        int index = reserve_student();
+        if (index == -1) return 0;
+        if (student_at(index)->student_id != record->student_id) {
+            release_student_reservation();
+            return 0;
+        }
+        *student_profile_at(index) = record->profile;
+        student_at(index)->major_id = intern_string(record->major);
+        result = commit_student(index);
+        student_profile_at(index)->registration_date = record->profile.registration_date;
+    } else if (header->type == JOURNAL_ADD_COURSE && header->size == sizeof(JournalCourseRecord)) {
+        const JournalCourseRecord *record = payload;
+        int index = reserve_course();
+        if (index == -1) return 0;
+        if (course_at(index)->course_id != record->course_id) {
+            release_course_reservation();
+            return 0;
+        }
+        Course *course = course_at(index);
+        course->code_id = intern_string(record->course_code);
+        course->credits = record->credits;
+        course->max_capacity = record->max_capacity;
+        course->difficulty_level = record->difficulty_level;
+        *course_details_at(index) = record->details;
+        result = commit_course(index);
+        course_details_at(index)->created_date = record->details.created_date;
+    } else if (header->type == JOURNAL_ENROLL && header->size == sizeof(JournalEnrollmentRecord)) {
+        const JournalEnrollmentRecord *record = payload;
+        int enrollment_id;
+        result = create_enrollment(record->student_id, record->course_id, &enrollment_id);
+        int waitlisted = result == RESULT_WAITLISTED;
+        if (waitlisted) result = RESULT_OK;
+        if (result != RESULT_OK || enrollment_id != record->enrollment_id ||
+            waitlisted != (record->status == 4)) return 0;
+        enrollment_at(find_enrollment(enrollment_id))->enrollment_date = record->enrollment_date;
+    } else if (header->type == JOURNAL_GRADE && header->size == sizeof(JournalGradeRecord)) {
+        const JournalGradeRecord *record = payload;
+        result = apply_grade(record->enrollment_id, record->grade);
+    } else if (header->type == JOURNAL_ASSESSMENT && header->size == sizeof(JournalAssessmentRecord)) {
+        const JournalAssessmentRecord *record = payload;
+        int assessment_id;
+        result = apply_assessment(record->enrollment_id, record->assessment_type, record->marks_obtained,
+                                  record->total_marks, &assessment_id);
+        if (result != RESULT_OK || assessment_id != record->assessment_id) return 0;
+        grade_record_at(assessment_id - assessment_id_base)->assessment_date = record->assessment_date;
+    } else if (header->type == JOURNAL_DROP && header->size == sizeof(JournalDropRecord)) {
+        const JournalDropRecord *record = payload;
+        result = drop_enrollment(record->enrollment_id);
+    } else if (header->type == JOURNAL_ARCHIVE && header->size == sizeof(JournalArchiveRecord)) {
+        const JournalArchiveRecord *record = payload;
+        int archived;
+        result = archive_enrollments(record->through_term, &archived);
+        if (result == RESULT_OK && archived != record->archived) return 0;
+    }
+    
+    if (result != RESULT_OK) return 0;
+    journal.sequence = header->sequence;
+    return 1;
+}
+
+/**
+ * Replay journal records newer than the loaded snapshot. A torn record at the
+ * end of the file, left by a crash mid-write, is cut off so appends can resume.
+ * Returns the number of records applied, or -1 if the journal cannot be used.
+ */
+int replay_journal(const char *path) {
+    int fd = open(path, O_RDWR);
+    if (fd == -1) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    FILE *file = fdopen(fd, "rb");
+    if (!file) {
+        close(fd);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+    
+    JournalFileHeader file_header;
+    if (fread(&file_header, sizeof(file_header), 1, file) != 1) {
+        /* Created but never written; journal_open will add the header */
+        fclose(file);
+        return 0;
+    }
+    if (memcmp(file_header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        file_header.version != JOURNAL_VERSION) {
+        fclose(file);
+        log_operation(LOG_ERROR, LOG_OP_JOURNAL_REPLAY, "Journal format or version mismatch");
+        return -1;
+    }
+    
+    /* Large enough for the biggest record type */
+    union {
+        JournalStudentRecord student;
+        JournalCourseRecord course;
+        JournalEnrollmentRecord enrollment;
+        JournalGradeRecord grade;
+        JournalAssessmentRecord assessment;
+        JournalArchiveRecord archive;
+    } payload;
+    
+    JournalRecordHeader header;
+    long valid_end = sizeof(file_header);
+    int applied = 0;
+    int status = 0;
+    
+    while (fread(&header, sizeof(header), 1, file) == 1) {
+        if (header.size > sizeof(payload) ||
+            fread(&payload, header.size, 1, file) != 1 ||
+            header.checksum != journal_checksum(header.sequence, &payload, header.size)) {
+            break; /* torn tail */
+        }
+        
+        if (header.sequence > journal.sequence) {
+            if (header.sequence != journal.sequence + 1 ||
+                !replay_journal_record(&header, &payload)) {
+                log_operation(LOG_ERROR, LOG_OP_JOURNAL_REPLAY,
+                              "Journal does not continue from the loaded snapshot");
+                status = -1;
+                break;
+            }
+            applied++;
+        }
+        valid_end = ftell(file);
+    }
+    
+    if (status == 0 && ftruncate(fd, valid_end) != 0) {
+        status = -1;
+    }
+    fclose(file);
+    
+    if (status == -1) return -1;
+    
+    log_operationf(LOG_INFO, LOG_OP_JOURNAL_REPLAY, "Replayed %d journal records", applied);
+    return applied;
+}
+
+/* ============================================================================
+   BATCH MODE
+   ============================================================================ */
+
+/**
+ * Split the line at line into trimmed fields in place, stopping at '\n' or
+ * limit. Fields are separated by '|' when the line contains one, otherwise
+ * by whitespace; the content ends at the first '\r' or NUL. When limit is
+ * hit and more input may follow (!final) nothing is written and NULL is
+ * returned; otherwise returns the first byte after the line.
+ */
+char *tokenize_batch_line(char *line, char *limit, int final, char **fields,
+                          int max_fields, int *field_count) {
+    char *newline = memchr(line, '\n', limit - line);
+    if (!newline && !final) return NULL;
+    
+    size_t length = strnlen(line, (newline ? newline : limit) - line);
+    char *carriage = memchr(line, '\r', length);
+    char *stop = carriage ? carriage : line + length;
+    int use_pipes = memchr(line, '|', stop - line) != NULL;
+    char *cursor = line;
+    int count = 0;
+    
+    while (cursor < stop && count < max_fields) {
+        while (cursor < stop && (*cursor == ' ' || *cursor == '\t')) cursor++;
+        if (cursor == stop) break;
+        
+        char *start = cursor;
+        if (use_pipes) {
+            char *pipe = memchr(cursor, '|', stop - cursor);
+            cursor = pipe ? pipe : stop;
+        } else {
+            while (cursor < stop && *cursor != ' ' && *cursor != '\t') cursor++;
+        }
+        
+        char *end = cursor;
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        if (cursor < stop) cursor++;
+        *end = '\0';
+        fields[count++] = start;
+    }
+    *field_count = count;
+    return newline ? newline + 1 : limit;
+}
+
+/**
+ * Split a NUL-terminated batch line into trimmed fields, as
+ * tokenize_batch_line does. Returns the field count.
+ */
+int split_batch_fields(char *line, char **fields, int max_fields) {
+    int count;
+    tokenize_batch_line(line, line + strlen(line), 1, fields, max_fields, &count);
+    return count;
+}
+
+/**
+ * Release a batch reader's buffer and file
+ */
+void batch_reader_close(BatchReader *reader) {
+    if (reader->fd >= 0 && reader->fd != STDIN_FILENO) close(reader->fd);
+    free(reader->buffer);
+    reader->buffer = NULL;
+    reader->fd = -1;
+}
+
+/**
+ * Open path ("-" for stdin) for batch_reader_next. Returns 1 on success.
+ */
+int batch_reader_open(BatchReader *reader, const char *path) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fd = strcmp(path, "-") == 0 ? STDIN_FILENO : open(path, O_RDONLY);
+    if (reader->fd < 0) return 0;
+    
+    reader->buffer = malloc(BATCH_READ_SIZE + 1);
+    if (!reader->buffer) {
+        batch_reader_close(reader);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Tokenize the next line into fields, reading more of the file when the
+ * buffer ends mid-line. Returns 0 at end of input.
+ */
+int batch_reader_next(BatchReader *reader, char **fields, int max_fields, int *field_count) {
+    for (;;) {
+        char *line = reader->buffer + reader->start;
+        char *limit = reader->buffer + reader->end;
+        if (line < limit) {
+            int full = reader->start == 0 && reader->end == BATCH_READ_SIZE;
+            char *next = tokenize_batch_line(line, limit, reader->at_eof || full,
+                                             fields, max_fields, field_count);
+            if (next) {
+                reader->start = next - reader->buffer;
+                reader->line_number++;
+                return 1;
+            }
+        } else if (reader->at_eof) {
+            return 0;
+        }
+        
+        /* Only an unfinished line is left; move it forward and read behind it */
+        memmove(reader->buffer, line, limit - line);
+        reader->end = limit - line;
+        reader->start = 0;
+        
+        ssize_t got;
+        do {
+            got = read(reader->fd, reader->buffer + reader->end, BATCH_READ_SIZE - reader->end);
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) reader->read_error = errno;
+        if (got <= 0) reader->at_eof = 1;
+        else reader->end += got;
+    }
+}
+
+/**
+ * Parse a whole-string integer field
+ */
+int parse_int_field(const char *text, int *value) {
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (end == text || *end != '\0') return 0;
+    *value = (int)parsed;
+    return 1;
+}
+
+/**
+ * Parse a whole-string decimal field
+ */
+int parse_float_field(const char *text, float *value) {
+    char *end;
+    float parsed = strtof(text, &end);
+    if (end == text || *end != '\0') return 0;
+    *value = parsed;
+    return 1;
+}
+
+/**
+ * Read the next "id value" line of a bulk request file, skipping blank and
+ * comment lines. Returns 1 with the two fields set, 0 at end of file, or -1
+ * on a line without exactly two fields.
+ */
+int next_bulk_pair(BatchReader *reader, char **fields) {
+    int field_count;
+    while (batch_reader_next(reader, fields, 3, &field_count)) {
+        if (field_count == 0 || fields[0][0] == '#') continue;
+        return field_count == 2 ? 1 : -1;
+    }
+    return 0;
+}
+
+/**
+ * Load (student_id, course_id) pairs from path ("-" for stdin). Returns the
+ * requests, or NULL with the failing line in *line_number (0 if unopened).
+ */
+EnrollmentRequest *read_enrollment_requests(const char *path, int *count, int *line_number) {
+    BatchReader reader;
+    char *fields[3];
+    EnrollmentRequest *requests = NULL;
+    int capacity = 0, read;
+    
+    *count = 0;
+    *line_number = 0;
+    if (!batch_reader_open(&reader, path)) return NULL;
+    while ((read = next_bulk_pair(&reader, fields)) == 1) {
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            EnrollmentRequest *grown = realloc(requests, capacity * sizeof(EnrollmentRequest));
+            if (!grown) break;
+            requests = grown;
+        }
+        EnrollmentRequest *request = &requests[*count];
+        if (!parse_int_field(fields[0], &request->student_id) ||
+            !parse_int_field(fields[1], &request->course_id)) break;
+        (*count)++;
+    }
+    *line_number = reader.line_number;
+    if (reader.read_error) read = -1;
+    batch_reader_close(&reader);
+    if (read != 0) {
+        free(requests);
+        return NULL;
+    }
+    return requests ? requests : malloc(sizeof(EnrollmentRequest));
+}
+
+/**
+ * Load (enrollment_id, grade) pairs from path ("-" for stdin), like
+ * read_enrollment_requests
+ */
+GradeRequest *read_grade_requests(const char *path, int *count, int *line_number) {
+    BatchReader reader;
+    char *fields[3];
+    GradeRequest *requests = NULL;
+    int capacity = 0, read;
+    
+    *count = 0;
+    *line_number = 0;
+    if (!batch_reader_open(&reader, path)) return NULL;
+    while ((read = next_bulk_pair(&reader, fields)) == 1) {
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            GradeRequest *grown = realloc(requests, capacity * sizeof(GradeRequest));
+            if (!grown) break;
+            requests = grown;
+        }
+        GradeRequest *request = &requests[*count];
+        if (!parse_int_field(fields[0], &request->enrollment_id) ||
+            !parse_float_field(fields[1], &request->grade)) break;
+        (*count)++;
+    }
+    *line_number = reader.line_number;
+    if (reader.read_error) read = -1;
+    batch_reader_close(&reader);
+    if (read != 0) {
+        free(requests);
+        return NULL;
+    }
+    return requests ? requests : malloc(sizeof(GradeRequest));
+}
+
+/**
+ * Print the usage line for a batch command with the wrong arguments
+ */
+int batch_usage(int line_number, const char *usage) {
+    fprintf(session_errors(), "line %d: usage: %s\n", line_number, usage);
+    return 0;
+}
+
+/**
+ * Parse a "--page N" or "--limit M" option at fields[*position] and move
+ * *position onto its value. A page without a limit gets
+ * LIST_DEFAULT_PAGE_SIZE rows. Returns 0 if the field is not a valid option.
+ */
+int parse_page_option(char **fields, int field_count, int *position, ListPage *page) {
+    int i = *position, value;
+    if (i + 1 >= field_count || !parse_int_field(fields[i + 1], &value)) return 0;
+    
+    if (strcmp(fields[i], "--page") == 0 && value > 0) {
+        page->page = value;
+        if (page->limit == 0) page->limit = LIST_DEFAULT_PAGE_SIZE;
+    } else if (strcmp(fields[i], "--limit") == 0 && value >= 0) {
+        page->limit = value;
+    } else {
+        return 0;
+    }
+    *position = i + 1;
+    return 1;
+}
+
+/**
+ * Execute one parsed batch command. Returns 1 on success, 0 on failure.
+ */
+int run_batch_command(char **fields, int field_count, int line_number) {
+    const char *command = fields[0];
+    int result = RESULT_OK;
+    
+    if (strcmp(command, "add-student") == 0) {
+        int year;
+        if (field_count != 7 || !parse_int_field(fields[5], &year)) {
+            return batch_usage(line_number, "add-student|name|email|phone|address|year|major");
+        }
+        
+        int index = reserve_student();
+        if (index == -1) {
+            result = RESULT_OUT_OF_MEMORY;
+        } else {
+            StudentProfile *profile = student_profile_at(index);
+            copy_field(profile->name, sizeof(profile->name), fields[1]);
+            int email_valid = copy_email_field(profile->email, sizeof(profile->email), fields[2]);
+            int phone_valid = copy_phone_field(profile->phone, sizeof(profile->phone), fields[3]);
+            copy_field(profile->address, sizeof(profile->address), fields[4]);
+            profile->admission_year = year;
+            student_at(index)->major_id = intern_string(fields[6]);
+            
+            if (!email_valid) {
+                fprintf(session_errors(), "line %d: warning: email format may be invalid\n", line_number);
+                log_operation(LOG_WARNING, LOG_OP_ADD_STUDENT, "Invalid email format");
+            }
+            if (!phone_valid) {
+                fprintf(session_errors(), "line %d: warning: phone number format may be invalid\n", line_number);
+                log_operation(LOG_WARNING, LOG_OP_ADD_STUDENT, "Invalid phone format");
+            }
+            result = commit_student(index);
+            /* Shard IDs are not sequential from a client's view, so new ones are reported */
+            if (result == RESULT_OK && shard_count > 1) {
+                fprintf(session_output(), "student %d\n", student_at(index)->student_id);
+            }
+        }
+    } else if (strcmp(command, "add-course") == 0) {
+        int credits, capacity, expected_id = 0;
+        float difficulty;
+        if ((field_count != 7 && field_count != 8) || !parse_int_field(fields[4], &credits) ||
+            !parse_int_field(fields[5], &capacity) || !parse_float_field(fields[6], &difficulty) ||
+            (field_count == 8 && !parse_int_field(fields[7], &expected_id))) {
+            return batch_usage(line_number,
+                               "add-course|code|name|description|credits|capacity|difficulty[|course_id]");
+        }
+        
+        /* An expected ID keeps shards from assigning a course different IDs */
+        int index = reserve_course();
+        if (index != -1 && expected_id && course_at(index)->course_id != expected_id) {
+            fprintf(session_errors(), "line %d: add-course: next course ID is %d, not %d\n",
+                    line_number, course_at(index)->course_id, expected_id);
+            log_operation(LOG_ERROR, LOG_OP_ADD_COURSE, "Course ID does not match the expected ID");
+            release_course_reservation();
+            return 0;
+        }
+        if (index == -1) {
+            result = RESULT_OUT_OF_MEMORY;
+        } else {
+            Course *course = course_at(index);
+            CourseDetails *details = course_details_at(index);
+            course->code_id = intern_string(fields[1]);
+            copy_field(details->course_name, sizeof(details->course_name), fields[2]);
+            copy_field(details->description, sizeof(details->description), fields[3]);
+            course->credits = credits;
+            course->max_capacity = shard_seat_quota(capacity);
+            course->difficulty_level = difficulty;
+            result = commit_course(index);
+            if (result == RESULT_OK && shard_count > 1) {
+                fprintf(session_output(), "course %d\n", course->course_id);
+            }
+        }
+    } else if (strcmp(command, "enroll") == 0) {
+        int student_id, course_id, enrollment_id;
+        if (field_count != 3 || !parse_int_field(fields[1], &student_id) ||
+            !parse_int_field(fields[2], &course_id)) {
+            return batch_usage(line_number, "enroll student_id course_id");
+        }
+        result = create_enrollment(student_id, course_id, &enrollment_id);
+        if (result == RESULT_WAITLISTED) {
+            fprintf(session_output(), "waitlisted %d\n", enrollment_id);
+            result = RESULT_OK;
+        } else if (result == RESULT_OK && shard_count > 1) {
+            fprintf(session_output(), "enrolled %d\n", enrollment_id);
+        }
+    } else if (strcmp(command, "grade") == 0) {
+        int enrollment_id;
+        float grade;
+        if (field_count != 3 || !parse_int_field(fields[1], &enrollment_id) ||
+            !parse_float_field(fields[2], &grade)) {
+            return batch_usage(line_number, "grade enrollment_id grade");
+        }
+        result = apply_grade(enrollment_id, grade);
+    } else if (strcmp(command, "assess") == 0) {
+        int enrollment_id, assessment_id;
+        float marks, total_marks;
+        if (field_count != 5 || !parse_int_field(fields[1], &enrollment_id) ||
+            !parse_float_field(fields[3], &marks) || !parse_float_field(fields[4], &total_marks)) {
+            return batch_usage(line_number, "assess enrollment_id Quiz|Assignment|Midterm|Final marks total_marks");
+        }
+        result = apply_assessment(enrollment_id, parse_assessment_type(fields[2]), marks, total_marks,
+                                  &assessment_id);
+        if (result == RESULT_OK && shard_count > 1) {
+            fprintf(session_output(), "assessment %d\n", assessment_id);
+        }
+    } else if (strcmp(command, "assessments") == 0) {
+        int enrollment_id;
+        if (field_count != 2 || !parse_int_field(fields[1], &enrollment_id)) {
+            return batch_usage(line_number, "assessments enrollment_id");
+        }
+        print_assessments(enrollment_id);
+    } else if (strcmp(command, "complete") == 0) {
+        int enrollment_id;
+        float grade;
+        if (field_count != 2 || !parse_int_field(fields[1], &enrollment_id)) {
+            return batch_usage(line_number, "complete enrollment_id");
+        }
+        result = complete_enrollment(enrollment_id, &grade);
+    } else if (strcmp(command, "students") == 0 || strcmp(command, "courses") == 0) {
+        ListPage page = LIST_ALL_ROWS;
+        for (int i = 1; i < field_count; i++) {
+            if (!parse_page_option(fields, field_count, &i, &page)) {
+                return batch_usage(line_number, "students|courses [--page N] [--limit M]");
+            }
+        }
+        if (strcmp(command, "students") == 0) print_student_list(page);
+        else print_course_list(page);
+    } else if (strcmp(command, "students-by-name") == 0) {
+        ListPage page = LIST_ALL_ROWS;
+        for (int i = 1; i < field_count; i++) {
+            if (!parse_page_option(fields, field_count, &i, &page)) {
+                return batch_usage(line_number, "students-by-name [--page N] [--limit M]");
+            }
+        }
+        print_students_by_name(page);
+    } else if (strcmp(command, "top-gpa") == 0 || strcmp(command, "top-fill") == 0) {
+        int k = TOP_K_DEFAULT;
+        if (field_count > 2 || (field_count == 2 && (!parse_int_field(fields[1], &k) || k <= 0))) {
+            return batch_usage(line_number, "top-gpa|top-fill [K]");
+        }
+        if (strcmp(command, "top-gpa") == 0) print_top_gpa(k);
+        else print_course_fill(k);
+    } else if (strcmp(command, "enrollments") == 0) {
+        int id;
+        ListPage page = LIST_ALL_ROWS;
+        int valid = field_count >= 2 && parse_int_field(fields[1], &id);
+        for (int i = 2; valid && i < field_count; i++) {
+            valid = parse_page_option(fields, field_count, &i, &page);
+        }
+        if (!valid) return batch_usage(line_number, "enrollments student_id [--page N] [--limit M]");
+        print_student_enrollments(id, page);
+    } else if (strcmp(command, "student") == 0 || strcmp(command, "course") == 0 ||
+               strcmp(command, "gpa") == 0 || strcmp(command, "class-stats") == 0) {
+        int id;
+        if (field_count != 2 || !parse_int_field(fields[1], &id)) {
+            return batch_usage(line_number, "student|course|gpa|class-stats id");
+        }
+        if (strcmp(command, "student") == 0) display_student_details(id);
+        else if (strcmp(command, "course") == 0) display_course_details(id);
+        else if (strcmp(command, "gpa") == 0) print_student_gpa(id);
+        else print_class_statistics(id);
+    } else if (strcmp(command, "bulk-enroll") == 0 || strcmp(command, "bulk-grade") == 0) {
+        int enroll = strcmp(command, "bulk-enroll") == 0;
+        int count, bad_line, failed = -1, waitlisted = 0;
+        if (field_count != 2) {
+            return batch_usage(line_number, enroll ? "bulk-enroll FILE|-" : "bulk-grade FILE|-");
+        }
+        
+        EnrollmentRequest *enrollments = NULL;
+        GradeRequest *grades = NULL;
+        if (enroll) enrollments = read_enrollment_requests(fields[1], &count, &bad_line);
+        else grades = read_grade_requests(fields[1], &count, &bad_line);
+        if (!enrollments && !grades) {
+            if (bad_line == 0) {
+                fprintf(session_errors(), "line %d: %s: could not open '%s'\n", line_number, command, fields[1]);
+            } else {
+                fprintf(session_errors(), "line %d: %s: %s:%d: expected %s\n", line_number, command,
+                        fields[1], bad_line, enroll ? "student_id course_id" : "enrollment_id grade");
+            }
+            return 0;
+        }
+        
+        if (enroll) {
+            failed = bulk_enroll(enrollments, count);
+            for (int i = 0; failed != -1 && i < count; i++) {
+                if (enrollments[i].result == RESULT_WAITLISTED) {
+                    waitlisted++;
+                } else if (enrollments[i].result != RESULT_OK) {
+                    fprintf(session_errors(), "line %d: %s: student %d, course %d: %s\n", line_number,
+                            command, enrollments[i].student_id, enrollments[i].course_id,
+                            result_message(enrollments[i].result));
+                }
+            }
+        } else {
+            failed = bulk_grade(grades, count);
+            for (int i = 0; failed > 0 && i < count; i++) {
+                if (grades[i].result != RESULT_OK) {
+                    fprintf(session_errors(), "line %d: %s: enrollment %d: %s\n", line_number, command,
+                            grades[i].enrollment_id, result_message(grades[i].result));
+                }
+            }
+        }
+        free(enrollments);
+        free(grades);
+        
+        if (failed == -1) {
+            result = RESULT_OUT_OF_MEMORY;
+        } else {
+            fprintf(session_output(), "%s: %d requests, %d applied, %d waitlisted, %d failed\n",
+                    command, count, count - failed - waitlisted, waitlisted, failed);
+            if (failed > 0) return 0;
+        }
+    } else if (strcmp(command, "drop") == 0) {
+        int enrollment_id;
+        if (field_count != 2 || !parse_int_field(fields[1], &enrollment_id)) {
+            return batch_usage(line_number, "drop enrollment_id");
+        }
+        result = drop_enrollment(enrollment_id);
+    } else if (strcmp(command, "archive") == 0) {
+        int year, term = -1, archived;
+        if (field_count == 1) {
+            print_archive_summary();
+        } else if (field_count != 3 || !parse_int_field(fields[1], &year) ||
+                   (term = term_number(year, fields[2])) == -1) {
+            return batch_usage(line_number, "archive [year spring|fall]");
+        } else if ((result = archive_enrollments(term, &archived)) == RESULT_OK) {
+            char name[32];
+            format_term(term, name, sizeof(name));
+            fprintf(session_output(), "archived %d enrollments through %s\n", archived, name);
+        }
+    } else if (strcmp(command, "deans-list") == 0) {
+        float min_gpa = DEANS_LIST_MIN_GPA;
+        int min_credits = DEANS_LIST_MIN_CREDITS;
+        if (field_count > 3 || (field_count >= 2 && !parse_float_field(fields[1], &min_gpa)) ||
+            (field_count == 3 && !parse_int_field(fields[2], &min_credits))) {
+            return batch_usage(line_number, "deans-list [min_gpa] [min_credits]");
+        }
+        print_deans_list(min_gpa, min_credits);
+    } else if (strcmp(command, "majors") == 0) {
+        if (field_count != 1) return batch_usage(line_number, "majors");
+        print_major_report();
+    } else if (strcmp(command, "metrics") == 0) {
+        if (field_count == 1) {
+            print_metrics();
+        } else if (field_count <= 3 && strcmp(fields[1], "prometheus") == 0) {
+            const char *path = field_count == 3 ? fields[2] : "-";
+            if (!dump_prometheus_metrics(path)) {
+                fprintf(session_errors(), "line %d: metrics: could not write '%s'\n", line_number, path);
+                return 0;
+            }
+        } else {
+            return batch_usage(line_number, "metrics [prometheus [path|-]]");
+        }
+    } else if (strcmp(command, "report") == 0) {
+        int tables = field_count >= 2 ? parse_report_tables(fields[1]) : 0;
+        if (field_count > 3 || tables == 0) return batch_usage(line_number, "report students|courses|all [path|-]");
+        const char *path = field_count == 3 ? fields[2] : "-";
+        if (!run_term_report(tables, path)) {
+            fprintf(session_errors(), "line %d: report: could not write '%s'\n", line_number, path);
+            return 0;
+        }
+    } else if (strcmp(command, "stats") == 0) {
+        display_system_statistics();
+    } else if (strcmp(command, "partial") == 0) {
+        int course_id;
+        if (field_count == 2 && strcmp(fields[1], "stats") == 0) {
+            write_partial_statistics(session_output());
+        } else if (field_count == 3 && strcmp(fields[1], "class") == 0 &&
+                   parse_int_field(fields[2], &course_id)) {
+            if (!write_partial_class(session_output(), course_id)) result = RESULT_COURSE_NOT_FOUND;
+        } else {
+            return batch_usage(line_number, "partial stats | partial class course_id");
+        }
+    } else if (strcmp(command, "export") == 0) {
+        int background = field_count >= 2 && strcmp(fields[field_count - 1], "--background") == 0;
+        int arguments = field_count - background;
+        int format = arguments >= 3 ? parse_export_format(fields[1]) : -1;
+        int tables = arguments >= 3 ? parse_export_tables(fields[2]) : 0;
+        const char *path = arguments == 4 ? fields[3] : "-";
+        if (arguments > 4 || format == -1 || tables == 0 || (background && strcmp(path, "-") == 0)) {
+            return batch_usage(line_number,
+                               "export csv|jsonl students|courses|enrollments|all [path|-] [--background]");
+        }
+        if (format == EXPORT_CSV && tables == EXPORT_ALL) {
+            fprintf(session_errors(), "line %d: export: CSV takes a single table\n", line_number);
+            return 0;
+        }
+        if (background) {
+            int job_id;
+            result = background_start(JOB_EXPORT, format, tables, path, &job_id);
+            if (result == RESULT_OK) fprintf(session_output(), "job %d started: export to %s\n", job_id, path);
+        } else {
+            lock_all_records();
+            long long written = export_records(format, tables, path);
+            unlock_all_records();
+            if (written < 0) {
+                fprintf(session_errors(), "line %d: export: could not write '%s'\n", line_number, path);
+                return 0;
+            }
+        }
+    } else if (strcmp(command, "find") == 0) {
+        int flags = 0, limit = SEARCH_DEFAULT_LIMIT;
+        if (field_count < 2) return batch_usage(line_number, "find|text[|prefix][|icase][|limit=N]");
+        for (int i = 2; i < field_count; i++) {
+            if (strcmp(fields[i], "prefix") == 0) {
+                flags |= SEARCH_PREFIX;
+            } else if (strcmp(fields[i], "icase") == 0) {
+                flags |= SEARCH_IGNORE_CASE;
+            } else if (strncmp(fields[i], "limit=", 6) != 0 ||
+                       !parse_int_field(fields[i] + 6, &limit) || limit <= 0) {
+                return batch_usage(line_number, "find|text[|prefix][|icase][|limit=N]");
+            }
+        }
+        print_name_search(fields[1], flags, limit);
+    } else if (strcmp(command, "log") == 0) {
+        LogQuery query = { 0, -1, 0, 0, LOG_QUERY_DEFAULT_LIMIT };
+        ListPage page = LIST_ALL_ROWS;
+        for (int i = 1; i < field_count; i++) {
+            if (strncmp(fields[i], "--", 2) == 0) {
+                if (!parse_page_option(fields, field_count, &i, &page)) {
+                    return batch_usage(line_number, "log [level=L] [op=NAME] [since=MINUTES] [until=MINUTES] [last=N] [--page N] [--limit M]");
+                }
+                continue;
+            }
+            char *value = strchr(fields[i], '=');
+            int number = 0;
+            if (value) *value++ = '\0';
+            if (!value) {
+                return batch_usage(line_number, "log [level=L] [op=NAME] [since=MINUTES] [until=MINUTES] [last=N] [--page N] [--limit M]");
+            } else if (strcmp(fields[i], "level") == 0 && (query.level = parse_log_level(value)) != -1) {
+            } else if (strcmp(fields[i], "op") == 0 && (query.operation = parse_log_operation(value)) != -1) {
+            } else if (strcmp(fields[i], "since") == 0 && parse_int_field(value, &number) && number > 0) {
+                query.since = time(NULL) - (time_t)number * 60;
+            } else if (strcmp(fields[i], "until") == 0 && parse_int_field(value, &number) && number >= 0) {
+                query.until = time(NULL) - (time_t)number * 60;
+            } else if (strcmp(fields[i], "last") == 0 && parse_int_field(value, &query.limit) &&
+                       query.limit > 0) {
+            } else {
+                return batch_usage(line_number, "log [level=L] [op=NAME] [since=MINUTES] [until=MINUTES] [last=N] [--page N] [--limit M]");
+            }
+        }
+        print_log_query(&query, page);
+    } else if (strcmp(command, "save") == 0) {
+        int background = field_count >= 2 && strcmp(fields[field_count - 1], "--background") == 0;
+        int arguments = field_count - background;
+        if (arguments > 2) return batch_usage(line_number, "save [path] [--background]");
+        const char *path = arguments == 2 ? fields[1] : snapshot_path;
+        if (background) {
+            int job_id;
+            result = background_start(JOB_SNAPSHOT, 0, 0, path, &job_id);
+            if (result == RESULT_OK) fprintf(session_output(), "job %d started: snapshot to %s\n", job_id, path);
+        } else if (!save_snapshot_now(path)) {
+            fprintf(session_errors(), "line %d: save: could not write snapshot '%s'\n", line_number, path);
+            return 0;
+        }
+    } else if (strcmp(command, "jobs") == 0) {
+        if (field_count > 2 || (field_count == 2 && strcmp(fields[1], "wait") != 0)) {
+            return batch_usage(line_number, "jobs [wait]");
+        }
+        if (field_count == 2) background_wait(-1);
+        print_background_jobs();
     } else {
-        printf("Found %d student(s)\n", found);
+        fprintf(session_errors(), "line %d: unknown command '%s'\n", line_number, command);
+        return 0;
     }
-    printf("\n");
+    
+    if (result != RESULT_OK) {
+        fprintf(session_errors(), "line %d: %s: %s\n", line_number, command, result_message(result));
+        return 0;
+    }
+    return 1;
 }
 
-/* ============================================================================
-   COURSE MANAGEMENT FUNCTIONS
-   ============================================================================ */
-
 /**
- * Add a new course
+ * Run every command in a batch file ("-" reads stdin) without menus or
+ * prompts, then report throughput. Returns the number of failed commands.
  */
-int add_course(void) {
-    if (course_count >= MAX_COURSES) {
-        printf("Error: Maximum course limit reached!\n");
-        log_operation(LOG_ERROR, "Add Course", "Maximum course limit exceeded");
-        return 0;
+int run_batch(const char *path) {
+    BatchReader reader;
+    if (!batch_reader_open(&reader, path)) {
+        fprintf(stderr, "Error: Could not open batch file '%s'\n", path);
+        log_operation(LOG_ERROR, LOG_OP_BATCH, "Failed to open batch file");
+        return -1;
     }
     
-    printf("\n");
-    print_separator('=', 60);
-    printf("                     ADD NEW COURSE\n");
-    print_separator('=', 60);
-    
-    courses[course_count].course_id = course_count + 5001;
-    
-    printf("Enter course code (e.g., CS101): ");
-    fgets(courses[course_count].course_code, MAX_COURSE_CODE, stdin);
-    courses[course_count].course_code[strcspn(courses[course_count].course_code, "\n")] = 0;
-    
-    printf("Enter course name: ");
-    fgets(courses[course_count].course_name, MAX_NAME_LENGTH, stdin);
-    courses[course_count].course_name[strcspn(courses[course_count].course_name, "\n")] = 0;
-    
-    printf("Enter course description: ");
-    fgets(courses[course_count].description, MAX_DESCRIPTION, stdin);
-    courses[course_count].description[strcspn(courses[course_count].description, "\n")] = 0;
+    char *fields[MAX_BATCH_FIELDS];
+    int field_count, commands = 0, failed = 0;
+    double started = monotonic_seconds();
     
-    printf("Enter course credits: ");
-    scanf("%d", &courses[course_count].credits);
+    while (batch_reader_next(&reader, fields, MAX_BATCH_FIELDS, &field_count)) {
+        if (field_count == 0 || fields[0][0] == '#') continue;
+        
+        commands++;
+        if (!command_handler(fields, field_count, reader.line_number)) failed++;
+    }
     
-    printf("Enter maximum capacity: ");
-    scanf("%d", &courses[course_count].max_capacity);
+    double elapsed = monotonic_seconds() - started;
+    if (reader.read_error) {
+        fprintf(stderr, "Error: Reading batch file '%s' failed: %s\n", path, strerror(reader.read_error));
+        log_operation(LOG_ERROR, LOG_OP_BATCH, "Failed to read batch file");
+        failed++;
+    }
+    batch_reader_close(&reader);
     
-    printf("Enter difficulty level (1.0 - 5.0): ");
-    scanf("%f", &courses[course_count].difficulty_level);
+    printf("Batch complete: %d commands (%d succeeded, %d failed) in %.3f s",
+           commands, commands - failed, failed, elapsed);
+    if (elapsed > 0) printf(", %.0f commands/s", commands / elapsed);
+    printf("\n");
     
-    clear_input_buffer();
+    log_operationf(failed ? LOG_WARNING : LOG_SUCCESS, LOG_OP_BATCH,
+                   "Processed %d batch commands (%d failed)", commands, failed);
+    return failed;
+}
+
+/* ============================================================================
+   SHARD COORDINATOR
+   ============================================================================ */
+
+/**
+ * Parse "host:port[,host:port...]" into the coordinator's shard list, in
+ * shard order. Returns 0 if an address is malformed or there are too many.
+ */
+int parse_shard_addresses(const char *list) {
+    char copy[FILE_BUFFER_SIZE];
+    copy_field(copy, sizeof(copy), list);
     
-    courses[course_count].current_enrollment = 0;
-    courses[course_count].created_date = time(NULL);
+    int count = 0;
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        ShardAddress *address = &coordinator.shards[count];
+        char *colon = strrchr(item, ':');
+        int port;
+        if (count == MAX_SHARDS || !colon || colon == item ||
+            (size_t)(colon - item) >= sizeof(address->host) ||
+            !parse_int_field(colon + 1, &port) || port <= 0 || port > 65535) {
+            return 0;
+        }
+        *colon = '\0';
+        copy_field(address->host, sizeof(address->host), item);
+        snprintf(address->port, sizeof(address->port), "%d", port);
+        count++;
+    }
+    coordinator.shard_count = count;
+    return count > 0;
+}
+
+void shard_link_close(int shard) {
+    ShardLink *link = &shard_links[shard];
+    if (link->input) fclose(link->input);
+    if (link->output) fclose(link->output);
+    link->input = link->output = NULL;
+}
+
+/**
+ * Open this thread's connection to a shard unless it is already open.
+ * Returns 0 when the shard cannot be reached.
+ */
+int shard_connect(int shard) {
+    ShardLink *link = &shard_links[shard];
+    if (link->output) return 1;
     
-    printf("\n✓ Course added successfully with ID: %d\n", courses[course_count].course_id);
+    const ShardAddress *address = &coordinator.shards[shard];
+    struct addrinfo hints, *addresses;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(address->host, address->port, &hints, &addresses) != 0) return 0;
     
-    char log_details[200];
-    sprintf(log_details, "Added course: %s (%s)", courses[course_count].course_name,
-            courses[course_count].course_code);
-    log_operation(LOG_SUCCESS, "Add Course", log_details);
+    int fd = -1;
+    for (struct addrinfo *candidate = addresses; candidate && fd == -1; candidate = candidate->ai_next) {
+        fd = socket(candidate->ai_family, candidate->ai_socktype, candidate->ai_protocol);
+        if (fd != -1 && connect(fd, candidate->ai_addr, candidate->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd == -1) return 0;
     
-    course_count++;
+    int write_fd = dup(fd);
+    link->input = fdopen(fd, "r");
+    link->output = write_fd != -1 ? fdopen(write_fd, "w") : NULL;
+    if (!link->input || !link->output) {
+        if (!link->input) close(fd);
+        if (!link->output && write_fd != -1) close(write_fd);
+        shard_link_close(shard);
+        return 0;
+    }
     return 1;
 }
 
 /**
- * Display all courses
+ * Send a command to a shard. Fields are rejoined with a '|' after each one,
+ * which the shard splits back into the same fields whatever they contain.
  */
-void display_all_courses(void) {
-    if (course_count == 0) {
-        printf("No courses in the system.\n");
-        return;
-    }
+int shard_send(int shard, char **fields, int field_count) {
+    if (!shard_connect(shard)) return 0;
     
-    printf("\n");
-    print_separator('=', 120);
-    printf("%-6s %-10s %-25s %-8s %-12s %-10s %-15s\n", 
-           "ID", "Code", "Name", "Credits", "Capacity", "Enrolled", "Difficulty");
-    print_separator('=', 120);
-    
-    for (int i = 0; i < course_count; i++) {
-        printf("%-6d %-10s %-25s %-8d %-12d %-10d %-15.1f\n",
-               courses[i].course_id,
-               courses[i].course_code,
-               courses[i].course_name,
-               courses[i].credits,
-               courses[i].max_capacity,
-               courses[i].current_enrollment,
-               courses[i].difficulty_level);
+    FILE *output = shard_links[shard].output;
+    for (int i = 0; i < field_count; i++) {
+        fputs(fields[i], output);
+        fputc('|', output);
     }
-    
-    print_separator('=', 120);
-    printf("Total Courses: %d\n\n", course_count);
+    fputc('\n', output);
+    if (fflush(output) != 0) {
+        shard_link_close(shard);
+        return 0;
+    }
+    return 1;
 }
 
 /**
- * Display course details
+ * Read a shard's reply to the last command, copying its output to sink
+ * unless sink is NULL. Returns 1 for OK, 0 for ERR and -1 if the connection
+ * was lost.
  */
-void display_course_details(int course_id) {
-    for (int i = 0; i < course_count; i++) {
-        if (courses[i].course_id == course_id) {
-            printf("\n");
-            print_separator('=', 70);
-            printf("                      COURSE DETAILS\n");
-            print_separator('=', 70);
-            printf("Course ID:           %d\n", courses[i].course_id);
-            printf("Course Code:         %s\n", courses[i].course_code);
-            printf("Course Name:         %s\n", courses[i].course_name);
-            printf("Description:         %s\n", courses[i].description);
-            printf("Credits:             %d\n", courses[i].credits);
-            printf("Maximum Capacity:    %d\n", courses[i].max_capacity);
-            printf("Current Enrollment:  %d\n", courses[i].current_enrollment);
-            printf("Enrollment Rate:     %.1f%%\n", 
-                   (float)courses[i].current_enrollment / courses[i].max_capacity * 100);
-            printf("Difficulty Level:    %.1f/5.0\n", courses[i].difficulty_level);
-            printf("Available Seats:     %d\n", courses[i].max_capacity - courses[i].current_enrollment);
-            print_separator('=', 70);
-            printf("\n");
-            return;
-        }
-    }
-    
-    printf("Course not found.\n");
-    log_operation(LOG_WARNING, "Display Course", "Course ID not found");
+int shard_reply(int shard, FILE *sink) {
+    char line[FILE_BUFFER_SIZE];
+    while (fgets(line, sizeof(line), shard_links[shard].input)) {
+        if (strcmp(line, "OK\n") == 0) return 1;
+        if (strcmp(line, "ERR\n") == 0) return 0;
+        if (sink) fputs(line, sink);
+    }
+    shard_link_close(shard);
+    return -1;
 }
 
-/* ============================================================================
-   ENROLLMENT MANAGEMENT FUNCTIONS
-   ============================================================================ */
+int shard_unavailable(int line_number, const char *command, int shard) {
+    fprintf(session_errors(), "line %d: %s: shard %d (%s:%s) is unavailable\n", line_number, command,
+            shard, coordinator.shards[shard].host, coordinator.shards[shard].port);
+    log_operationf(LOG_ERROR, LOG_OP_SERVER, "Shard %d is unavailable", shard);
+    return 0;
+}
 
 /**
- * Enroll a student in a course
+ * Shard owning a student or enrollment ID. Malformed and unknown IDs go to
+ * shard 0, which answers them with its usual usage or not-found error.
  */
-int enroll_student_in_course(void) {
-    if (enrollment_count >= MAX_ENROLLMENTS) {
-        printf("Error: Maximum enrollment limit reached!\n");
-        log_operation(LOG_ERROR, "Enrollment", "Maximum enrollment limit exceeded");
+int shard_for_id(const char *field, int first_id) {
+    int id;
+    if (!parse_int_field(field, &id) || id < first_id) return 0;
+    int shard = (id - first_id) / SHARD_ID_SPAN;
+    return shard < coordinator.shard_count ? shard : 0;
+}
+
+/**
+ * Run a command on one shard and relay its output
+ */
+int coordinate_forward(int shard, char **fields, int field_count, int line_number) {
+    if (!shard_send(shard, fields, field_count)) return shard_unavailable(line_number, fields[0], shard);
+    int reply = shard_reply(shard, session_output());
+    return reply == -1 ? shard_unavailable(line_number, fields[0], shard) : reply;
+}
+
+/**
+ * Run a command on every shard, relaying the output of shard 0 only.
+ * Broadcasts are serialised with catalog changes, so every shard sees them
+ * in one order. Succeeds only if every shard succeeds.
+ */
+int coordinate_broadcast(char **fields, int field_count, int line_number) {
+    int sent[MAX_SHARDS];
+    int ok = 1;
+    
+    pthread_mutex_lock(&coordinator.catalog_lock);
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        sent[shard] = shard_send(shard, fields, field_count);
+    }
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        int reply = sent[shard] ? shard_reply(shard, shard == 0 ? session_output() : NULL) : -1;
+        if (reply == -1) {
+            ok = shard_unavailable(line_number, fields[0], shard);
+        } else if (reply == 0) {
+            if (shard > 0) fprintf(session_errors(), "line %d: %s: failed on shard %d\n",
+                                   line_number, fields[0], shard);
+            ok = 0;
+        }
+    }
+    pthread_mutex_unlock(&coordinator.catalog_lock);
+    return ok;
+}
+
+/**
+ * Add a course on every shard under one ID. Shard 0 assigns the ID and the
+ * others are sent it, so a shard that would assign another one refuses.
+ * If the course reaches only some shards, their catalogs no longer agree
+ * and further catalog changes are refused.
+ */
+int coordinate_add_course(char **fields, int field_count, int line_number) {
+    pthread_mutex_lock(&coordinator.catalog_lock);
+    if (coordinator.catalog_diverged) {
+        pthread_mutex_unlock(&coordinator.catalog_lock);
+        fprintf(session_errors(), "line %d: add-course: shard catalogs disagree; catalog changes are disabled\n",
+                line_number);
         return 0;
     }
     
-    printf("\n");
-    print_separator('=', 60);
-    printf("                  ENROLL STUDENT\n");
-    print_separator('=', 60);
-    
-    printf("Enter student ID: ");
-    int student_id;
-    scanf("%d", &student_id);
-    
-    printf("Enter course ID: ");
-    int course_id;
-    scanf("%d", &course_id);
+    char *reply_text = NULL;
+    size_t size;
+    FILE *sink = open_memstream(&reply_text, &size);
+    int reply = shard_send(0, fields, field_count) ? shard_reply(0, sink) : -1;
+    if (sink) fclose(sink);
+    if (reply_text) fputs(reply_text, session_output());
     
-    clear_input_buffer();
+    int course_id = 0, failed = 0;
+    if (reply == 1 && (!reply_text || sscanf(reply_text, "course %d", &course_id) != 1)) {
+        /* Added on shard 0 under an ID that cannot be passed on */
+        fprintf(session_errors(), "line %d: add-course: shard 0 did not report the course ID\n", line_number);
+        failed = 1;
+    }
+    free(reply_text);
+    if (reply != 1) {
+        pthread_mutex_unlock(&coordinator.catalog_lock);
+        return reply == -1 ? shard_unavailable(line_number, fields[0], 0) : 0;
+    }
     
-    /* Validate student exists */
-    int student_index = -1;
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].student_id == student_id && students[i].is_active) {
-            student_index = i;
-            break;
+    char id_text[16];
+    char *with_id[MAX_BATCH_FIELDS];
+    int sent[MAX_SHARDS];
+    snprintf(id_text, sizeof(id_text), "%d", course_id);
+    for (int i = 0; i < 7; i++) with_id[i] = fields[i];
+    with_id[7] = id_text;
+    for (int shard = 1; shard < coordinator.shard_count && !failed; shard++) {
+        sent[shard] = shard_send(shard, with_id, 8);
+    }
+    for (int shard = 1; shard < coordinator.shard_count && !failed; shard++) {
+        reply = sent[shard] ? shard_reply(shard, NULL) : -1;
+        if (reply == -1) {
+            shard_unavailable(line_number, fields[0], shard);
+            failed = 1;
+        } else if (reply == 0) {
+            fprintf(session_errors(), "line %d: %s: failed on shard %d\n", line_number, fields[0], shard);
+            failed = 1;
         }
     }
     
-    if (student_index == -1) {
-        printf("Error: Student not found!\n");
-        log_operation(LOG_ERROR, "Enrollment", "Student not found");
-        return 0;
+    if (failed) {
+        coordinator.catalog_diverged = 1;
+        fprintf(session_errors(), "line %d: add-course: course %d is missing on some shards; "
+                "catalog changes are disabled\n", line_number, course_id);
+        log_operationf(LOG_ERROR, LOG_OP_SERVER, "Course %d added on only some shards", course_id);
     }
+    pthread_mutex_unlock(&coordinator.catalog_lock);
+    return !failed;
+}
+
+/**
+ * Send a command to every shard on behalf of a client command and collect
+ * each reply as text, so partial aggregates can be merged. replies[shard] is NULL for a shard whose reply
+ * was ERR; the caller frees the texts. Returns 0 if a shard is unreachable
+ * or a reply could not be stored.
+ */
+int coordinate_gather(const char *command, char **fields, int field_count, int line_number,
+                      char **replies) {
+    int sent[MAX_SHARDS];
+    int ok = 1;
     
-    /* Validate course exists */
-    int course_index = -1;
-    for (int i = 0; i < course_count; i++) {
-        if (courses[i].course_id == course_id) {
-            course_index = i;
-            break;
+    /* All requests go out before any reply is read, so the shards work in parallel */
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        sent[shard] = shard_send(shard, fields, field_count);
+    }
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        size_t size;
+        replies[shard] = NULL;
+        FILE *sink = open_memstream(&replies[shard], &size);
+        /* Without a sink the reply is still read, so the link stays in step */
+        int reply = sent[shard] ? shard_reply(shard, sink) : -1;
+        if (sink) fclose(sink);
+        if (reply != 1 || !sink) {
+            free(replies[shard]);
+            replies[shard] = NULL;
+        }
+        if (reply == -1) {
+            ok = shard_unavailable(line_number, command, shard);
+        } else if (!sink) {
+            fprintf(session_errors(), "line %d: %s: out of memory\n", line_number, command);
+            ok = 0;
         }
     }
-    
-    if (course_index == -1) {
-        printf("Error: Course not found!\n");
-        log_operation(LOG_ERROR, "Enrollment", "Course not found");
+    return ok;
+}
+
+/**
+ * System statistics over every shard. Counts and grade points add up;
+ * the enrollment rate is recomputed from each course's seats summed over
+ * the shards, since per-shard rates do not average to the overall rate.
+ */
+int coordinate_statistics(int line_number) {
+    char *partial[] = { "partial", "stats" };
+    char *replies[MAX_SHARDS] = { NULL };
+    if (!coordinate_gather("stats", partial, 2, line_number, replies)) {
+        for (int shard = 0; shard < coordinator.shard_count; shard++) free(replies[shard]);
         return 0;
     }
     
-    /* Check capacity */
-    if (courses[course_index].current_enrollment >= courses[course_index].max_capacity) {
-        printf("Error: Course is at maximum capacity!\n");
-        log_operation(LOG_ERROR, "Enrollment", "Course at maximum capacity");
-        return 0;
-    }
+    SystemStats merged;
+    memset(&merged, 0, sizeof(merged));
+    unsigned long long log_entries = 0;
+    SeatTotals *seats = NULL;
+    int seat_capacity = 0;
     
-    /* Check for duplicate enrollment */
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].student_id == student_id && 
-            enrollments[i].course_id == course_id && 
-            enrollments[i].status != 3) {
-            printf("Error: Student is already enrolled in this course!\n");
-            log_operation(LOG_WARNING, "Enrollment", "Duplicate enrollment attempt");
-            return 0;
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        char *save = NULL;
+        for (char *line = replies[shard] ? strtok_r(replies[shard], "\n", &save) : NULL; line;
+             line = strtok_r(NULL, "\n", &save)) {
+            int students, enrollments, completed, course_id, taken, held;
+            double credit_points;
+            unsigned long long logged;
+            if (sscanf(line, "totals %d %d %d %lf %llu", &students, &enrollments, &completed,
+                       &credit_points, &logged) == 5) {
+                merged.total_students += students;
+                merged.total_enrollments += enrollments;
+                merged.completed_enrollments += completed;
+                merged.total_credit_points += credit_points;
+                log_entries += logged;
+            } else if (sscanf(line, "seats %d %d %d", &course_id, &taken, &held) == 3 &&
+                       course_id >= FIRST_COURSE_ID) {
+                int course = course_id - FIRST_COURSE_ID;
+                if (course >= seat_capacity) {
+                    int grown = course >= seat_capacity * 2 ? course + 1 : seat_capacity * 2;
+                    SeatTotals *resized = realloc(seats, (size_t)grown * sizeof(SeatTotals));
+                    if (!resized) continue;
+                    memset(resized + seat_capacity, 0, (size_t)(grown - seat_capacity) * sizeof(SeatTotals));
+                    seats = resized;
+                    seat_capacity = grown;
+                }
+                seats[course].taken += taken;
+                seats[course].held += held;
+                if (course + 1 > merged.total_courses) merged.total_courses = course + 1;
+            }
         }
+        free(replies[shard]);
     }
     
-    enrollments[enrollment_count].enrollment_id = enrollment_count + 7001;
-    enrollments[enrollment_count].student_id = student_id;
-    enrollments[enrollment_count].course_id = course_id;
-    enrollments[enrollment_count].grade = 0.0f;
-    enrollments[enrollment_count].letter_grade = '-';
-    enrollments[enrollment_count].credit_points = 0.0f;
-    enrollments[enrollment_count].enrollment_date = time(NULL);
-    enrollments[enrollment_count].status = 0; /* pending */
-    
-    courses[course_index].current_enrollment++;
-    
-    printf("\n✓ Student successfully enrolled in course!\n");
-    printf("  Enrollment ID: %d\n", enrollments[enrollment_count].enrollment_id);
-    
-    char log_details[200];
-    sprintf(log_details, "Enrolled student %d in course %d", student_id, course_id);
-    log_operation(LOG_SUCCESS, "Enrollment", log_details);
+    for (int course = 0; course < merged.total_courses; course++) {
+        if (seats[course].held > 0) {
+            merged.enrollment_rate_sum += (double)seats[course].taken / seats[course].held;
+        }
+    }
+    free(seats);
+    merged.average_gpa = merged.completed_enrollments > 0
+        ? (float)(merged.total_credit_points / merged.completed_enrollments) : 0.0f;
+    merged.average_enrollment_rate = merged.total_courses > 0
+        ? (float)(merged.enrollment_rate_sum / merged.total_courses) : 0.0f;
     
-    enrollment_count++;
+    write_system_statistics(session_output(), &merged, log_entries);
     return 1;
 }
 
 /**
- * View student enrollments
+ * Class statistics of a course over every shard. Grade histograms add up
+ * bucket by bucket, so the merged median and percentiles are exact.
  */
-void view_student_enrollments(void) {
-    printf("Enter student ID: ");
-    int student_id;
-    scanf("%d", &student_id);
-    clear_input_buffer();
-    
-    /* Verify student exists */
-    int found_student = 0;
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].student_id == student_id) {
-            found_student = 1;
-            break;
-        }
+int coordinate_class_statistics(char *course_field, int line_number) {
+    char *partial[] = { "partial", "class", course_field };
+    char *replies[MAX_SHARDS] = { NULL };
+    int course_id;
+    if (!parse_int_field(course_field, &course_id)) {
+        return batch_usage(line_number, "class-stats course_id");
     }
-    
-    if (!found_student) {
-        printf("Student not found.\n");
-        return;
+    if (!coordinate_gather("class-stats", partial, 3, line_number, replies)) {
+        for (int shard = 0; shard < coordinator.shard_count; shard++) free(replies[shard]);
+        return 0;
     }
     
-    printf("\n");
-    print_separator('=', 100);
-    printf("%-6s %-25s %-10s %-10s %-8s %-15s\n", 
-           "Enr.ID", "Course Name", "Course Code", "Credits", "Grade", "Status");
-    print_separator('=', 100);
+    ClassSummary merged;
+    memset(&merged, 0, sizeof(merged));
+    char title[FILE_BUFFER_SIZE] = "";
+    int found = 0;
     
-    int enrolled = 0;
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].student_id == student_id) {
-            /* Find course name */
-            char course_name[MAX_NAME_LENGTH] = "Unknown";
-            char course_code[MAX_COURSE_CODE] = "Unknown";
-            int credits = 0;
-            
-            for (int j = 0; j < course_count; j++) {
-                if (courses[j].course_id == enrollments[i].course_id) {
-                    strcpy(course_name, courses[j].course_name);
-                    strcpy(course_code, courses[j].course_code);
-                    credits = courses[j].credits;
-                    break;
+    for (int shard = 0; shard < coordinator.shard_count; shard++) {
+        if (!replies[shard]) continue;
+        char *save = NULL;
+        for (char *line = strtok_r(replies[shard], "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+            ClassSummary part;
+            if (strncmp(line, "course ", 7) == 0) {
+                if (!found) copy_field(title, sizeof(title), line + 7);
+                found = 1;
+            } else if (sscanf(line, "grades %d %d %lf %f %f", &part.current_enrollment, &part.graded,
+                              &part.grade_sum, &part.grade_min, &part.grade_max) == 5) {
+                if (part.graded > 0) {
+                    if (merged.graded == 0 || part.grade_min < merged.grade_min) merged.grade_min = part.grade_min;
+                    if (merged.graded == 0 || part.grade_max > merged.grade_max) merged.grade_max = part.grade_max;
+                }
+                merged.current_enrollment += part.current_enrollment;
+                merged.graded += part.graded;
+                merged.grade_sum += part.grade_sum;
+            } else if (strncmp(line, "histogram", 9) == 0) {
+                char *cursor = line + 9;
+                for (int b = 0; b < GRADE_HISTOGRAM_BUCKETS; b++) {
+                    merged.histogram.buckets[b] += (int)strtol(cursor, &cursor, 10);
                 }
             }
-            
-            char status[20] = "Pending";
-            if (enrollments[i].status == 1) strcpy(status, "Active");
-            else if (enrollments[i].status == 2) strcpy(status, "Completed");
-            else if (enrollments[i].status == 3) strcpy(status, "Dropped");
-            
-            printf("%-6d %-25s %-10s %-10d %-8.1f %-15s\n",
-                   enrollments[i].enrollment_id,
-                   course_name,
-                   course_code,
-                   credits,
-                   enrollments[i].grade,
-                   status);
-            enrolled++;
         }
+        free(replies[shard]);
     }
     
-    print_separator('=', 100);
-    
-    if (enrolled == 0) {
-        printf("Student has no enrollments.\n");
-    } else {
-        printf("Total Enrollments: %d\n", enrolled);
+    if (!found) {
+        fprintf(session_output(), "Course not found.\n");
+        return 1;
     }
-    printf("\n");
+    char *name = strchr(title, '|');
+    if (name) *name++ = '\0';
+    write_class_statistics(session_output(), course_id, name ? name : "", title, &merged);
+    return 1;
 }
 
-/* ============================================================================
-   GRADE MANAGEMENT FUNCTIONS
-   ============================================================================ */
-
 /**
- * Record a grade for a student
+ * Coordinator command runner. Commands on one student or enrollment go to
+ * the shard owning its ID; new students are spread round robin; catalog
+ * changes and saves go to every shard; statistics are gathered from all.
  */
-int record_grade(void) {
-    printf("\n");
-    print_separator('=', 60);
-    printf("                   RECORD GRADE\n");
-    print_separator('=', 60);
-    
-    printf("Enter enrollment ID: ");
-    int enrollment_id;
-    scanf("%d", &enrollment_id);
-    
-    printf("Enter grade (0-100): ");
-    float grade;
-    scanf("%f", &grade);
+int coordinate_command(char **fields, int field_count, int line_number) {
+    static const char *const by_student[] = { "student", "gpa", "enrollments", "enroll", NULL };
+    static const char *const by_enrollment[] = { "grade", "assess", "assessments", "complete", "drop", NULL };
+    const char *command = fields[0];
     
-    clear_input_buffer();
+    if (strcmp(command, "add-student") == 0) {
+        unsigned int next = atomic_fetch_add(&coordinator.next_shard, 1);
+        return coordinate_forward((int)(next % (unsigned int)coordinator.shard_count), fields,
+                                  field_count, line_number);
+    }
+    for (int i = 0; by_student[i]; i++) {
+        if (strcmp(command, by_student[i]) == 0) {
+            int shard = field_count >= 2 ? shard_for_id(fields[1], FIRST_STUDENT_ID) : 0;
+            return coordinate_forward(shard, fields, field_count, line_number);
+        }
+    }
+    for (int i = 0; by_enrollment[i]; i++) {
+        if (strcmp(command, by_enrollment[i]) == 0) {
+            int shard = field_count >= 2 ? shard_for_id(fields[1], FIRST_ENROLLMENT_ID) : 0;
+            return coordinate_forward(shard, fields, field_count, line_number);
+        }
+    }
+    if (strcmp(command, "add-course") == 0) {
+        if (field_count != 7) {
+            return batch_usage(line_number, "add-course|code|name|description|credits|capacity|difficulty");
+        }
+        return coordinate_add_course(fields, field_count, line_number);
+    }
+    if (strcmp(command, "save") == 0 || strcmp(command, "archive") == 0) {
+        return coordinate_broadcast(fields, field_count, line_number);
+    }
+    if (strcmp(command, "stats") == 0 && field_count == 1) {
+        return coordinate_statistics(line_number);
+    }
+    if (strcmp(command, "class-stats") == 0) {
+        if (field_count != 2) return batch_usage(line_number, "class-stats course_id");
+        return coordinate_class_statistics(fields[1], line_number);
+    }
     
-    if (grade < MIN_GRADE || grade > MAX_GRADE) {
-        printf("Error: Grade must be between 0 and 100!\n");
-        log_operation(LOG_ERROR, "Record Grade", "Invalid grade value");
+    fprintf(session_errors(), "line %d: %s: not available through the shard coordinator\n",
+            line_number, command);
+    return 0;
+}
+
+/* ============================================================================
+   SERVER MODE
+   ============================================================================ */
+
+/**
+ * Hand an accepted connection to the workers. Returns 0 when the queue is full.
+ */
+int session_queue_push(int fd) {
+    pthread_mutex_lock(&session_queue.lock);
+    if (session_queue.count == SESSION_QUEUE_SIZE) {
+        pthread_mutex_unlock(&session_queue.lock);
         return 0;
     }
-    
-    /* Find enrollment */
-    int enrollment_index = -1;
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].enrollment_id == enrollment_id) {
-            enrollment_index = i;
-            break;
-        }
+    session_queue.fds[(session_queue.head + session_queue.count) % SESSION_QUEUE_SIZE] = fd;
+    session_queue.count++;
+    pthread_cond_signal(&session_queue.ready);
+    pthread_mutex_unlock(&session_queue.lock);
+    return 1;
+}
+
+/**
+ * Wait for the next connection and mark it active for worker. Returns -1
+ * once the server is closing and the queue has drained.
+ */
+int session_queue_pop(int worker) {
+    pthread_mutex_lock(&session_queue.lock);
+    while (session_queue.count == 0 && !session_queue.closing) {
+        pthread_cond_wait(&session_queue.ready, &session_queue.lock);
     }
-    
-    if (enrollment_index == -1) {
-        printf("Error: Enrollment not found!\n");
-        log_operation(LOG_ERROR, "Record Grade", "Enrollment not found");
+    int fd = -1;
+    if (session_queue.count > 0) {
+        fd = session_queue.fds[session_queue.head];
+        session_queue.head = (session_queue.head + 1) % SESSION_QUEUE_SIZE;
+        session_queue.count--;
+    }
+    session_queue.active_fds[worker] = fd;
+    pthread_mutex_unlock(&session_queue.lock);
+    return fd;
+}
+
+/**
+ * Serve one client: each line is a batch command, answered with its output
+ * followed by "OK" or "ERR". Blank and comment lines get no reply, and
+ * "quit" ends the session. Returns the number of commands run.
+ */
+long long run_session(int fd) {
+    int write_fd = dup(fd);
+    FILE *input = fdopen(fd, "r");
+    FILE *output = write_fd != -1 ? fdopen(write_fd, "w") : NULL;
+    if (!input || !output) {
+        if (input) fclose(input); else close(fd);
+        if (output) fclose(output); else if (write_fd != -1) close(write_fd);
+        log_operation(LOG_ERROR, LOG_OP_SERVER, "Failed to open session streams");
         return 0;
     }
     
-    enrollments[enrollment_index].grade = grade;
-    enrollments[enrollment_index].letter_grade = get_letter_grade(grade);
-    enrollments[enrollment_index].credit_points = get_gpa_from_grade(enrollments[enrollment_index].letter_grade);
-    enrollments[enrollment_index].status = 2; /* completed */
+    char line[FILE_BUFFER_SIZE];
+    char *fields[MAX_BATCH_FIELDS];
+    int line_number = 0;
+    long long commands = 0;
+    session_stream = output;
     
-    printf("\n✓ Grade recorded successfully!\n");
-    printf("  Enrollment ID: %d\n", enrollment_id);
-    printf("  Grade: %.2f (%c)\n", grade, enrollments[enrollment_index].letter_grade);
-    printf("  GPA Points: %.2f\n", enrollments[enrollment_index].credit_points);
+    while (fgets(line, sizeof(line), input)) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = 0;
+        
+        int field_count = split_batch_fields(line, fields, MAX_BATCH_FIELDS);
+        if (field_count == 0 || fields[0][0] == '#') continue;
+        if (strcmp(fields[0], "quit") == 0) break;
+        
+        commands++;
+        fputs(command_handler(fields, field_count, line_number) ? "OK\n" : "ERR\n", output);
+        if (fflush(output) != 0) break;
+    }
     
-    char log_details[200];
-    sprintf(log_details, "Recorded grade %.2f for enrollment %d", grade, enrollment_id);
-    log_operation(LOG_SUCCESS, "Record Grade", log_details);
+    session_stream = NULL;
+    fclose(output);
+    fclose(input);
+    return commands;
+}
+
+/**
+ * Server worker: serve queued connections until the server closes
+ */
+void *server_worker_main(void *arg) {
+    int worker = (int)(intptr_t)arg;
+    int fd;
     
-    return 1;
+    while ((fd = session_queue_pop(worker)) != -1) {
+        long long commands = run_session(fd);
+        pthread_mutex_lock(&session_queue.lock);
+        session_queue.active_fds[worker] = -1;
+        session_queue.sessions++;
+        session_queue.commands += commands;
+        pthread_mutex_unlock(&session_queue.lock);
+    }
+    return NULL;
+}
+
+void server_signal_handler(int signal_number) {
+    (void)signal_number;
+    server_stopping = 1;
 }
 
 /**
- * Calculate student GPA
+ * Accept clients on the loopback interface and serve them from a pool of
+ * worker threads until SIGINT or SIGTERM. Readers proceed in parallel;
+ * writers serialise only on the entities they touch. Returns 1 on a clean
+ * shutdown, 0 when the listener could not be opened.
  */
-void calculate_student_gpa(void) {
-    printf("Enter student ID: ");
-    int student_id;
-    scanf("%d", &student_id);
-    clear_input_buffer();
+int run_server(int port, int workers) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == -1) {
+        fprintf(stderr, "Error: Could not create server socket\n");
+        log_operation(LOG_ERROR, LOG_OP_SERVER, "Failed to create server socket");
+        return 0;
+    }
     
-    /* Verify student exists */
-    int student_index = -1;
-    for (int i = 0; i < student_count; i++) {
-        if (students[i].student_id == student_id) {
-            student_index = i;
-            break;
-        }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, server_bind_address, &address.sin_addr) != 1) {
+        fprintf(stderr, "Error: Invalid bind address '%s'\n", server_bind_address);
+        close(listener);
+        return 0;
+    }
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, SERVER_BACKLOG) != 0) {
+        fprintf(stderr, "Error: Could not listen on port %d: %s\n", port, strerror(errno));
+        log_operationf(LOG_ERROR, LOG_OP_SERVER, "Failed to listen on port %d", port);
+        close(listener);
+        return 0;
     }
     
-    if (student_index == -1) {
-        printf("Student not found.\n");
-        return;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = server_signal_handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    action.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &action, NULL);
+    
+    pthread_t threads[MAX_SERVER_WORKERS];
+    int started = 0;
+    for (int i = 0; i < MAX_SERVER_WORKERS; i++) session_queue.active_fds[i] = -1;
+    for (; started < workers; started++) {
+        if (pthread_create(&threads[started], NULL, server_worker_main,
+                           (void *)(intptr_t)started) != 0) break;
+    }
+    if (started == 0) {
+        fprintf(stderr, "Error: Could not start server workers\n");
+        close(listener);
+        return 0;
     }
     
-    float total_gpa = 0.0f;
-    int completed_courses = 0;
+    printf("Serving on %s:%d with %d workers (Ctrl+C to stop)\n", server_bind_address, port, started);
+    fflush(stdout);
+    log_operationf(LOG_INFO, LOG_OP_SERVER, "Listening on port %d with %d workers", port, started);
     
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].student_id == student_id && enrollments[i].status == 2) {
-            total_gpa += enrollments[i].credit_points;
-            completed_courses++;
+    /* Wake often enough that an idle server still honours the sync interval */
+    int poll_ms = journal.sync_interval_ms > 0 && journal.sync_interval_ms < SERVER_POLL_MS
+        ? journal.sync_interval_ms : SERVER_POLL_MS;
+    struct pollfd listen_poll = { listener, POLLIN, 0 };
+    double began = monotonic_seconds();
+    
+    while (!server_stopping) {
+        int ready = poll(&listen_poll, 1, poll_ms);
+        journal_sync();
+        if (ready <= 0) continue;
+        
+        int client = accept(listener, NULL, NULL);
+        if (client == -1) continue;
+        if (!session_queue_push(client)) {
+            const char busy[] = "ERR server busy\n";
+            if (write(client, busy, sizeof(busy) - 1) < 0) { /* client is dropped either way */ }
+            close(client);
+            log_operation(LOG_WARNING, LOG_OP_SERVER, "Session queue full; connection refused");
         }
     }
     
-    printf("\n");
-    print_separator('=', 60);
-    printf("                    STUDENT GPA\n");
-    print_separator('=', 60);
-    printf("Student: %s\n", students[student_index].name);
-    printf("Student ID: %d\n", student_id);
-    printf("Completed Courses: %d\n", completed_courses);
-    
-    if (completed_courses > 0) {
-        float gpa = total_gpa / completed_courses;
-        printf("GPA: %.2f\n", gpa);
-    } else {
-        printf("GPA: N/A (No completed courses)\n");
+    /* Stop accepting, then end the sessions in progress; queued ones see EOF at once */
+    close(listener);
+    pthread_mutex_lock(&session_queue.lock);
+    session_queue.closing = 1;
+    for (int i = 0; i < started; i++) {
+        if (session_queue.active_fds[i] != -1) shutdown(session_queue.active_fds[i], SHUT_RD);
     }
+    for (int i = 0; i < session_queue.count; i++) {
+        shutdown(session_queue.fds[(session_queue.head + i) % SESSION_QUEUE_SIZE], SHUT_RD);
+    }
+    pthread_cond_broadcast(&session_queue.ready);
+    pthread_mutex_unlock(&session_queue.lock);
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    journal_sync();
     
-    print_separator('=', 60);
-    printf("\n");
+    double elapsed = monotonic_seconds() - began;
+    printf("\nServer stopped: %lld sessions, %lld commands in %.1f s\n",
+           session_queue.sessions, session_queue.commands, elapsed);
+    log_operationf(LOG_INFO, LOG_OP_SERVER, "Served %lld sessions and %lld commands",
+                   session_queue.sessions, session_queue.commands);
+    return 1;
 }
 
 /* ============================================================================
-   ANALYTICS AND REPORTING FUNCTIONS
+   BENCHMARK MODE
    ============================================================================ */
 
 /**
- * Display system statistics
+ * xorshift64* generator; a fixed seed keeps benchmark runs comparable
  */
-void display_system_statistics(void) {
-    printf("\n");
-    print_separator('=', 80);
-    printf("                      SYSTEM STATISTICS\n");
-    print_separator('=', 80);
-    
-    printf("Total Students (Active):    %d\n", student_count);
-    printf("Total Courses:              %d\n", course_count);
-    printf("Total Enrollments:          %d\n", enrollment_count);
-    printf("Total Log Entries:          %d\n", log_entry_count);
-    
-    /* Calculate average GPA */
-    float total_gpa = 0.0f;
-    int completed_enrollments = 0;
-    
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].status == 2) {
-            total_gpa += enrollments[i].credit_points;
-            completed_enrollments++;
-        }
+uint64_t bench_random(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+int bench_timer_start(BenchTimer *timer, const char *name, int operations) {
+    memset(timer, 0, sizeof(*timer));
+    timer->name = name;
+    timer->operations = operations;
+    timer->latencies_ns = malloc((size_t)(operations > 0 ? operations : 1) * sizeof(uint64_t));
+    if (!timer->latencies_ns) {
+        printf("Error: Could not allocate benchmark timings!\n");
+        return 0;
     }
+    timer->started_ns = monotonic_ns();
+    return 1;
+}
+
+/**
+ * Record one call that began at started_ns
+ */
+void bench_record(BenchTimer *timer, uint64_t started_ns, int ok) {
+    timer->latencies_ns[timer->recorded++] = monotonic_ns() - started_ns;
+    if (!ok) timer->failed++;
+}
+
+int compare_latency(const void *a, const void *b) {
+    uint64_t left = *(const uint64_t *)a, right = *(const uint64_t *)b;
+    return left < right ? -1 : left > right;
+}
+
+/**
+ * Nearest-rank percentile of sorted latencies, in microseconds
+ */
+double bench_percentile_us(const uint64_t *sorted, int count, double percent) {
+    int rank = (int)ceil(count * percent / 100.0);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1] / 1000.0;
+}
+
+/**
+ * Print one result row and release the timings
+ */
+void bench_report(BenchTimer *timer) {
+    double seconds = (monotonic_ns() - timer->started_ns) / 1e9;
+    int count = timer->recorded;
     
-    if (completed_enrollments > 0) {
-        printf("Average GPA (System):       %.2f\n", total_gpa / completed_enrollments);
+    qsort(timer->latencies_ns, count, sizeof(uint64_t), compare_latency);
+    printf("%-14s %10d %8d %12.0f", timer->name, count, timer->failed,
+           seconds > 0 ? count / seconds : 0.0);
+    if (count > 0) {
+        printf(" %9.2f %9.2f %9.2f %9.2f %10.2f\n",
+               bench_percentile_us(timer->latencies_ns, count, 50),
+               bench_percentile_us(timer->latencies_ns, count, 90),
+               bench_percentile_us(timer->latencies_ns, count, 99),
+               bench_percentile_us(timer->latencies_ns, count, 99.9),
+               timer->latencies_ns[count - 1] / 1000.0);
+    } else {
+        printf("\n");
     }
-    
-    /* Calculate average enrollment rate */
-    float total_enrollment_rate = 0.0f;
-    for (int i = 0; i < course_count; i++) {
-        if (courses[i].max_capacity > 0) {
-            total_enrollment_rate += (float)courses[i].current_enrollment / courses[i].max_capacity;
-        }
+    free(timer->latencies_ns);
+    timer->latencies_ns = NULL;
+}
+
+/**
+ * Synthetic student name built from syllables, so name searches see a
+ * realistic spread of trigrams
+ */
+void bench_student_name(uint64_t *random, char *name, size_t size) {
+    static const char *first_names[] = {
+        "Aarav", "Bella", "Chen", "Diya", "Elena", "Farid", "Grace", "Hiro",
+        "Isha", "Jonas", "Kavya", "Liam", "Maya", "Nikhil", "Olga", "Priya"
+    };
+    static const char *syllables[] = {
+        "an", "ber", "cas", "dor", "el", "fin", "gar", "han",
+        "is", "jor", "kal", "lin", "mor", "nes", "ov", "par", "qui", "ros", "sen", "tal"
+    };
+    uint64_t r = bench_random(random);
+    const char *parts[3];
+    for (int i = 0; i < 3; i++) {
+        parts[i] = syllables[(r >> (8 + 8 * i)) % (sizeof(syllables) / sizeof(syllables[0]))];
     }
+    snprintf(name, size, "%s %c%s%s%s", first_names[r % 16], toupper((unsigned char)parts[0][0]),
+             parts[0] + 1, parts[1], parts[2]);
+}
+
+/**
+ * Add generated student number i called name. Returns 1 on success.
+ */
+int bench_add_student(int i, const char *name) {
+    static const char *majors[] = { "CS", "Math", "Physics", "Biology", "History", "Economics" };
+    int index = reserve_student();
+    if (index == -1) return 0;
     
-    if (course_count > 0) {
-        printf("Average Enrollment Rate:    %.1f%%\n", (total_enrollment_rate / course_count) * 100);
-    }
+    StudentProfile *profile = student_profile_at(index);
+    copy_field(profile->name, sizeof(profile->name), name);
+    snprintf(profile->email, sizeof(profile->email), "s%d@bench.edu", i);
+    snprintf(profile->phone, sizeof(profile->phone), "555-%03d-%04d", i / 10000 % 1000, i % 10000);
+    copy_field(profile->address, sizeof(profile->address), "1 Campus Way");
+    profile->admission_year = 2020 + i % 5;
+    student_at(index)->major_id = intern_string(majors[i % 6]);
+    return commit_student(index) == RESULT_OK;
+}
+
+/**
+ * Add generated course number i with capacity seats. Returns 1 on success.
+ */
+int bench_add_course(int i, int capacity) {
+    char code[MAX_NAME_LENGTH];
+    int index = reserve_course();
+    if (index == -1) return 0;
     
-    print_separator('=', 80);
-    printf("\n");
+    Course *course = course_at(index);
+    CourseDetails *details = course_details_at(index);
+    snprintf(code, sizeof(code), "BEN%d", 100 + i);
+    course->code_id = intern_string(code);
+    snprintf(details->course_name, sizeof(details->course_name), "Benchmark Course %d", i);
+    copy_field(details->description, sizeof(details->description), "Generated course");
+    course->credits = 1 + i % 4;
+    course->max_capacity = capacity;
+    course->difficulty_level = 1.0f + i % 5;
+    return commit_course(index) == RESULT_OK;
 }
 
 /**
- * Generate class statistics
+ * Generate students, courses and enrollments in memory and time the record
+ * operations and reports on them. Nothing is loaded from or written to
+ * the snapshot or journal; report output goes to /dev/null.
+ * Returns 0 if the benchmark could not run.
  */
-void generate_class_statistics(void) {
-    printf("Enter course ID: ");
-    int course_id;
-    scanf("%d", &course_id);
-    clear_input_buffer();
+int run_benchmark(int students, int courses, int enrollments) {
+    uint64_t random = 0x9E3779B97F4A7C15ull;
+    char name[MAX_NAME_LENGTH];
+    BenchTimer timer;
     
-    /* Find course */
-    int course_index = -1;
-    for (int i = 0; i < course_count; i++) {
-        if (courses[i].course_id == course_id) {
-            course_index = i;
-            break;
-        }
+    FILE *sink = fopen("/dev/null", "w");
+    if (!sink) {
+        printf("Error: Could not open /dev/null for report output!\n");
+        return 0;
     }
+    session_stream = sink;
     
-    if (course_index == -1) {
-        printf("Course not found.\n");
-        return;
+    printf("Benchmark: %d students, %d courses, %d enrollments\n", students, courses, enrollments);
+    printf("%-14s %10s %8s %12s %9s %9s %9s %9s %10s\n", "Operation", "Calls", "Failed", "Ops/sec",
+           "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    write_separator(stdout, '-', 98);
+    
+    if (!bench_timer_start(&timer, "add-student", students)) return 0;
+    for (int i = 0; i < students; i++) {
+        bench_student_name(&random, name, sizeof(name));
+        uint64_t started = monotonic_ns();
+        bench_record(&timer, started, bench_add_student(i, name));
     }
+    bench_report(&timer);
     
-    float total_grade = 0.0f;
-    float highest_grade = 0.0f;
-    float lowest_grade = 100.0f;
-    int students_graded = 0;
+    /* Capacity leaves room for every enrollment, so none are waitlisted */
+    int capacity = enrollments / courses * 2 + 1;
+    if (!bench_timer_start(&timer, "add-course", courses)) return 0;
+    for (int i = 0; i < courses; i++) {
+        uint64_t started = monotonic_ns();
+        bench_record(&timer, started, bench_add_course(i, capacity));
+    }
+    bench_report(&timer);
     
-    for (int i = 0; i < enrollment_count; i++) {
-        if (enrollments[i].course_id == course_id && enrollments[i].status == 2) {
-            total_grade += enrollments[i].grade;
-            students_graded++;
-            
-            if (enrollments[i].grade > highest_grade) {
-                highest_grade = enrollments[i].grade;
-            }
-            if (enrollments[i].grade < lowest_grade) {
-                lowest_grade = enrollments[i].grade;
-            }
-        }
+    /* Random pairs: repeats exercise the duplicate check and are rejected */
+    if (!bench_timer_start(&timer, "enroll", enrollments)) return 0;
+    for (int i = 0; i < enrollments; i++) {
+        int student_id = student_id_base + (int)(bench_random(&random) % students);
+        int course_id = FIRST_COURSE_ID + (int)(bench_random(&random) % courses);
+        int enrollment_id;
+        uint64_t started = monotonic_ns();
+        int ok = create_enrollment(student_id, course_id, &enrollment_id) == RESULT_OK;
+        bench_record(&timer, started, ok);
     }
+    bench_report(&timer);
     
-    printf("\n");
-    print_separator('=', 70);
-    printf("                    CLASS STATISTICS\n");
-    print_separator('=', 70);
-    printf("Course: %s (%s)\n", courses[course_index].course_name, 
-           courses[course_index].course_code);
-    printf("Course ID: %d\n", course_id);
-    printf("Total Enrollment: %d\n", courses[course_index].current_enrollment);
-    printf("Students Graded: %d\n", students_graded);
-    
-    if (students_graded > 0) {
-        float average_grade = total_grade / students_graded;
-        printf("Average Grade: %.2f\n", average_grade);
-        printf("Highest Grade: %.2f\n", highest_grade);
-        printf("Lowest Grade: %.2f\n", lowest_grade);
-        printf("Grade Range: %.2f\n", highest_grade - lowest_grade);
-    } else {
-        printf("No grades recorded for this course.\n");
+    /* As many grades as enrollments, so some enrollments are regraded */
+    int enrolled = enrollment_count;
+    if (!bench_timer_start(&timer, "grade", enrolled)) return 0;
+    for (int i = 0; i < enrolled; i++) {
+        int enrollment_id = enrollment_id_base + (int)(bench_random(&random) % enrolled);
+        float grade = (bench_random(&random) % 1001) / 10.0f;
+        uint64_t started = monotonic_ns();
+        int ok = apply_grade(enrollment_id, grade) == RESULT_OK;
+        bench_record(&timer, started, ok);
     }
+    bench_report(&timer);
     
-    print_separator('=', 70);
-    printf("\n");
+    /* Queries are 3-5 character pieces of existing names; every fourth ignores case */
+    if (!bench_timer_start(&timer, "name-search", BENCH_SEARCH_QUERIES)) return 0;
+    for (int i = 0; i < BENCH_SEARCH_QUERIES; i++) {
+        const char *source = student_profile_at((int)(bench_random(&random) % students))->name;
+        int length = (int)strlen(source);
+        int query_length = 3 + (int)(bench_random(&random) % 3);
+        if (query_length > length) query_length = length;
+        int start = (int)(bench_random(&random) % (length - query_length + 1));
+        snprintf(name, sizeof(name), "%.*s", query_length, source + start);
+        
+        uint64_t started = monotonic_ns();
+        print_name_search(name, i % 4 == 3 ? SEARCH_IGNORE_CASE : 0, SEARCH_DEFAULT_LIMIT);
+        bench_record(&timer, started, 1);
+    }
+    bench_report(&timer);
+    
+    if (!bench_timer_start(&timer, "system-stats", BENCH_STATS_CALLS)) return 0;
+    for (int i = 0; i < BENCH_STATS_CALLS; i++) {
+        uint64_t started = monotonic_ns();
+        display_system_statistics();
+        bench_record(&timer, started, 1);
+    }
+    bench_report(&timer);
+    
+    char export_path[] = "/tmp/sms-bench-XXXXXX";
+    int export_fd = mkstemp(export_path);
+    if (export_fd == -1) {
+        printf("Error: Could not create a temporary export file!\n");
+        return 0;
+    }
+    close(export_fd);
+    struct stat export_info = { 0 };
+    if (!bench_timer_start(&timer, "export", BENCH_EXPORT_RUNS)) return 0;
+    for (int i = 0; i < BENCH_EXPORT_RUNS; i++) {
+        uint64_t started = monotonic_ns();
+        char export_date[32];
+        get_export_date_string(export_date, sizeof(export_date));
+        int ok = write_data_export(export_path, export_date);
+        bench_record(&timer, started, ok);
+    }
+    bench_report(&timer);
+    stat(export_path, &export_info);
+    unlink(export_path);
+    
+    write_separator(stdout, '-', 98);
+    printf("Arena: %.1f MB reserved; export: %.1f MB per run\n",
+           record_arena.bytes_reserved / 1048576.0, export_info.st_size / 1048576.0);
+    
+    session_stream = NULL;
+    fclose(sink);
+    return 1;
 }
 
-/* ============================================================================
-   LOG AND REPORTING FUNCTIONS
-   ============================================================================ */
+/**
+ * Move a thread's timings into a timer started for all of them
+ */
+void bench_timer_merge(BenchTimer *into, BenchTimer *from) {
+    memcpy(into->latencies_ns + into->recorded, from->latencies_ns,
+           (size_t)from->recorded * sizeof(uint64_t));
+    into->recorded += from->recorded;
+    into->failed += from->failed;
+    free(from->latencies_ns);
+    from->latencies_ns = NULL;
+}
 
 /**
- * Display system log
+ * Draw a course ID by Zipf popularity: rank 0, the first course, is hottest
  */
-void display_system_log(void) {
-    if (log_entry_count == 0) {
-        printf("No log entries.\n");
-        return;
+int storm_pick_course(StormWorker *worker) {
+    double u = (bench_random(&worker->random) >> 11) * 0x1.0p-53;
+    int low = 0, high = worker->courses - 1;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (worker->zipf_cdf[middle] < u) low = middle + 1;
+        else high = middle;
     }
+    return FIRST_COURSE_ID + low;
+}
+
+/**
+ * Storm thread: play this thread's students, each request a random one of
+ * them, until its operations are done
+ */
+void *storm_worker(void *arg) {
+    StormWorker *worker = arg;
+    session_stream = worker->sink;
+    pthread_barrier_wait(worker->start);
     
-    printf("\n");
-    print_separator('=', 120);
-    printf("%-6s %-12s %-20s %-20s %-50s\n", 
-           "ID", "Level", "Timestamp", "Operation", "Details");
-    print_separator('=', 120);
-    
-    for (int i = 0; i < log_entry_count; i++) {
-        char level_str[20];
-        switch (system_log[i].log_level) {
-            case LOG_INFO: strcpy(level_str, "INFO"); break;
-            case LOG_WARNING: strcpy(level_str, "WARNING"); break;
-            case LOG_ERROR: strcpy(level_str, "ERROR"); break;
-            case LOG_SUCCESS: strcpy(level_str, "SUCCESS"); break;
-            default: strcpy(level_str, "UNKNOWN"); break;
-        }
-        
-        char timestamp[50];
-        struct tm *tm_info = localtime(&system_log[i].timestamp);
-        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
+    for (int i = 0; i < worker->operations; i++) {
+        int roll = (int)(bench_random(&worker->random) % 100);
+        uint64_t started;
         
-        printf("%-6d %-12s %-20s %-20s %-50s\n",
-               system_log[i].log_id,
-               level_str,
-               timestamp,
-               system_log[i].operation,
-               system_log[i].details);
+        if (roll < STORM_STATS_PERCENT) {
+            int course_id = storm_pick_course(worker);
+            started = monotonic_ns();
+            print_class_statistics(course_id);
+            bench_record(&worker->timers[STORM_STATS], started, 1);
+        } else if (roll < STORM_STATS_PERCENT + STORM_GRADE_PERCENT && worker->seated > 0) {
+            int enrollment_id = worker->seated_ids[bench_random(&worker->random) % worker->seated];
+            float grade = (bench_random(&worker->random) % 1001) / 10.0f;
+            started = monotonic_ns();
+            int ok = apply_grade(enrollment_id, grade) == RESULT_OK;
+            bench_record(&worker->timers[STORM_GRADE], started, ok);
+        } else {
+            int student_id = student_id_base + worker->first_student +
+                             (int)(bench_random(&worker->random) % worker->students);
+            int course_id = storm_pick_course(worker);
+            int enrollment_id;
+            started = monotonic_ns();
+            int result = create_enrollment(student_id, course_id, &enrollment_id);
+            bench_record(&worker->timers[STORM_ENROLL], started,
+                         result == RESULT_OK || result == RESULT_WAITLISTED);
+            
+            if (result == RESULT_OK) worker->seated_ids[worker->seated++] = enrollment_id;
+            else if (result == RESULT_WAITLISTED) worker->waitlisted++;
+            else if (result == RESULT_ALREADY_ENROLLED) worker->duplicates++;
+            else worker->other_failures++;
+        }
     }
     
-    print_separator('=', 120);
-    printf("Total Log Entries: %d\n\n", log_entry_count);
+    session_stream = NULL;
+    return NULL;
 }
 
 /**
- * Export data to file
+ * Reproduce a registration peak in memory: threads of virtual students
+ * enroll concurrently into courses of Zipf-distributed popularity, with
+ * grades and class statistics reads interleaved. Seats are sized for
+ * uniform demand, so the hot courses fill and waitlist. Reports latency,
+ * capacity rejections and lock contention, and checks no course was
+ * over-booked. Returns 0 if the run failed or a course was over-booked.
  */
-void export_data_to_file(void) {
-    FILE *file = fopen("system_export.txt", "w");
-    if (!file) {
-        printf("Error: Could not create export file!\n");
-        log_operation(LOG_ERROR, "Export Data", "Failed to create file");
-        return;
+int run_storm(int students, int courses, int threads) {
+    static const char *kind_names[STORM_KINDS] = { "enroll", "grade", "class-stats" };
+    uint64_t random = 0x9E3779B97F4A7C15ull;
+    char name[MAX_NAME_LENGTH];
+    if (threads > students) threads = students;
+    
+    printf("Registration storm: %d students, %d courses (Zipf s=%.1f), %d threads\n",
+           students, courses, STORM_ZIPF_EXPONENT, threads);
+    
+    int enroll_percent = 100 - STORM_GRADE_PERCENT - STORM_STATS_PERCENT;
+    long long expected = (long long)students * STORM_OPS_PER_STUDENT * enroll_percent / 100;
+    int capacity = expected / courses > 0 ? (int)(expected / courses) : 1;
+    double setup_started = monotonic_seconds();
+    for (int i = 0; i < students; i++) {
+        bench_student_name(&random, name, sizeof(name));
+        if (!bench_add_student(i, name)) {
+            printf("Error: Could not add storm students!\n");
+            return 0;
+        }
     }
+    for (int i = 0; i < courses; i++) {
+        if (!bench_add_course(i, capacity)) {
+            printf("Error: Could not add storm courses!\n");
+            return 0;
+        }
+    }
+    printf("Setup: %d seats per course, %.2f s\n", capacity, monotonic_seconds() - setup_started);
     
-    fprintf(file, "================== SYSTEM DATA EXPORT ==================\n");
-    fprintf(file, "Export Date: ");
+    double *zipf_cdf = malloc(sizeof(double) * courses);
+    StormWorker *workers = calloc(threads, sizeof(StormWorker));
+    if (!zipf_cdf || !workers) {
+        printf("Error: Out of memory!\n");
+        return 0;
+    }
+    double total_weight = 0;
+    for (int rank = 0; rank < courses; rank++) {
+        total_weight += 1.0 / pow(rank + 1, STORM_ZIPF_EXPONENT);
+        zipf_cdf[rank] = total_weight;
+    }
+    for (int rank = 0; rank < courses; rank++) zipf_cdf[rank] /= total_weight;
+    zipf_cdf[courses - 1] = 1.0;
     
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    fprintf(file, "%s\n\n", asctime(tm_info));
+    pthread_barrier_t start;
+    pthread_barrier_init(&start, NULL, threads + 1);
+    int operations = 0;
+    for (int t = 0; t < threads; t++) {
+        StormWorker *worker = &workers[t];
+        worker->start = &start;
+        worker->zipf_cdf = zipf_cdf;
+        worker->courses = courses;
+        worker->first_student = (int)((long long)students * t / threads);
+        worker->students = (int)((long long)students * (t + 1) / threads) - worker->first_student;
+        worker->operations = worker->students * STORM_OPS_PER_STUDENT;
+        worker->random = random ^ (0xD1B54A32D192ED03ull * (t + 1));
+        worker->sink = fopen("/dev/null", "w");
+        worker->seated_ids = malloc(sizeof(int) * worker->operations);
+        if (!worker->sink || !worker->seated_ids) {
+            printf("Error: Could not set up storm thread %d!\n", t);
+            return 0;
+        }
+        for (int kind = 0; kind < STORM_KINDS; kind++) {
+            if (!bench_timer_start(&worker->timers[kind], kind_names[kind], worker->operations)) return 0;
+        }
+        operations += worker->operations;
+    }
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&workers[t].thread, NULL, storm_worker, &workers[t]) != 0) {
+            printf("Error: Could not start storm thread %d!\n", t);
+            return 0;
+        }
+    }
     
-    /* Export students */
-    fprintf(file, "\n============ STUDENTS ============\n");
-    fprintf(file, "Total Students: %d\n\n", student_count);
-    for (int i = 0; i < student_count; i++) {
-        fprintf(file, "ID: %d | Name: %s | Email: %s | Phone: %s | Major: %s\n",
-                students[i].student_id,
-                students[i].name,
-                students[i].email,
-                students[i].phone,
-                students[i].major);
+    pthread_barrier_wait(&start);
+    uint64_t started_ns = monotonic_ns();
+    for (int t = 0; t < threads; t++) pthread_join(workers[t].thread, NULL);
+    double seconds = (monotonic_ns() - started_ns) / 1e9;
+    pthread_barrier_destroy(&start);
+    
+    printf("%-14s %10s %8s %12s %9s %9s %9s %9s %10s\n", "Operation", "Calls", "Failed", "Ops/sec",
+           "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    write_separator(stdout, '-', 98);
+    for (int kind = 0; kind < STORM_KINDS; kind++) {
+        BenchTimer timer;
+        if (!bench_timer_start(&timer, kind_names[kind], operations)) return 0;
+        for (int t = 0; t < threads; t++) bench_timer_merge(&timer, &workers[t].timers[kind]);
+        /* Throughput over the whole storm, not since the merge */
+        timer.started_ns = started_ns;
+        bench_report(&timer);
     }
+    write_separator(stdout, '-', 98);
     
-    /* Export courses */
-    fprintf(file, "\n============ COURSES ============\n");
-    fprintf(file, "Total Courses: %d\n\n", course_count);
-    for (int i = 0; i < course_count; i++) {
-        fprintf(file, "ID: %d | Code: %s | Name: %s | Credits: %d | Enrolled: %d/%d\n",
-                courses[i].course_id,
-                courses[i].course_code,
-                courses[i].course_name,
-                courses[i].credits,
-                courses[i].current_enrollment,
-                courses[i].max_capacity);
+    long long seated = 0, waitlisted = 0, duplicates = 0, other_failures = 0;
+    for (int t = 0; t < threads; t++) {
+        seated += workers[t].seated;
+        waitlisted += workers[t].waitlisted;
+        duplicates += workers[t].duplicates;
+        other_failures += workers[t].other_failures;
+        fclose(workers[t].sink);
+        free(workers[t].seated_ids);
     }
+    long long attempts = seated + waitlisted + duplicates + other_failures;
+    printf("Enrollments: %lld seated, %lld waitlisted (%.1f%% rejected at capacity), "
+           "%lld duplicates, %lld other failures\n", seated, waitlisted,
+           attempts ? 100.0 * waitlisted / attempts : 0.0, duplicates, other_failures);
     
-    /* Export enrollments */
-    fprintf(file, "\n============ ENROLLMENTS ============\n");
-    fprintf(file, "Total Enrollments: %d\n\n", enrollment_count);
-    for (int i = 0; i < enrollment_count; i++) {
-        fprintf(file, "Enrollment ID: %d | Student: %d | Course: %d | Grade: %.2f | Status: %d\n",
-                enrollments[i].enrollment_id,
-                enrollments[i].student_id,
-                enrollments[i].course_id,
-                enrollments[i].grade,
-                enrollments[i].status);
+    Course *hottest = course_at(lookup_course(FIRST_COURSE_ID));
+    printf("Hottest course %s: %d of %d seats taken, %d waitlisted\n", interned_text(hottest->code_id),
+           atomic_load(&hottest->current_enrollment), hottest->max_capacity,
+           atomic_load(&hottest->waitlist_count));
+    int over_booked = 0;
+    for (int i = 0; i < course_count; i++) {
+        if (atomic_load(&course_at(i)->current_enrollment) > course_at(i)->max_capacity) over_booked++;
     }
     
-    fprintf(file, "\n========== END OF EXPORT ==========\n");
+    uint64_t contention[CONTENTION_COUNT];
+    contention_collect(contention);
+    printf("Contention per 1000 operations:");
+    for (int counter = 0; counter < CONTENTION_COUNT; counter++) {
+        printf("  %s %.2f", contention_names[counter], contention[counter] * 1000.0 / operations);
+    }
+    printf("\n");
+    printf("Total: %d operations in %.3f s, %.0f ops/s; over-booked courses: %d\n",
+           operations, seconds, seconds > 0 ? operations / seconds : 0.0, over_booked);
     
-    fclose(file);
-    printf("✓ Data exported successfully to 'system_export.txt'\n");
-    log_operation(LOG_SUCCESS, "Export Data", "Data exported to file");
+    free(workers);
+    free(zipf_cdf);
+    return over_booked == 0;
 }
 
 /* ============================================================================
@@ -1086,31 +9763,236 @@ void display_main_menu(void) {
     printf("12. Display System Statistics\n");
     printf("13. Generate Class Statistics\n");
     printf("14. Display System Log\n");
-    printf("15. Export Data to File\n");
-    printf("16. Exit System\n");
+    printf("15. Query System Log\n");
+    printf("16. Export Data to File\n");
+    printf("17. Stream Export (CSV/JSON Lines)\n");
+    printf("18. Save Snapshot\n");
+    printf("19. Drop Enrollment\n");
+    printf("20. Term Report (All Students/Courses)\n");
+    printf("21. Operation Metrics\n");
+    printf("22. Record Assessment\n");
+    printf("23. Top Students by GPA\n");
+    printf("24. Courses Closest to Capacity\n");
+    printf("25. Students Sorted by Name\n");
+    printf("26. Archive Past Terms\n");
+    printf("27. Background Jobs\n");
+    printf("28. Exit System\n");
     printf("===============================\n");
-    printf("Enter your choice (1-16): ");
+    printf("Enter your choice (1-28): ");
+}
+
+/**
+ * Print command-line usage
+ */
+void print_usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--batch FILE | --serve PORT [--workers N] | --bench S,C,E | --storm S,C,T]\n"
+                    "       [--snapshot FILE] [--journal FILE] [--sync-interval MS] [--sync-records N]\n"
+                    "       [--export-buffer KB] [--log-file FILE] [--bind ADDR]\n"
+                    "       [--shard I/N | --coordinate HOST:PORT,...]\n", program);
+    fprintf(stderr, "  --batch FILE      run commands from FILE (- for stdin) without the menu\n");
+    fprintf(stderr, "  --serve PORT      accept batch commands over TCP on ADDR:PORT\n");
+    fprintf(stderr, "  --workers N       server worker threads, at most %d (default %d)\n",
+            MAX_SERVER_WORKERS, DEFAULT_SERVER_WORKERS);
+    fprintf(stderr, "  --bind ADDR       IPv4 address the server listens on (default %s)\n",
+            DEFAULT_BIND_ADDRESS);
+    fprintf(stderr, "  --shard I/N       run as shard I of N, owning IDs from %d*I upward of each\n"
+                    "                    record kind and 1/N of every course's seats\n", SHARD_ID_SPAN);
+    fprintf(stderr, "  --coordinate LIST route batch or server commands to the shards listed in\n"
+                    "                    shard order, keeping no records of its own (at most %d)\n",
+            MAX_SHARDS);
+    fprintf(stderr, "  --bench S,C,E     time record operations on S students, C courses and E\n"
+                    "                    enrollment attempts generated in memory\n");
+    fprintf(stderr, "  --storm S,C,T     registration storm: S virtual students on T threads enroll\n"
+                    "                    into C courses of Zipf popularity, in memory (T at most %d)\n",
+            STORM_MAX_THREADS);
+    fprintf(stderr, "  --snapshot FILE   snapshot loaded at startup and written by save (default %s)\n",
+            DEFAULT_SNAPSHOT_PATH);
+    fprintf(stderr, "  --journal FILE    write-ahead journal replayed after the snapshot (default %s)\n",
+            DEFAULT_JOURNAL_PATH);
+    fprintf(stderr, "  --sync-interval MS  longest time a journal record waits for fsync (default %d)\n",
+            DEFAULT_SYNC_INTERVAL_MS);
+    fprintf(stderr, "  --sync-records N    records per journal fsync (default %d)\n",
+            DEFAULT_SYNC_RECORDS);
+    fprintf(stderr, "  --export-buffer KB  write buffer for streaming export (default %d)\n",
+            DEFAULT_EXPORT_BUFFER_SIZE >> 10);
+    fprintf(stderr, "  --log-file FILE   log file written in the background, rotated at %d MB (default %s)\n",
+            LOG_ROTATE_BYTES >> 20, DEFAULT_LOG_PATH);
 }
 
 /**
  * Main program function
  */
-int main(void) {
+int main(int argc, char *argv[]) {
     int choice;
     int input_id;
+    const char *batch_path = NULL;
+    int export_kb;
+    int server_port = 0;
+    int server_workers = DEFAULT_SERVER_WORKERS;
+    int bench_students = 0, bench_courses = 0, bench_enrollments = 0;
+    int storm_students = 0, storm_courses = 0, storm_threads = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_path = argv[++i];
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc &&
+                   parse_int_field(argv[i + 1], &server_port) &&
+                   server_port > 0 && server_port <= 65535) {
+            i++;
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc &&
+                   parse_int_field(argv[i + 1], &server_workers) &&
+                   server_workers > 0 && server_workers <= MAX_SERVER_WORKERS) {
+            i++;
+        } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%d,%d,%d", &bench_students, &bench_courses,
+                          &bench_enrollments) == 3 &&
+                   bench_students > 0 && bench_courses > 0 && bench_enrollments >= 0) {
+            i++;
+        } else if (strcmp(argv[i], "--storm") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%d,%d,%d", &storm_students, &storm_courses,
+                          &storm_threads) == 3 && storm_students > 0 && storm_courses > 0 &&
+                   storm_threads > 0 && storm_threads <= STORM_MAX_THREADS) {
+            i++;
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--journal") == 0 && i + 1 < argc) {
+            journal_path = argv[++i];
+        } else if (strcmp(argv[i], "--sync-interval") == 0 && i + 1 < argc &&
+                   parse_int_field(argv[i + 1], &journal.sync_interval_ms) &&
+                   journal.sync_interval_ms >= 0) {
+            i++;
+        } else if (strcmp(argv[i], "--sync-records") == 0 && i + 1 < argc &&
+                   parse_int_field(argv[i + 1], &journal.sync_records) &&
+                   journal.sync_records > 0) {
+            i++;
+        } else if (strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            log_flusher.path = argv[++i];
+        } else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+            server_bind_address = argv[++i];
+        } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%d/%d", &shard_index, &shard_count) == 2 &&
+                   shard_count > 0 && shard_count <= MAX_SHARDS &&
+                   shard_index >= 0 && shard_index < shard_count) {
+            i++;
+        } else if (strcmp(argv[i], "--coordinate") == 0 && i + 1 < argc &&
+                   parse_shard_addresses(argv[i + 1])) {
+            i++;
+        } else if (strcmp(argv[i], "--export-buffer") == 0 && i + 1 < argc &&
+                   parse_int_field(argv[i + 1], &export_kb) && export_kb > 0) {
+            export_buffer_size = (size_t)export_kb << 10;
+            if (export_buffer_size < MIN_EXPORT_BUFFER_SIZE) export_buffer_size = MIN_EXPORT_BUFFER_SIZE;
+            i++;
+        } else {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    
+    if (coordinator.shard_count && shard_count > 1) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    student_id_base = FIRST_STUDENT_ID + shard_index * SHARD_ID_SPAN;
+    enrollment_id_base = FIRST_ENROLLMENT_ID + shard_index * SHARD_ID_SPAN;
+    next_enrollment_id = enrollment_id_base;
+    assessment_id_base = FIRST_ASSESSMENT_ID + shard_index * SHARD_ID_SPAN;
+    command_handler = run_batch_command;
+    
+    log_clock_init();
+    locks_init();
+    render_init();
+    
+    /* The coordinator holds no records, so it has no snapshot, journal or log file */
+    if (coordinator.shard_count) {
+        command_handler = coordinate_command;
+        signal(SIGPIPE, SIG_IGN);
+        if (batch_path) return run_batch(batch_path) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        if (server_port) return run_server(server_port, server_workers) ? EXIT_SUCCESS : EXIT_FAILURE;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    /* Benchmarks start from empty tables and leave no files behind */
+    if (bench_students) {
+        return run_benchmark(bench_students, bench_courses, bench_enrollments)
+            ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (storm_students) {
+        return run_storm(storm_students, storm_courses, storm_threads) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (!log_flusher_start()) {
+        printf("Warning: Could not open log file '%s'; the log is kept in memory only\n",
+               log_flusher.path);
+    }
+    
+    double load_started = monotonic_seconds();
+    int loaded = load_snapshot(snapshot_path);
+    if (loaded == 1) {
+        printf("Loaded snapshot '%s': %d students, %d courses, %d enrollments in %.1f ms\n",
+               snapshot_path, student_count, course_count, enrollment_count,
+               (monotonic_seconds() - load_started) * 1000);
+    } else if (loaded == -1) {
+        printf("Warning: Could not load snapshot '%s'; starting empty\n", snapshot_path);
+    } else if (loaded == -2) {
+        /* The failed load has already replaced part of the empty state */
+        fprintf(stderr, "Error: Snapshot '%s' is damaged; not starting\n", snapshot_path);
+        log_flusher_stop();
+        return EXIT_FAILURE;
+    }
+    
+    /* Journal records are replayed before the journal is opened, so they are not re-appended */
+    double replay_started = monotonic_seconds();
+    int replayed = loaded == -1 ? 0 : replay_journal(journal_path);
+    if (replayed > 0) {
+        printf("Replayed %d journal records from '%s' in %.1f ms\n",
+               replayed, journal_path, (monotonic_seconds() - replay_started) * 1000);
+    }
+    /* Records before the failing one are already applied and cannot be undone,
+       so running on would serve, and could save, a partial state */
+    if (replayed == -1) {
+        fprintf(stderr, "Error: Journal '%s' could not be replayed; not starting\n", journal_path);
+        log_flusher_stop();
+        return EXIT_FAILURE;
+    }
+    if (loaded == -1) {
+        printf("Warning: Journal '%s' not replayed; journaling disabled for this session\n",
+               journal_path);
+    } else if (!journal_open(journal_path)) {
+        printf("Warning: Could not open journal '%s'; changes will not be durable\n", journal_path);
+    }
+    
+    if (batch_path) {
+        log_operation(LOG_INFO, LOG_OP_SYSTEM_INIT, "System started in batch mode");
+        int failed = run_batch(batch_path);
+        background_wait(-1);
+        journal_close();
+        log_flusher_stop();
+        return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    
+    if (server_port) {
+        log_operation(LOG_INFO, LOG_OP_SYSTEM_INIT, "System started in server mode");
+        int served = run_server(server_port, server_workers);
+        background_wait(-1);
+        journal_close();
+        log_flusher_stop();
+        return served ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
     
     printf("\n");
     printf("**** INITIALIZING STUDENT MANAGEMENT SYSTEM ****\n");
-    log_operation(LOG_INFO, "System Init", "System started successfully");
+    log_operation(LOG_INFO, LOG_OP_SYSTEM_INIT, "System started successfully");
     printf("**** READY ****\n");
     
     while (1) {
+        /* Nothing is pending for long while waiting on the user */
+        journal_sync();
         display_main_menu();
         
         if (scanf("%d", &choice) != 1) {
             clear_input_buffer();
             printf("Invalid input. Please enter a number.\n");
-            log_operation(LOG_WARNING, "Menu", "Invalid input received");
+            log_operation(LOG_WARNING, LOG_OP_MENU, "Invalid input received");
             continue;
         }
         
@@ -1166,20 +10048,59 @@ int main(void) {
                 display_system_log();
                 break;
             case 15:
-                export_data_to_file();
+                query_system_log();
                 break;
             case 16:
+                export_data_to_file();
+                break;
+            case 17:
+                stream_export_interactive();
+                break;
+            case 18:
+                save_snapshot_interactive();
+                break;
+            case 19:
+                drop_student_enrollment();
+                break;
+            case 20:
+                term_report_interactive();
+                break;
+            case 21:
+                metrics_interactive();
+                break;
+            case 22:
+                record_assessment();
+                break;
+            case 23:
+                display_top_gpa();
+                break;
+            case 24:
+                display_course_fill();
+                break;
+            case 25:
+                display_students_by_name();
+                break;
+            case 26:
+                archive_interactive();
+                break;
+            case 27:
+                print_background_jobs();
+                break;
+            case 28:
+                background_wait(-1);
                 printf("\n");
                 print_separator('=', 70);
                 printf("Thank you for using Student Management System!\n");
                 printf("System shutting down...\n");
-                log_operation(LOG_INFO, "System Shutdown", "System exited normally");
+                log_operation(LOG_INFO, LOG_OP_SYSTEM_SHUTDOWN, "System exited normally");
                 print_separator('=', 70);
                 printf("\n");
+                journal_close();
+                log_flusher_stop();
                 return EXIT_SUCCESS;
             default:
-                printf("Invalid choice! Please select a valid option (1-16).\n");
-                log_operation(LOG_WARNING, "Menu", "Invalid choice selected");
+                printf("Invalid choice! Please select a valid option (1-28).\n");
+                log_operation(LOG_WARNING, LOG_OP_MENU, "Invalid choice selected");
         }
     }
     